@@ -48,6 +48,14 @@ struct LoadResult {
     int channels = 0;
     bool isPureColor = false;
     uint32_t pureColorValue = 0;
+    // Set instead of data for palette tiles, which stay indexed until blit
+    std::shared_ptr<const PaletteImage> palette;
+    // Set instead of data for BC1/BC3 tiles, which are passed on compressed
+    std::shared_ptr<const BlockImage> blocks;
+    // Set instead of data for tiles stored with 3 or 1 channels
+    std::shared_ptr<const ChannelImage> reduced;
+    // Set instead of data for tiles stored as per-row color runs
+    std::shared_ptr<const RleImage> rle;
     std::string error;
 };
 
@@ -146,6 +154,8 @@ private:
     
     LoadResult loadImageTile(const std::string& filePath);
     
+    static LoadResult makeCachedResult(const std::string& tileId, const CachedTile& tile);
+    
     LoadResult createPureColorTile(const std::string& tileId, uint32_t color, int width, int height);
     
     void notifyCallbacks(const LoadResult& result);
@@ -0,0 +1,84 @@
+#ifndef ATLASPACKER_HPP
+#define ATLASPACKER_HPP
+
+#include <vector>
+
+/**
+ * @brief 图集矩形装箱器（skyline bottom-left）
+ *
+ * 把许多小矩形放入固定尺寸的图集页中。每页维护一条"天际线"，新矩形放在
+ * 使其底边最低的位置（同高时取最左）。矩形按高度降序放入，放不下时开启
+ * 新页，已满的页不再回头尝试，装箱时间与矩形数量成线性关系。
+ */
+class AtlasPacker {
+   public:
+    /**
+     * @brief 矩形在图集中的位置
+     */
+    struct Placement {
+        int page;  ///< 图集页序号
+        int x;     ///< 页内左上角X坐标
+        int y;     ///< 页内左上角Y坐标
+    };
+
+    /**
+     * @brief 图集页实际使用的范围
+     */
+    struct PageExtent {
+        int width;   ///< 使用的宽度（最右矩形的右边界）
+        int height;  ///< 使用的高度（最低矩形的下边界）
+    };
+
+    /**
+     * @brief 构造函数
+     * @param pageWidth 图集页宽度
+     * @param pageHeight 图集页高度
+     */
+    AtlasPacker(int pageWidth, int pageHeight);
+
+    /**
+     * @brief 放置一组矩形
+     *
+     * 结果只取决于输入，与调用环境无关。超过页尺寸的矩形无法放置，
+     * 其位置的 page 为 -1。
+     *
+     * @param widths 各矩形宽度
+     * @param heights 各矩形高度
+     * @return 与输入一一对应的位置
+     */
+    std::vector<Placement> pack(const std::vector<int>& widths,
+                                const std::vector<int>& heights);
+
+    /**
+     * @brief 获取最近一次 pack 产生的各页使用范围
+     */
+    const std::vector<PageExtent>& getPageExtents() const { return extents_; }
+
+   private:
+    /**
+     * @brief 天际线的一段水平线
+     */
+    struct Segment {
+        int x;
+        int y;
+        int width;
+    };
+
+    /**
+     * @brief 在当前页中为矩形寻找位置
+     * @return 天际线中放置的起始段序号，放不下时返回 -1
+     */
+    int findPosition(int width, int height, int& bestX, int& bestY) const;
+
+    /**
+     * @brief 在天际线上放置矩形并合并等高的相邻段
+     */
+    void place(int index, int x, int y, int width, int height);
+
+    int pageWidth_;
+    int pageHeight_;
+    std::vector<Segment> skyline_;  ///< 当前页的天际线，按X坐标排列
+    std::vector<PageExtent> extents_;
+};
+
+#endif  // ATLASPACKER_HPP
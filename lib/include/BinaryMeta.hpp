@@ -0,0 +1,142 @@
+#ifndef BINARYMETA_HPP
+#define BINARYMETA_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TileCodec.hpp"
+#include "TileSplitter.hpp"
+
+/**
+ * @brief 二进制瓦片元数据（meta.bin），可直接映射使用，无需解析
+ *
+ * 文件布局（整数均为小端）：
+ *   文件头（64 字节）：8 字节魔数 "MFTMETA1"，uint32 版本，uint32 编码
+ *           （TileCodec::Type 的序号），int32 地图宽高（预先计算的
+ *           范围），int32 声明的地图宽高，uint32 LOD 级数 L，uint32
+ *           记录总数，uint64 字符串表偏移，uint64 字符串表长度，
+ *           8 字节保留
+ *   级别表：L + 1 项，每项为 uint32 首条记录序号、uint32 记录数；
+ *           第 0 项为原始分辨率瓦片，其后依次为各 LOD 级
+ *   记录区：每个瓦片 32 字节定长记录（见 Record），按级别连续存放
+ *   字符串表：瓦片文件名依次存放，不含结束符，相同的文件名只存一次
+ *
+ * 打开时只校验文件头和各区的范围，记录在映射内存中按需读取；记录按
+ * 小端布局直接访问，因此只在小端主机上打开。不支持 mmap 的平台退化为
+ * 一次读入整个文件。
+ */
+class BinaryMeta {
+   public:
+    /**
+     * @brief 二进制元数据在瓦片目录中的默认文件名
+     */
+    static constexpr const char* kFileName = "meta.bin";
+
+    /**
+     * @brief 格式版本，布局变化时递增
+     */
+    static constexpr uint32_t kVersion = 1;
+
+    /**
+     * @brief 定长的瓦片记录，字段含义同 TileMeta
+     */
+    struct Record {
+        int32_t x;
+        int32_t y;
+        int32_t w;
+        int32_t h;
+        int32_t srcX;
+        int32_t srcY;
+        uint32_t nameOffset;  ///< 文件名在字符串表中的偏移
+        uint16_t nameLength;  ///< 文件名长度
+        uint8_t lod;          ///< LOD 级别，0 为原始分辨率
+        uint8_t err;          ///< 有损纯色瓦片的最大通道误差
+    };
+    static_assert(sizeof(Record) == 32, "Record must stay 32 bytes");
+
+    /**
+     * @brief 文件头中除记录外的信息
+     */
+    struct Info {
+        TileCodec::Type codec = TileCodec::Type::Png;
+        int mapWidth = 0;        ///< 地图范围（瓦片范围与声明尺寸的较大者）
+        int mapHeight = 0;
+        int declaredWidth = 0;   ///< 拆分时声明的地图尺寸
+        int declaredHeight = 0;
+        int lodLevels = 0;       ///< 原始分辨率之外的 LOD 级数
+    };
+
+    BinaryMeta() = default;
+    ~BinaryMeta();
+
+    BinaryMeta(const BinaryMeta&) = delete;
+    BinaryMeta& operator=(const BinaryMeta&) = delete;
+
+    /**
+     * @brief 判断文件是否以二进制元数据的魔数开头
+     */
+    static bool isBinaryMeta(const std::string& path);
+
+    /**
+     * @brief 映射并校验二进制元数据文件
+     *
+     * @param path 文件路径
+     * @return true 如果文件有效且版本受支持
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief 获取文件头信息
+     */
+    const Info& getInfo() const { return info_; }
+
+    /**
+     * @brief 获取某一级别的记录
+     *
+     * @param level 级别，0 为原始分辨率
+     * @param count 输出：记录数
+     * @return 第一条记录；级别不存在时 count 为 0
+     */
+    const Record* records(int level, size_t& count) const;
+
+    /**
+     * @brief 获取记录的文件名（指向映射内存）
+     */
+    const char* name(const Record& record) const {
+        return strings_ + record.nameOffset;
+    }
+
+    /**
+     * @brief 把记录转换为 TileMeta
+     */
+    TileMeta toTileMeta(const Record& record) const;
+
+    /**
+     * @brief 写出二进制元数据
+     *
+     * 先写入 "<path>.tmp" 再原子地重命名，正在映射旧文件的读取方不受影响。
+     *
+     * @param path 文件路径
+     * @param info 文件头信息，lodLevels 由 tiles 决定
+     * @param tiles 全部瓦片，按 lod 升序排列
+     * @return true 如果写出成功
+     */
+    static bool write(const std::string& path, const Info& info,
+                      const std::vector<TileMeta>& tiles);
+
+   private:
+    void close();
+
+    Info info_;
+    const unsigned char* data_ = nullptr;  ///< 整个文件（映射或读入）
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<unsigned char> buffer_;  ///< 无法映射时读入的文件
+    std::vector<uint32_t> levelFirst_;   ///< 各级别首条记录序号
+    std::vector<uint32_t> levelCount_;   ///< 各级别记录数
+    const Record* records_ = nullptr;
+    const char* strings_ = nullptr;
+};
+
+#endif  // BINARYMETA_HPP
@@ -7,9 +7,60 @@
  * @brief 颜色检查器类，用于检查图像区域的颜色一致性
  *
  * 提供检查指定区域是否具有统一颜色的功能，支持RGBA格式图像。
+ *
+ * 设置透明阈值后，alpha 不超过阈值的像素视为透明：透明像素之间不论
+ * RGB 都相等，与不透明像素都不相等；完全透明的区域统一报告为颜色 0。
  */
 class ColorChecker {
    public:
+    /**
+     * @brief 区域内每个通道的最小/最大值（按内存字节顺序 R、G、B、A）
+     *
+     * 用于自底向上构建四叉树：子区域的范围合并即得到父区域的范围，
+     * 区域是否颜色一致可以由范围和参考像素在 O(1) 内判断。
+     * 默认构造为空范围（lo > hi），与任何范围合并都不改变对方。
+     */
+    struct ColorRange {
+        uint8_t lo[4] = {255, 255, 255, 255};  ///< 各通道最小值
+        uint8_t hi[4] = {0, 0, 0, 0};          ///< 各通道最大值
+
+        /**
+         * @brief 合并另一个范围
+         * @param other 另一个区域的范围
+         */
+        void merge(const ColorRange& other) {
+            for (int c = 0; c < 4; ++c) {
+                if (other.lo[c] < lo[c]) lo[c] = other.lo[c];
+                if (other.hi[c] > hi[c]) hi[c] = other.hi[c];
+            }
+        }
+    };
+
+    /**
+     * @brief 区域内每个通道的像素值之和与平方和，用于有损合并的误差估计
+     */
+    struct ColorStats {
+        ColorRange range;             ///< 各通道最小/最大值
+        uint64_t sum[4] = {};         ///< 各通道像素值之和
+        uint64_t sumSquares[4] = {};  ///< 各通道像素值平方和
+        uint64_t count = 0;           ///< 像素数
+
+        /**
+         * @brief 各通道四舍五入的平均颜色（0xRRGGBBAA）
+         */
+        uint32_t meanColor() const;
+
+        /**
+         * @brief 用 color 代替区域内所有像素时的最大通道误差
+         */
+        int maxError(uint32_t color) const;
+
+        /**
+         * @brief 用 color 代替区域内所有像素时的均方误差（按通道平均）
+         */
+        double meanSquaredError(uint32_t color) const;
+    };
+
     /**
      * @brief 构造函数
      */
@@ -29,7 +80,7 @@ class ColorChecker {
      * @param y 检查区域左上角Y坐标
      * @param width 检查区域宽度
      * @param height 检查区域高度
-     * @param color 输出参数，如果区域颜色一致则返回该颜色
+     * @param color 输出参数，如果区域颜色一致则返回该颜色（透明区域为 0）
      * @return true 如果区域内所有像素颜色相同
      */
     bool isUniformColor(const unsigned char* imageData, int imageWidth, int x,
@@ -70,6 +121,94 @@ class ColorChecker {
      */
     bool colorsEqual(uint32_t color1, uint32_t color2) const;
 
+    /**
+     * @brief 计算区域内每个通道的最小/最大值
+     *
+     * @param imageData 图像数据指针（RGBA格式，4字节每像素）
+     * @param imageWidth 图像宽度（像素）
+     * @param x 区域左上角X坐标
+     * @param y 区域左上角Y坐标
+     * @param width 区域宽度
+     * @param height 区域高度
+     * @return 区域的颜色范围，区域为空时返回空范围
+     */
+    ColorRange computeRange(const unsigned char* imageData, int imageWidth,
+                            int x, int y, int width, int height) const;
+
+    /**
+     * @brief 计算区域的颜色统计（范围、各通道之和与平方和）
+     *
+     * @param imageData 图像数据指针（RGBA格式，4字节每像素）
+     * @param imageWidth 图像宽度（像素）
+     * @param x 区域左上角X坐标
+     * @param y 区域左上角Y坐标
+     * @param width 区域宽度
+     * @param height 区域高度
+     * @return 区域的颜色统计，区域为空时 count 为 0
+     */
+    static ColorStats computeStats(const unsigned char* imageData,
+                                   int imageWidth, int x, int y, int width,
+                                   int height);
+
+    /**
+     * @brief 计算区域内非透明像素（alpha 不为 0）的包围盒
+     *
+     * 逐行从两端查找非透明像素，不透明的行只需检查首尾像素。
+     *
+     * @param imageData 图像数据指针（RGBA格式，4字节每像素）
+     * @param imageWidth 图像宽度（像素）
+     * @param x 区域左上角X坐标
+     * @param y 区域左上角Y坐标
+     * @param width 区域宽度
+     * @param height 区域高度
+     * @param boundX 输出：包围盒左上角X坐标（与 x 同一坐标系）
+     * @param boundY 输出：包围盒左上角Y坐标
+     * @param boundWidth 输出：包围盒宽度
+     * @param boundHeight 输出：包围盒高度
+     * @return false 如果区域完全透明
+     */
+    static bool opaqueBounds(const unsigned char* imageData, int imageWidth,
+                             int x, int y, int width, int height, int& boundX,
+                             int& boundY, int& boundWidth, int& boundHeight);
+
+    /**
+     * @brief 根据颜色范围判断区域是否颜色一致
+     *
+     * 与 isUniformColor 使用相同的判定：区域内每个像素都与参考像素
+     * （区域左上角像素）在容差范围内，透明阈值的处理也相同。
+     *
+     * @param range 区域的颜色范围
+     * @param referenceColor 参考像素颜色（0xRRGGBBAA）
+     * @return true 如果区域颜色一致
+     */
+    bool isUniformRange(const ColorRange& range,
+                        uint32_t referenceColor) const;
+
+    /**
+     * @brief 设置透明阈值
+     *
+     * @param alpha alpha 不超过该值的像素视为透明，-1 为关闭（默认）
+     */
+    void setTransparentAlpha(int alpha) { transparentAlpha_ = alpha; }
+
+    /**
+     * @brief 获取透明阈值
+     *
+     * @return alpha 阈值，-1 表示关闭
+     */
+    int getTransparentAlpha() const { return transparentAlpha_; }
+
+    /**
+     * @brief 判断颜色是否按透明阈值视为透明
+     *
+     * @param color 颜色值（0xRRGGBBAA）
+     * @return true 如果启用了透明阈值且 alpha 不超过阈值
+     */
+    bool isTransparent(uint32_t color) const {
+        return transparentAlpha_ >= 0 &&
+               static_cast<int>(color & 0xFF) <= transparentAlpha_;
+    }
+
     /**
      * @brief 设置颜色比较容差
      *
@@ -84,6 +223,32 @@ class ColorChecker {
      */
     int getColorTolerance() const { return colorTolerance_; }
 
+    /**
+     * @brief 启用或禁用向量化扫描路径
+     *
+     * 默认启用；禁用后 isUniformColor 使用逐像素的标量实现，
+     * 主要用于基准测试和结果对照。
+     *
+     * @param enabled 是否启用 SIMD
+     */
+    void setSimdEnabled(bool enabled) { simdEnabled_ = enabled; }
+
+    /**
+     * @brief 查询是否启用向量化扫描路径
+     *
+     * @return true 如果启用 SIMD
+     */
+    bool isSimdEnabled() const { return simdEnabled_; }
+
+    /**
+     * @brief 获取当前CPU上可用的最高级向量化内核名称
+     *
+     * 宽度较小的区域即使支持 AVX2 也使用 SSE2 内核。
+     *
+     * @return "avx2"、"sse2" 或 "scalar"
+     */
+    static const char* simdKernelName();
+
    private:
     /**
      * @brief 颜色比较容差，用于处理轻微的颜色差异
@@ -91,6 +256,29 @@ class ColorChecker {
      */
     int colorTolerance_ = 0;
 
+    /**
+     * @brief 透明阈值，-1 表示关闭
+     */
+    int transparentAlpha_ = -1;
+
+    /**
+     * @brief 是否使用向量化扫描路径
+     */
+    bool simdEnabled_ = true;
+
+    /**
+     * @brief 逐像素标量实现，与 SIMD 路径结果一致
+     */
+    bool isUniformColorScalar(const unsigned char* imageData, int imageWidth,
+                              int x, int y, int width, int height,
+                              uint32_t color) const;
+
+    /**
+     * @brief 向量化实现：按容差与参考像素比较，不考虑透明阈值
+     */
+    bool matchesReference(const unsigned char* imageData, int imageWidth,
+                          int x, int y, int width, int height) const;
+
     /**
      * @brief 检查坐标是否在图像范围内
      *
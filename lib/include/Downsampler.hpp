@@ -0,0 +1,40 @@
+#ifndef DOWNSAMPLER_HPP
+#define DOWNSAMPLER_HPP
+
+#include <vector>
+
+/**
+ * @brief RGBA 图像 2×2 降采样，用于生成 LOD 瓦片
+ *
+ * 每个输出像素的 alpha 是对应 2×2 像素块 alpha 的平均值，RGB 是按 alpha
+ * 加权的平均值（均四舍五入），透明像素的 RGB 不会渗入边缘；块内全透明
+ * 时输出 (0, 0, 0, 0)。宽或高为奇数时最后一列/行的块只包含图像内的像素
+ * （等价于复制边缘像素）。
+ * x86 上使用 SSE2 内核，结果与标量实现逐字节一致。
+ * 多级降采样逐级调用 halve，第 L 级的缩小倍数为 2^L。
+ */
+class Downsampler {
+   public:
+    /**
+     * @brief 降采样后的尺寸
+     */
+    static int halfSize(int size) { return (size + 1) / 2; }
+
+    /**
+     * @brief 把图像缩小一半
+     *
+     * @param src 源图像数据（RGBA格式，行间无填充）
+     * @param width 源图像宽度
+     * @param height 源图像高度
+     * @param dst 输出图像（halfSize(width) * halfSize(height) * 4 字节）
+     */
+    static void halve(const unsigned char* src, int width, int height,
+                      std::vector<unsigned char>& dst);
+
+    /**
+     * @brief 启用或禁用 SIMD 内核（用于对比测试，默认启用）
+     */
+    static void setSimdEnabled(bool enabled);
+};
+
+#endif  // DOWNSAMPLER_HPP
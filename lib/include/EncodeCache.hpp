@@ -0,0 +1,83 @@
+#ifndef ENCODECACHE_HPP
+#define ENCODECACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TileCodec.hpp"
+
+/**
+ * @brief 按内容寻址的瓦片编码缓存（磁盘）
+ *
+ * 以瓦片像素（含尺寸）的 128 位哈希和编码类型为键保存编码结果。重新
+ * 拆分像素未变的地图时，即使四叉树形状在别处发生变化，内容相同的瓦片
+ * 也直接复用已编码的数据而不再编码。编码结果只由像素和编码类型决定，
+ * 其他拆分参数只影响瓦片划分，已体现在像素中，因此不参与键。
+ *
+ * 条目保存为 <dir>/v<版本>/<哈希前两位>/<哈希><扩展名>，先写临时文件
+ * 再改名，多个线程或进程可同时使用同一缓存目录。编码器输出发生变化时
+ * 提高 kFormatVersion，旧条目不再被读取。缓存不做淘汰，删除目录即清空。
+ */
+class EncodeCache {
+   public:
+    /// 编码器输出格式版本，参与条目路径
+    static constexpr int kFormatVersion = 1;
+
+    /**
+     * @brief 构造函数
+     * @param dir 缓存目录，不存在时在首次写入时创建
+     */
+    explicit EncodeCache(std::string dir);
+
+    /**
+     * @brief 读取缓存的编码结果
+     *
+     * @param key 瓦片内容哈希
+     * @param codec 编码类型
+     * @param out 输出：编码后的数据（覆盖）
+     * @return true 如果命中
+     */
+    bool load(const std::pair<uint64_t, uint64_t>& key, TileCodec::Type codec,
+              std::vector<unsigned char>& out);
+
+    /**
+     * @brief 保存编码结果；写入失败时忽略，不影响拆分
+     *
+     * @param key 瓦片内容哈希
+     * @param codec 编码类型
+     * @param data 编码后的数据
+     */
+    void store(const std::pair<uint64_t, uint64_t>& key, TileCodec::Type codec,
+               const std::vector<unsigned char>& data);
+
+    /**
+     * @brief 获取缓存目录
+     */
+    const std::string& getDirectory() const { return dir_; }
+
+    /**
+     * @brief 获取命中次数
+     */
+    uint64_t getHits() const { return hits_.load(); }
+
+    /**
+     * @brief 获取未命中次数
+     */
+    uint64_t getMisses() const { return misses_.load(); }
+
+   private:
+    /**
+     * @brief 条目文件路径
+     */
+    std::string entryPath(const std::pair<uint64_t, uint64_t>& key,
+                          TileCodec::Type codec) const;
+
+    std::string dir_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+#endif  // ENCODECACHE_HPP
@@ -74,7 +74,16 @@ private:
     
     struct TileRenderData {
         std::string tileId;
-        std::vector<unsigned char> data;
+        // Decoded pixels, shared with the cache and with tiles of the same id
+        std::shared_ptr<const std::vector<unsigned char>> data;
+        // Palette tiles keep their indices and are expanded while blitting
+        std::shared_ptr<const PaletteImage> palette;
+        // BC1/BC3 tiles stay compressed and only the visible part is decoded
+        std::shared_ptr<const BlockImage> blocks;
+        // Opaque, gray and alpha-mask tiles keep 3 or 1 channels until blit
+        std::shared_ptr<const ChannelImage> reduced;
+        // Run tiles are composited run by run with fills
+        std::shared_ptr<const RleImage> rle;
         int width = 0;
         int height = 0;
         int channels = 0;
@@ -87,6 +96,22 @@ private:
               const unsigned char* src, int sw, int sh, int stride, int dstX,
               int dstY) const;
     
+    void blitPalette(std::vector<unsigned char>& canvas, int canvas_w,
+                     int canvas_h, const PaletteImage& image, int srcX,
+                     int srcY, int sw, int sh, int dstX, int dstY) const;
+    
+    void blitBlocks(std::vector<unsigned char>& canvas, int canvas_w,
+                    int canvas_h, const BlockImage& image, int srcX,
+                    int srcY, int sw, int sh, int dstX, int dstY) const;
+    
+    void blitChannels(std::vector<unsigned char>& canvas, int canvas_w,
+                      int canvas_h, const ChannelImage& image, int srcX,
+                      int srcY, int sw, int sh, int dstX, int dstY) const;
+    
+    void blitRle(std::vector<unsigned char>& canvas, int canvas_w,
+                 int canvas_h, const RleImage& image, int srcX, int srcY,
+                 int sw, int sh, int dstX, int dstY) const;
+    
     void blitSolidColor(std::vector<unsigned char>& canvas, int canvas_w,
                         int canvas_h, uint32_t color, int w, int h, int dstX,
                         int dstY) const;
@@ -98,6 +123,9 @@ private:
     std::vector<TileRenderData> loadTilesAsync(const std::vector<TileMeta>& tiles,
                                               const std::string& resourceDir);
     
+    std::vector<TileRenderData> loadTilesSync(const std::vector<TileMeta>& tiles,
+                                             const std::string& resourceDir);
+    
     void renderTilesOnCanvas(std::vector<unsigned char>& canvas, 
                             const Viewport& vp,
                             const std::vector<TileMeta>& tiles,
@@ -0,0 +1,49 @@
+#ifndef HILBERTCURVE_HPP
+#define HILBERTCURVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TileMeta;
+
+/**
+ * @brief 希尔伯特曲线排序，使空间上相邻的瓦片在元数据和打包文件中也相邻
+ *
+ * 希尔伯特曲线连续地遍历 2^k × 2^k 网格，曲线上相邻的点在平面上也相邻，
+ * 且任意对齐的 2^j 方块在曲线上是一段连续区间。视口内的瓦片因此落在
+ * 少数几段连续的记录中，读取接近顺序访问。
+ */
+class HilbertCurve {
+   public:
+    /**
+     * @brief 覆盖 width × height 所需的曲线阶数（网格边长为 2^order）
+     */
+    static int orderFor(int width, int height);
+
+    /**
+     * @brief 计算点在曲线上的序号
+     *
+     * @param x X坐标（小于 2^order）
+     * @param y Y坐标（小于 2^order）
+     * @param order 曲线阶数（不超过 31）
+     * @return 序号，范围 [0, 4^order)
+     */
+    static uint64_t index(uint32_t x, uint32_t y, int order);
+
+    /**
+     * @brief 计算瓦片按曲线排列的顺序
+     *
+     * 先按 LOD 级别（各级分别存放），同一级别内按瓦片左上角在曲线上的
+     * 序号排列；序号相同时保持原有顺序。
+     *
+     * @param tiles 瓦片元数据列表
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     * @return 排列后的第 k 个瓦片在 tiles 中的下标
+     */
+    static std::vector<size_t> sortedOrder(const std::vector<TileMeta>& tiles,
+                                           int imageWidth, int imageHeight);
+};
+
+#endif  // HILBERTCURVE_HPP
@@ -0,0 +1,62 @@
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+/**
+ * @brief 多个拆分任务共享的内存预算
+ *
+ * 批量拆分时，同时处理的各张地图的解码图像和编码中的瓦片缓冲都从同一
+ * 预算中占用，使进程的峰值内存与地图数量无关。预算为空（没有任何占用）
+ * 时单个超过预算的请求也会被满足；调用方还可以提供自身的占用计数，
+ * 计数为 0 时立即占用，保证每个调用方都能前进，不会因其他调用方长期
+ * 持有的占用（如解码图像）而互相等待。
+ */
+class MemoryBudget {
+   public:
+    /**
+     * @brief 构造函数
+     * @param limitBytes 预算上限（字节）
+     */
+    explicit MemoryBudget(size_t limitBytes) : limit_(limitBytes) {}
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    /**
+     * @brief 占用预算，超出上限时阻塞直到其他占用释放
+     *
+     * @param bytes 占用的字节数
+     * @param holderCount 可选：调用方自己尚未释放的占用数，为 0 时不等待
+     */
+    void acquire(size_t bytes,
+                 const std::atomic<size_t>* holderCount = nullptr);
+
+    /**
+     * @brief 释放之前占用的预算
+     * @param bytes 释放的字节数
+     */
+    void release(size_t bytes);
+
+    /**
+     * @brief 获取预算上限
+     */
+    size_t getLimit() const { return limit_; }
+
+    /**
+     * @brief 获取占用的峰值
+     */
+    size_t getPeak() const;
+
+   private:
+    const size_t limit_;
+    size_t used_ = 0;
+    size_t peak_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+};
+
+#endif  // MEMORYBUDGET_HPP
@@ -35,6 +35,13 @@ class QuadTreeNode {
      */
     void subdivide();
 
+    /**
+     * @brief 合并子节点，恢复为叶子节点
+     *
+     * 删除所有子节点。用于自底向上构建时父区域颜色一致的情况。
+     */
+    void merge();
+
     /**
      * @brief 检查是否为叶子节点
      * @return true 如果是叶子节点
@@ -95,6 +102,18 @@ class QuadTreeNode {
      */
     void setHasUniformColor(bool uniform) { hasUniformColor_ = uniform; }
 
+    /**
+     * @brief 获取统一颜色与区域像素的最大通道误差
+     * @return 误差值，颜色严格一致时为0（有损合并的叶子大于0）
+     */
+    int getColorError() const { return colorError_; }
+
+    /**
+     * @brief 设置统一颜色的最大通道误差
+     * @param error 误差值
+     */
+    void setColorError(int error) { colorError_ = error; }
+
     /**
      * @brief 获取子节点列表
      * @return 子节点向量的常引用
@@ -117,6 +136,7 @@ class QuadTreeNode {
     bool isLeaf_;            ///< 是否为叶子节点
     uint32_t uniformColor_;  ///< 统一颜色（RGBA格式）
     bool hasUniformColor_;   ///< 是否具有统一颜色
+    int colorError_;         ///< 统一颜色的最大通道误差
     std::vector<std::unique_ptr<QuadTreeNode>>
         children_;  ///< 子节点列表（非叶子节点有4个子节点）
 };
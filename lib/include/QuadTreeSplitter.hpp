@@ -1,11 +1,18 @@
 #ifndef QUADTREESPLITTER_HPP
 #define QUADTREESPLITTER_HPP
 
+#include <cstdint>
 #include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
 
 #include "ColorChecker.hpp"
 #include "QuadTreeNode.hpp"
+#include "SplitProfile.hpp"
+#include "TileCodec.hpp"
 #include "TileSplitter.hpp"
+#include "TileWriter.hpp"
 
 /**
  * @brief 四叉树分割器类，基于颜色一致性的地图分割
@@ -15,6 +22,75 @@
  */
 class QuadTreeSplitter : public TileSplitter {
    public:
+    /**
+     * @brief 四叉树构建算法
+     */
+    enum class BuildMode {
+        TopDown,  ///< 自顶向下：每层节点重新扫描其像素区域，O(N·depth)
+        Pyramid   ///< 自底向上：一次扫描得到颜色范围金字塔，节点判断 O(1)
+    };
+
+    /**
+     * @brief 分割代价模型：估计加载并绘制瓦片的耗时（微秒）
+     *
+     * 纯色瓦片只有每个瓦片的固定代价（被丢弃的透明瓦片没有代价）；
+     * 编码瓦片另有文件的固定代价、编码字节的读取代价和逐像素的解码
+     * 代价。编码字节按区域中非纯色叶子和纯色叶子的像素分别估计。
+     *
+     * 视口只加载与其相交的瓦片，瓦片越大，被加载的次数越多，读入的
+     * 可见范围外像素也越多。因此比较的是加载一个随机位置的
+     * viewportWidth x viewportHeight 视口的期望代价：每个瓦片的代价
+     * 乘以 viewportWeight。
+     *
+     * 默认权重为 PNG 单独文件在样例地图上的标定结果，其他编码和打包
+     * 输出见 forCodec；标定方法见 tests/performance_test.cpp 中的
+     * SplitCostCalibration。
+     */
+    struct CostModel {
+        double tileCost;   ///< 每个瓦片：元数据条目与绘制调用
+        double fileCost;   ///< 每个编码瓦片：打开文件与解码器初始化
+        double byteCost;   ///< 每个编码字节的读取代价
+        double pixelCost;  ///< 每个编码像素的解码代价
+        double busyBytesPerPixel;     ///< 非纯色像素的估计编码字节数
+        double uniformBytesPerPixel;  ///< 纯色像素的估计编码字节数
+        /// 宽或高超过该值的节点不合并
+        int maxTileSize;
+        int viewportWidth;   ///< 估计加载代价时假设的视口宽度
+        int viewportHeight;  ///< 估计加载代价时假设的视口高度
+
+        CostModel()
+            : tileCost(0.6),
+              fileCost(5.9),
+              byteCost(0.0002),
+              pixelCost(0.0089),
+              busyBytesPerPixel(1.27),
+              uniformBytesPerPixel(0.04),
+              maxTileSize(256),
+              viewportWidth(800),
+              viewportHeight(600) {}
+
+        /**
+         * @brief 获取编码的标定权重
+         *
+         * @param codec 瓦片编码
+         * @param packed 瓦片写入 tiles.pack：没有打开文件的代价，fileCost
+         *               只剩解码器初始化
+         */
+        static CostModel forCodec(TileCodec::Type codec, bool packed = false);
+
+        /**
+         * @brief 宽 width、高 height 的瓦片被随机位置的视口加载的相对次数
+         *
+         * 与瓦片相交的视口位置有 (viewportWidth + width) *
+         * (viewportHeight + height) 个，按单个像素的位置数归一化。
+         */
+        double viewportWeight(int width, int height) const {
+            return (static_cast<double>(viewportWidth) + width) *
+                   (static_cast<double>(viewportHeight) + height) /
+                   (static_cast<double>(viewportWidth) * viewportHeight);
+        }
+    };
+
     /**
      * @brief 四叉树分割配置参数
      */
@@ -22,12 +98,109 @@ class QuadTreeSplitter : public TileSplitter {
         int maxDepth;        ///< 最大分割深度
         int minTileSize;     ///< 最小瓦片尺寸（像素）
         int colorTolerance;  ///< 颜色比较容差
+        /// alpha 不超过该值的像素视为透明、彼此相等，完全透明的叶子不写入
+        /// 元数据；-1 为关闭
+        int transparentAlpha;
+        int numThreads;  ///< 构建与编码的线程数（1为串行，0为硬件并发数）
+        int serialSubtreePixels;  ///< 面积不超过该值的子树在单个任务内串行构建
+        BuildMode buildMode;      ///< 四叉树构建算法，两种算法结果一致
+        size_t maxInFlightBytes;  ///< 并发编码瓦片的内存预算（字节）
+        int stripHeight;          ///< 流式拆分时每次读入的行数
+        bool packOutput;  ///< 瓦片写入单个 tiles.pack 而非单独的文件
+        TileCodec::Type codec;  ///< 非纯色瓦片的编码
+        bool dedupContent;  ///< 内容相同的叶子瓦片共用一个文件
+        int atlasMaxTileSize;  ///< 宽高均不超过该值的叶子打包进图集页，0为关闭
+        int atlasPageSize;     ///< 图集页边长（像素）
+        bool trimTransparent;  ///< 瓦片裁剪到非透明像素的包围盒
+        int lodLevels;         ///< 生成的 LOD 级数（第L级缩小2^L倍），0为关闭
+        int lodTileSize;       ///< LOD 瓦片的最大边长（像素）
+        bool mergeUniform;  ///< 相邻的同色纯色叶子合并为更大的矩形
+        int lossyMaxError;  ///< 有损合并：平均色的最大通道误差上限，0为关闭
+        double lossyMinPsnr;  ///< 有损合并：平均色的 PSNR 下限（dB），0为关闭
+        int verbosity;  ///< 输出级别：0 仅错误，1 各阶段摘要，2 逐个纯色瓦片
+        SplitProfile* profile;  ///< 分阶段性能统计，为空时不统计
+        /// 共享线程池，非空时构建与编码都提交到该线程池并忽略 numThreads；
+        /// 调用方不能在该线程池的任务中执行拆分
+        ThreadPool* pool;
+        /// 共享内存预算，非空时代替 maxInFlightBytes
+        MemoryBudget* memoryBudget;
+        EncodeCache* encodeCache;  ///< 编码结果的磁盘缓存，为空时不使用
+        bool paletteTiles;  ///< 颜色数少的瓦片保存为调色板格式
+        /// PNG 编码下不透明、灰度和 alpha 遮罩瓦片只保存用到的通道
+        bool reduceChannels;
+        bool rleTiles;  ///< 同色段少的瓦片保存为行程编码
+        /// 元数据和编码任务（打包文件中的数据）按希尔伯特曲线排列；
+        /// 流式拆分只对元数据排序
+        bool hilbertOrder;
+        /// 颜色分割后按 costModel 自底向上合并子树：整个节点作为一个瓦片的
+        /// 估计视口加载代价不高于其子树各瓦片之和时合并为一个瓦片
+        bool costSplit;
+        /// costSplit 使用的代价模型；打包输出应使用
+        /// CostModel::forCodec(codec, true)
+        CostModel costModel;
 
-        Config() : maxDepth(8), minTileSize(4), colorTolerance(0) {}
+        Config()
+            : maxDepth(8),
+              minTileSize(4),
+              colorTolerance(0),
+              transparentAlpha(-1),
+              numThreads(1),
+              serialSubtreePixels(256 * 256),
+              buildMode(BuildMode::TopDown),
+              maxInFlightBytes(TileWriter::Config().maxInFlightBytes),
+              stripHeight(256),
+              packOutput(false),
+              codec(TileCodec::Type::Png),
+              dedupContent(false),
+              atlasMaxTileSize(0),
+              atlasPageSize(1024),
+              trimTransparent(false),
+              lodLevels(0),
+              lodTileSize(256),
+              mergeUniform(false),
+              lossyMaxError(0),
+              lossyMinPsnr(0.0),
+              verbosity(1),
+              profile(nullptr),
+              pool(nullptr),
+              memoryBudget(nullptr),
+              encodeCache(nullptr),
+              paletteTiles(false),
+              reduceChannels(false),
+              rleTiles(false),
+              hilbertOrder(false),
+              costSplit(false) {}
         Config(int depth, int minSize, int tolerance = 0)
             : maxDepth(depth),
               minTileSize(minSize),
-              colorTolerance(tolerance) {}
+              colorTolerance(tolerance),
+              transparentAlpha(-1),
+              numThreads(1),
+              serialSubtreePixels(256 * 256),
+              buildMode(BuildMode::TopDown),
+              maxInFlightBytes(TileWriter::Config().maxInFlightBytes),
+              stripHeight(256),
+              packOutput(false),
+              codec(TileCodec::Type::Png),
+              dedupContent(false),
+              atlasMaxTileSize(0),
+              atlasPageSize(1024),
+              trimTransparent(false),
+              lodLevels(0),
+              lodTileSize(256),
+              mergeUniform(false),
+              lossyMaxError(0),
+              lossyMinPsnr(0.0),
+              verbosity(1),
+              profile(nullptr),
+              pool(nullptr),
+              memoryBudget(nullptr),
+              encodeCache(nullptr),
+              paletteTiles(false),
+              reduceChannels(false),
+              rleTiles(false),
+              hilbertOrder(false),
+              costSplit(false) {}
     };
 
     /**
@@ -52,6 +225,53 @@ class QuadTreeSplitter : public TileSplitter {
                                         const std::string& outDir,
                                         const Config& config = Config{});
 
+    /**
+     * @brief 流式四叉树分割，适用于无法整体载入内存的超大地图
+     *
+     * 输入为原始 RGBA 图像（见 RawImageReader），按 config.stripHeight
+     * 行的条带读取两遍：第一遍统计形状终止节点的颜色范围并自底向上
+     * 构建四叉树，第二遍在瓦片的最后一行读入后立即编码写出。
+     * 像素缓冲峰值约为一个条带加上跨条带未完成的瓦片，
+     * 输出与 splitQuadTree 完全一致。
+     *
+     * @param inputPath 原始 RGBA 图像文件路径
+     * @param outDir 输出目录路径
+     * @param config 分割配置参数
+     * @return 生成的瓦片元数据列表
+     */
+    std::vector<TileMeta> splitQuadTreeStreaming(
+        const std::string& inputPath, const std::string& outDir,
+        const Config& config = Config{});
+
+    /**
+     * @brief 增量四叉树分割：只重新分割和编码内容变化的区域
+     *
+     * outDir 中需保留上一次增量分割的结果：previousMeta 和叶子哈希文件
+     * kLeafHashFileName。先在新图像上重新计算上次每个叶子的哈希；
+     * 节点的子树只取决于其区域内的像素，因此不与任何变化叶子相交的
+     * 节点沿用上次的子树和瓦片元数据，瓦片文件不重写。其余节点照常
+     * 分割，只编码新的叶子，不再被引用的旧瓦片文件被删除。
+     * 结果与完整分割一致。
+     *
+     * 叶子哈希文件缺失，或分割参数、图像尺寸与上次不同时退化为
+     * 完整分割。不支持打包输出和图集（需要整体重写），也不合并纯色
+     * 叶子（合并后的瓦片跨越多个叶子，无法按叶子沿用）。
+     *
+     * @param inputPath 输入图像文件路径
+     * @param outDir 输出目录路径（上次分割的输出目录）
+     * @param previousMeta 上次分割的元数据文件
+     * @param config 分割配置参数
+     * @return 生成的瓦片元数据列表
+     */
+    std::vector<TileMeta> splitQuadTreeIncremental(
+        const std::string& inputPath, const std::string& outDir,
+        const std::string& previousMeta, const Config& config = Config{});
+
+    /**
+     * @brief 增量分割在输出目录中保存叶子哈希的文件名
+     */
+    static constexpr const char* kLeafHashFileName = "leaf_hashes.txt";
+
     /**
      * @brief 兼容现有接口的分割方法
      *
@@ -96,36 +316,438 @@ class QuadTreeSplitter : public TileSplitter {
                        int currentDepth);
 
     /**
-     * @brief 收集叶子节点并生成瓦片
+     * @brief 对单个节点做颜色一致性判断，需要时四等分（不递归）
+     *
+     * 启用有损合并时，颜色不一致但平均色满足误差预算的节点也成为
+     * 纯色叶子，颜色取平均色并记录最大通道误差。
+     *
+     * @param node 当前节点
+     * @param imageData 图像数据指针
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     * @param config 分割配置
+     * @param currentDepth 当前深度
+     * @return true 如果节点被分割，需要继续处理其子节点
+     */
+    bool evaluateNode(QuadTreeNode* node, const unsigned char* imageData,
+                      int imageWidth, int imageHeight, const Config& config,
+                      int currentDepth);
+
+    /**
+     * @brief 是否启用有损合并
+     */
+    static bool isLossy(const Config& config) {
+        return config.lossyMaxError > 0 || config.lossyMinPsnr > 0.0;
+    }
+
+    /**
+     * @brief 判断区域能否用平均色表示而不超出误差预算
+     *
+     * 最大误差不小于通道范围的一半，先用范围排除明显超出预算的区域，
+     * 再统计各通道之和计算平均色和误差。
+     *
+     * @param imageData 图像数据指针
+     * @param imageWidth 图像宽度
+     * @param x 区域左上角X坐标
+     * @param y 区域左上角Y坐标
+     * @param width 区域宽度（已按图像边界裁剪）
+     * @param height 区域高度
+     * @param config 分割配置
+     * @param color 输出：平均色（0xRRGGBBAA）
+     * @param error 输出：平均色的最大通道误差
+     * @return true 如果满足 lossyMaxError 和 lossyMinPsnr 中启用的预算
+     */
+    bool fitsErrorBudget(const unsigned char* imageData, int imageWidth, int x,
+                         int y, int width, int height, const Config& config,
+                         uint32_t& color, int& error) const;
+
+    /**
+     * @brief 并行构建四叉树
+     *
+     * 上层节点按层级分波次作为任务提交到线程池，面积不超过
+     * config.serialSubtreePixels 的子树在单个任务内串行递归。
+     * 每个节点的判断只依赖图像数据，因此结果与串行构建完全一致。
+     *
+     * @param root 根节点
+     * @param imageData 图像数据指针
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     * @param config 分割配置
+     * @param numThreads 线程数
+     */
+    void subdivideParallel(QuadTreeNode* root, const unsigned char* imageData,
+                           int imageWidth, int imageHeight,
+                           const Config& config, int numThreads);
+
+    /**
+     * @brief 子树按代价模型的估计
+     */
+    struct SubtreeCost {
+        double cost = 0.0;           ///< 子树各瓦片的代价之和
+        uint64_t uniformPixels = 0;  ///< 纯色叶子（含图像外填充）的像素数
+        uint64_t busyPixels = 0;     ///< 非纯色叶子在图像内的像素数
+        size_t leaves = 0;           ///< 图像内的叶子数
+    };
+
+    /**
+     * @brief 按代价模型自底向上合并子树
+     *
+     * 只合并、不分割：颜色分割已把每个非纯色区域分到最小尺寸，更细的
+     * 瓦片只会增加每个瓦片的固定代价。节点作为单个编码瓦片的视口加载
+     * 代价不高于子节点代价之和时，合并子节点成为非纯色叶子；大瓦片按
+     * viewportWeight 计入读入的可见范围外像素，合并在代价不再下降的
+     * 尺寸停止，不会一直合并到 maxTileSize。每个节点的结果只取决于
+     * 其区域内的像素，与构建算法无关。
      *
      * @param node 当前节点
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     * @param config 分割配置
+     * @param merged 合并减少的叶子数（累加）
+     * @return 合并后子树的代价估计
+     */
+    SubtreeCost applyCostModel(QuadTreeNode* node, int imageWidth,
+                               int imageHeight, const Config& config,
+                               size_t& merged) const;
+
+    /**
+     * @brief 按代价模型估计加载一次区域编码成的单个瓦片的代价
+     */
+    static double encodedTileCost(const CostModel& model,
+                                  uint64_t uniformPixels, uint64_t busyPixels);
+
+    /**
+     * @brief 判断节点是否因尺寸或深度限制而不再分割（与颜色无关）
+     *
+     * @param node 当前节点
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     * @param config 分割配置
+     * @param currentDepth 当前深度
+     * @return true 如果节点必然是叶子节点
+     */
+    bool isTerminalShape(const QuadTreeNode* node, int imageWidth,
+                         int imageHeight, const Config& config,
+                         int currentDepth) const;
+
+    /**
+     * @brief 自底向上构建以 node 为根的子树
+     *
+     * 只在形状终止的节点上扫描像素得到颜色范围，内部节点合并子节点的
+     * 范围；若合并后的范围与左上角像素在容差内一致，则合并子节点为
+     * 纯色叶子。每个像素只被读取一次，结果与 subdivideNode 完全一致。
+     *
+     * @param node 当前节点
+     * @param imageData 图像数据指针
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     * @param config 分割配置
+     * @param currentDepth 当前深度
+     * @return 节点区域的颜色范围
+     */
+    ColorChecker::ColorRange buildPyramidNode(QuadTreeNode* node,
+                                              const unsigned char* imageData,
+                                              int imageWidth, int imageHeight,
+                                              const Config& config,
+                                              int currentDepth);
+
+    /**
+     * @brief 根据颜色范围确定节点是否为纯色叶子，是则合并其子节点
+     *
+     * @param node 当前节点
+     * @param range 节点区域的颜色范围
+     * @param referenceColor 节点左上角像素的颜色
+     */
+    void resolvePyramidNode(QuadTreeNode* node,
+                            const ColorChecker::ColorRange& range,
+                            uint32_t referenceColor);
+
+    /**
+     * @brief 并行自底向上构建四叉树
+     *
+     * 先按形状展开面积大于 config.serialSubtreePixels 的上层节点，
+     * 下层子树作为独立任务并行构建，最后在调用线程中自底向上合并上层。
+     *
+     * @param root 根节点
      * @param imageData 图像数据指针
      * @param imageWidth 图像宽度
      * @param imageHeight 图像高度
-     * @param outDir 输出目录
+     * @param config 分割配置
+     * @param numThreads 线程数
+     */
+    void buildPyramidParallel(QuadTreeNode* root,
+                              const unsigned char* imageData, int imageWidth,
+                              int imageHeight, const Config& config,
+                              int numThreads);
+
+    /**
+     * @brief 收集叶子节点的瓦片元数据和编码任务
+     *
+     * 纯色叶子只生成元数据；其余叶子按遍历顺序各生成一个编码任务，
+     * 由 TileWriter 统一并发编码写出。
+     *
+     * @param node 当前节点
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
      * @param tiles 瓦片元数据列表（输出）
+     * @param jobs 瓦片编码任务列表（输出）
+     */
+    void collectLeafTiles(const QuadTreeNode* node, int imageWidth,
+                          int imageHeight, std::vector<TileMeta>& tiles,
+                          std::vector<TileJob>& jobs);
+
+    /**
+     * @brief 启用透明裁剪：去掉完全透明的纯色瓦片，编码任务只写出
+     *        非透明像素的包围盒
+     *
+     * @param tiles 瓦片元数据列表（就地修改）
+     * @param jobs 瓦片编码任务列表（就地修改）
+     */
+    static void enableTrimming(std::vector<TileMeta>& tiles,
+                               std::vector<TileJob>& jobs);
+
+    /**
+     * @brief 去掉完全透明（alpha 为 0）的纯色瓦片
+     *
+     * @param tiles 瓦片元数据列表（就地修改）
+     */
+    static void removeTransparentTiles(std::vector<TileMeta>& tiles);
+
+    /**
+     * @brief 配置是否要求去掉完全透明的纯色瓦片（透明裁剪或透明阈值）
+     */
+    static bool dropsTransparent(const Config& config);
+
+    /**
+     * @brief 输出有损合并的统计：近似瓦片数、覆盖像素和最大误差
      */
-    void collectLeafTiles(const QuadTreeNode* node,
-                          const unsigned char* imageData, int imageWidth,
-                          int imageHeight, const std::string& outDir,
-                          std::vector<TileMeta>& tiles);
+    void reportLossyTiles(const std::vector<TileMeta>& tiles) const;
 
     /**
-     * @brief 生成单个瓦片文件（仅用于非纯色瓦片）
+     * @brief 把相邻的同色纯色瓦片合并为更大的矩形
      *
+     * 四叉树把纯色区域切成 2 的幂次方块，未对齐的大片纯色区域会变成
+     * 许多小瓦片。交替进行横向合并（同行同高、左右相接）和纵向合并
+     * （同列同宽、上下相接），直到没有可合并的瓦片。瓦片互不重叠且
+     * 颜色相同，绘制结果不变。非纯色瓦片保持原有顺序，合并后的纯色
+     * 瓦片按位置排在其后。
+     *
+     * @param tiles 瓦片元数据列表（就地修改）
+     */
+    void mergeUniformTiles(std::vector<TileMeta>& tiles) const;
+
+    /**
+     * @brief 叶子区域及其像素哈希（增量分割）
+     */
+    struct LeafHash {
+        int x;
+        int y;
+        int width;   ///< 节点宽度（未按图像边界裁剪）
+        int height;  ///< 节点高度
+        std::pair<uint64_t, uint64_t> hash;  ///< 图像内区域的像素哈希
+    };
+
+    /**
+     * @brief 增量构建：只分割与变化叶子相交的节点
+     *
+     * @param node 当前节点
      * @param imageData 图像数据指针
      * @param imageWidth 图像宽度
      * @param imageHeight 图像高度
-     * @param x 瓦片X坐标
-     * @param y 瓦片Y坐标
-     * @param width 瓦片宽度
-     * @param height 瓦片高度
-     * @param outputPath 输出文件路径
-     * @return 是否成功生成
+     * @param config 分割配置
+     * @param currentDepth 当前深度
+     * @param previous 上次的叶子（先序）
+     * @param dirty 与当前节点相交的变化叶子序号
+     * @param leafAt 左上角坐标（nodeKey）-> 上次叶子序号
+     * @param reused 沿用上次子树的节点 -> 其第一个叶子序号（输出）
+     */
+    void subdivideIncremental(
+        QuadTreeNode* node, const unsigned char* imageData, int imageWidth,
+        int imageHeight, const Config& config, int currentDepth,
+        const std::vector<LeafHash>& previous,
+        const std::vector<size_t>& dirty,
+        const std::unordered_map<uint64_t, size_t>& leafAt,
+        std::unordered_map<const QuadTreeNode*, size_t>& reused);
+
+    /**
+     * @brief 增量收集瓦片：沿用的子树复制上次的元数据和叶子哈希，
+     *        新叶子计算哈希并登记编码任务
+     *
+     * @param firstTile 上次每个叶子的第一个瓦片序号，末尾为瓦片总数
+     * @param tileJobs 每个瓦片的任务序号，无任务为 kNoJob（输出）
+     * @param leaves 新的叶子哈希（输出）
+     */
+    void collectIncremental(
+        const QuadTreeNode* node, const unsigned char* imageData,
+        int imageWidth, int imageHeight, const Config& config,
+        const std::vector<LeafHash>& previous,
+        const std::vector<TileMeta>& previousTiles,
+        const std::vector<size_t>& firstTile,
+        const std::unordered_map<const QuadTreeNode*, size_t>& reused,
+        std::vector<TileMeta>& tiles, std::vector<size_t>& tileJobs,
+        std::vector<TileJob>& jobs, std::vector<LeafHash>& leaves);
+
+    /**
+     * @brief 计算叶子在图像内区域的像素哈希
+     */
+    static std::pair<uint64_t, uint64_t> hashLeaf(
+        const unsigned char* imageData, int imageWidth, int imageHeight,
+        int x, int y, int width, int height);
+
+    /**
+     * @brief 节点左上角坐标组成的查找键
+     */
+    static uint64_t nodeKey(int x, int y) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 |
+               static_cast<uint32_t>(y);
+    }
+
+    /**
+     * @brief 判断瓦片或叶子是否位于节点区域内
+     */
+    static bool contains(const LeafHash& leaf, const TileMeta& tile);
+    static bool contains(const LeafHash& node, const LeafHash& leaf);
+
+    /**
+     * @brief 按节点的划分方式从根节点向下查找包含点 (x, y) 的叶子
+     *
+     * 上次的瓦片可能按希尔伯特曲线排列，借此把它们归入各自的叶子。
+     *
+     * @param leaves 上次的叶子列表
+     * @param leafAt 叶子左上角 -> 叶子序号
+     * @return 叶子序号，找不到时为 kNoJob
+     */
+    static size_t findLeaf(const std::vector<LeafHash>& leaves,
+                           const std::unordered_map<uint64_t, size_t>& leafAt,
+                           int imageWidth, int imageHeight, int x, int y);
+
+    /**
+     * @brief 生成叶子哈希文件中记录分割参数的行
+     */
+    static std::string describeConfig(const Config& config, int imageWidth,
+                                      int imageHeight);
+
+    /**
+     * @brief 读取叶子哈希文件
+     * @return false 如果文件缺失、格式错误或分割参数与 configLine 不同
+     */
+    static bool loadLeafHashes(const std::string& path,
+                               const std::string& configLine,
+                               std::vector<LeafHash>& leaves);
+
+    /**
+     * @brief 保存叶子哈希文件
+     */
+    static bool saveLeafHashes(const std::string& path,
+                               const std::string& configLine,
+                               const std::vector<LeafHash>& leaves);
+
+    /**
+     * @brief 瓦片不对应编码任务（纯色瓦片）
+     */
+    static constexpr size_t kNoJob = static_cast<size_t>(-1);
+
+    /**
+     * @brief 建立瓦片到编码任务的对应关系
+     *
+     * collectLeafTiles 生成的任务与非纯色瓦片按顺序一一对应。
+     *
+     * @param tiles 瓦片元数据列表
+     * @return 每个瓦片的任务序号，纯色瓦片为 kNoJob
+     */
+    static std::vector<size_t> mapTilesToJobs(
+        const std::vector<TileMeta>& tiles);
+
+    /**
+     * @brief 瓦片按希尔伯特曲线重新排列（见 HilbertCurve）
+     *
+     * 编码任务随之按首个引用它的瓦片排列，打包文件中的数据顺序与元数据
+     * 一致。
+     *
+     * @param tiles 瓦片元数据列表（就地修改）
+     * @param tileJobs 每个瓦片的任务序号（就地修改）
+     * @param jobs 瓦片编码任务列表（就地修改）
+     */
+    static void orderAlongHilbert(std::vector<TileMeta>& tiles,
+                                  std::vector<size_t>& tileJobs,
+                                  std::vector<TileJob>& jobs, int imageWidth,
+                                  int imageHeight);
+
+    /**
+     * @brief 只对元数据按希尔伯特曲线排序
+     *
+     * 用于流式拆分，以及裁剪移动了瓦片左上角之后按最终位置重新排序
+     * （使增量拆分与完整拆分的元数据一致）。
+     */
+    static void sortAlongHilbert(std::vector<TileMeta>& tiles, int imageWidth,
+                                 int imageHeight);
+
+    /**
+     * @brief 把小叶子打包进图集页
+     *
+     * 宽高均不超过 config.atlasMaxTileSize 的叶子按实际尺寸装入
+     * atlasPageSize 见方的图集页（见 AtlasPacker），这些叶子的编码任务
+     * 替换为图集页任务；元数据引用图集页文件并记录页内位置。
+     * 运行时一个图集页只需解码一次，即可绘制其中的所有叶子。
+     * 启用透明裁剪时叶子先裁剪到非透明包围盒再装箱。
+     *
+     * @param imageData 图像数据（RGBA格式）
+     * @param imageWidth 图像宽度
+     * @param config 分割配置
+     * @param tiles 瓦片元数据列表（就地修改）
+     * @param tileJobs 瓦片到编码任务的对应关系（就地修改）
+     * @param jobs 编码任务列表（就地修改）
+     */
+    void buildAtlasPages(const unsigned char* imageData, int imageWidth,
+                         const Config& config, std::vector<TileMeta>& tiles,
+                         std::vector<size_t>& tileJobs,
+                         std::vector<TileJob>& jobs) const;
+
+    /**
+     * @brief 为内部节点生成降采样的 LOD 瓦片
+     *
+     * 第 L 级（L = 1..config.lodLevels）从根向下，在边长首次不超过
+     * lodTileSize * 2^L 的节点（或更大的叶子）处截断，这些节点覆盖整个
+     * 地图；每个节点生成一个取自第 L 级降采样图像（见 Downsampler）的
+     * 瓦片，边长不超过 lodTileSize。元数据记录节点的地图区域和 lod=L。
+     *
+     * 降采样图像的每个像素对应一个 2^L 见方的块，块左上角所在的节点
+     * 拥有该像素，因此相邻瓦片不重叠，按级绘制的结果与整图降采样一致。
+     * 块完全位于节点内的纯色叶子只记录颜色，不生成文件。
+     *
+     * @param imageData 图像数据（RGBA格式）
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     * @param config 分割配置
+     * @param root 四叉树根节点
+     * @param tiles 瓦片元数据列表（追加）
+     * @param tileJobs 瓦片到编码任务的对应关系（追加）
+     * @param jobs 编码任务列表（追加）
+     */
+    void buildLodTiles(const unsigned char* imageData, int imageWidth,
+                       int imageHeight, const Config& config,
+                       const QuadTreeNode* root, std::vector<TileMeta>& tiles,
+                       std::vector<size_t>& tileJobs,
+                       std::vector<TileJob>& jobs) const;
+
+    /**
+     * @brief 由分割配置生成编码写出配置
+     */
+    static TileWriter::Config writerConfigFor(const Config& config);
+
+    /**
+     * @brief 应用编码写出结果：改用实际文件名和裁剪后的区域，
+     *        剔除写出失败或完全透明的瓦片
+     *
+     * @param tiles 瓦片元数据列表（就地修改）
+     * @param tileJobs 每个瓦片的任务序号，纯色瓦片为 kNoJob
+     * @param written 各编码任务是否成功
+     * @param outputs 各编码任务的写出结果
      */
-    bool generateTile(const unsigned char* imageData, int imageWidth,
-                      int imageHeight, int x, int y, int width, int height,
-                      const std::string& outputPath);
+    static void applyWriteResults(std::vector<TileMeta>& tiles,
+                                  const std::vector<size_t>& tileJobs,
+                                  const std::vector<bool>& written,
+                                  const std::vector<TileOutput>& outputs);
 
     /**
      * @brief 确保输出目录存在
@@ -146,6 +768,32 @@ class QuadTreeSplitter : public TileSplitter {
      */
     std::string generateTileFileName(int x, int y, int width, int height) const;
 
+    /**
+     * @brief 生成图集页文件名
+     *
+     * @param page 图集页序号
+     * @return 文件名
+     */
+    std::string generateAtlasFileName(int page) const;
+
+    /**
+     * @brief 生成 LOD 瓦片文件名
+     *
+     * @param level LOD 级别
+     * @param x 节点X坐标
+     * @param y 节点Y坐标
+     * @param width 节点宽度
+     * @param height 节点高度
+     * @return 文件名
+     */
+    std::string generateLodFileName(int level, int x, int y, int width,
+                                    int height) const;
+
+    /**
+     * @brief 判断瓦片是否为完全透明的纯色瓦片
+     */
+    static bool isTransparentColorTile(const TileMeta& tile);
+
     /**
      * @brief 判断瓦片是否为纯色瓦片
      *
@@ -164,7 +812,24 @@ class QuadTreeSplitter : public TileSplitter {
      */
     static uint32_t parseColorFromFileName(const std::string& fileName);
 
+    /**
+     * @brief 读入并解码源图像（RGBA），计入 decode 阶段
+     * @return 图像数据（需用 stbi_image_free 释放），失败时为空
+     */
+    static unsigned char* loadImage(const std::string& inputPath,
+                                    const Config& config, int& width,
+                                    int& height, int& channels);
+
+    /**
+     * @brief 按输出级别返回 std::cout 或丢弃输出的流
+     *
+     * @param level 消息的级别（1 摘要，2 逐个瓦片）
+     */
+    std::ostream& log(int level) const;
+
     ColorChecker colorChecker_;  ///< 颜色检查器实例
+    TileCodec::Type codec_ = TileCodec::Type::Png;  ///< 当前拆分的瓦片编码
+    int verbosity_ = 1;          ///< 当前拆分的输出级别
 };
 
 #endif  // QUADTREESPLITTER_HPP
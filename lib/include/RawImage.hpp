@@ -0,0 +1,90 @@
+#ifndef RAWIMAGE_HPP
+#define RAWIMAGE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/**
+ * @brief 原始 RGBA 图像格式（.rgba）读取器，用于流式拆分超大地图
+ *
+ * 文件布局：8 字节魔数 "MFRGBA01"，4 字节宽度和 4 字节高度（小端），
+ * 随后为按行主序排列的 RGBA8 像素。由于每行偏移可以直接计算，
+ * 读取器可以按条带读取任意行而无需解码整张图像。
+ */
+class RawImageReader {
+   public:
+    /**
+     * @brief 文件头大小（字节）
+     */
+    static constexpr size_t kHeaderSize = 16;
+
+    /**
+     * @brief 打开原始图像文件并读取文件头
+     *
+     * @param path 文件路径
+     * @return true 如果文件存在且文件头有效
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief 读取连续的若干行像素
+     *
+     * @param y 起始行
+     * @param rows 行数
+     * @param dst 目标缓冲，至少 width * rows * 4 字节
+     * @return true 如果读取成功
+     */
+    bool readRows(int y, int rows, unsigned char* dst);
+
+    /**
+     * @brief 获取图像宽度
+     * @return 宽度（像素）
+     */
+    int getWidth() const { return width_; }
+
+    /**
+     * @brief 获取图像高度
+     * @return 高度（像素）
+     */
+    int getHeight() const { return height_; }
+
+    /**
+     * @brief 判断文件是否为原始 RGBA 图像
+     *
+     * @param path 文件路径
+     * @return true 如果文件以 "MFRGBA01" 魔数开头
+     */
+    static bool isRawImage(const std::string& path);
+
+    /**
+     * @brief 将 RGBA 图像写为原始格式
+     *
+     * @param path 输出文件路径
+     * @param data RGBA 像素数据
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @return true 如果写入成功
+     */
+    static bool write(const std::string& path, const unsigned char* data,
+                      int width, int height);
+
+    /**
+     * @brief 将普通图像（PNG 等）转换为原始格式
+     *
+     * 转换时需要整体解码输入图像；超大地图应由制作工具直接导出原始格式。
+     *
+     * @param imagePath 输入图像路径
+     * @param rawPath 输出原始图像路径
+     * @return true 如果转换成功
+     */
+    static bool convert(const std::string& imagePath,
+                        const std::string& rawPath);
+
+   private:
+    std::ifstream file_;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+#endif  // RAWIMAGE_HPP
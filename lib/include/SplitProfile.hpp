@@ -0,0 +1,153 @@
+#ifndef SPLITPROFILE_HPP
+#define SPLITPROFILE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class QuadTreeNode;
+
+/**
+ * @brief 分割过程的分阶段性能统计
+ *
+ * 记录解码、四叉树构建、颜色一致性检查、编码和文件写出各阶段的耗时、
+ * 调用次数与处理的字节数，以及四叉树各深度的叶子数和叶子尺寸分布，
+ * 输出为 JSON。各阶段的累加可以在多个线程中同时进行；并行阶段
+ * （颜色检查、编码、写出）的耗时是各线程耗时之和，可能超过墙钟时间。
+ * 颜色检查发生在四叉树构建期间，其耗时包含在 tree_build 之内；流式
+ * 分割第一遍的条带读取同样既计入 decode 也计入 tree_build。
+ *
+ * 分割配置中的统计对象指针为空时不做任何计时。
+ */
+class SplitProfile {
+   public:
+    /**
+     * @brief 统计的阶段
+     */
+    enum class Phase {
+        Decode,      ///< 读入并解码源图像（字节数为输入文件大小）
+        TreeBuild,   ///< 构建四叉树（字节数为图像 RGBA 大小）
+        Uniformity,  ///< 颜色一致性检查（字节数为扫描的像素字节）
+        Encode,      ///< 截取并编码瓦片（字节数为编码前的 RGBA 大小）
+        Write        ///< 写出瓦片文件或打包文件（字节数为写出的字节）
+    };
+    static constexpr int kPhaseCount = 5;
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 作用域计时器：析构时把经过的时间计入阶段
+     *
+     * profile 为空时不读取时钟。
+     */
+    class Timer {
+       public:
+        Timer(SplitProfile* profile, Phase phase, uint64_t bytes = 0)
+            : profile_(profile), phase_(phase), bytes_(bytes) {
+            if (profile_) start_ = Clock::now();
+        }
+        ~Timer() {
+            if (profile_) {
+                profile_->add(phase_, Clock::now() - start_, bytes_);
+            }
+        }
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        /**
+         * @brief 设置计入的字节数（计时结束时才知道时使用）
+         */
+        void setBytes(uint64_t bytes) { bytes_ = bytes; }
+
+       private:
+        SplitProfile* profile_;
+        Phase phase_;
+        uint64_t bytes_;
+        Clock::time_point start_;
+    };
+
+    /**
+     * @brief 构造函数，开始计算总耗时
+     */
+    SplitProfile();
+
+    /**
+     * @brief 累加一次阶段调用（线程安全）
+     *
+     * @param phase 阶段
+     * @param elapsed 耗时
+     * @param bytes 处理的字节数
+     */
+    void add(Phase phase, Clock::duration elapsed, uint64_t bytes);
+
+    /**
+     * @brief 记录源图像尺寸
+     */
+    void setImageSize(int width, int height);
+
+    /**
+     * @brief 统计四叉树各深度的叶子数和叶子尺寸分布
+     *
+     * 尺寸按叶子在图像内部分的较长边归入 2 的幂次区间。
+     * 多次调用时累加（如多次分割共用一个统计对象）。
+     *
+     * @param root 四叉树根节点
+     * @param imageWidth 图像宽度
+     * @param imageHeight 图像高度
+     */
+    void recordTree(const QuadTreeNode* root, int imageWidth, int imageHeight);
+
+    /**
+     * @brief 记录写入元数据的瓦片数
+     */
+    void setTileCount(size_t tiles) { tileCount_ = tiles; }
+
+    /**
+     * @brief 获取阶段名称（JSON 中的键）
+     */
+    static const char* phaseName(Phase phase);
+
+    /**
+     * @brief 生成 JSON 报告，总耗时截止到调用时
+     */
+    std::string toJson() const;
+
+    /**
+     * @brief 把 JSON 报告写入文件
+     * @return true 如果写出成功
+     */
+    bool writeJson(const std::string& path) const;
+
+   private:
+    /**
+     * @brief 单个阶段的累计值
+     */
+    struct PhaseTotals {
+        std::atomic<int64_t> nanoseconds{0};
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    /**
+     * @brief 某一深度的叶子统计
+     */
+    struct DepthCount {
+        uint64_t leaves = 0;  ///< 叶子数
+        uint64_t pure = 0;    ///< 其中的纯色叶子数
+    };
+
+    void recordNode(const QuadTreeNode* node, int depth, int imageWidth,
+                    int imageHeight);
+
+    Clock::time_point start_;
+    PhaseTotals phases_[kPhaseCount];
+    int imageWidth_ = 0;
+    int imageHeight_ = 0;
+    size_t tileCount_ = 0;
+    std::vector<DepthCount> depths_;
+    std::vector<uint64_t> sizeBuckets_;  ///< [k]：较长边在 (2^(k-1), 2^k]
+};
+
+#endif  // SPLITPROFILE_HPP
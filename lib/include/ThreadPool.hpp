@@ -0,0 +1,66 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 固定大小的线程池，供拆分流程中的并行阶段复用
+ *
+ * 任务按提交顺序执行，通过返回的 future 等待完成并传播异常。
+ * 提交到线程池的任务不应阻塞等待同一线程池中的其他任务，
+ * 否则在线程数较少时可能死锁；需要分层并行时由调用方按波次提交。
+ */
+class ThreadPool {
+   public:
+    /**
+     * @brief 构造函数，立即启动工作线程
+     * @param numThreads 工作线程数量，小于1时按1处理
+     */
+    explicit ThreadPool(int numThreads);
+
+    /**
+     * @brief 析构函数，执行完队列中剩余任务后停止所有线程
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief 提交一个任务
+     * @param task 待执行的任务
+     * @return 任务完成时就绪的 future，任务抛出的异常会在 get() 时重新抛出
+     */
+    std::future<void> submit(std::function<void()> task);
+
+    /**
+     * @brief 获取工作线程数量
+     * @return 线程数量
+     */
+    int size() const { return static_cast<int>(workers_.size()); }
+
+    /**
+     * @brief 将线程数参数规范化
+     *
+     * @param requested 请求的线程数，0 表示使用硬件并发数
+     * @return 实际使用的线程数（至少为1）
+     */
+    static int resolveThreadCount(int requested);
+
+   private:
+    void workerThread();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::packaged_task<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_ = false;
+};
+
+#endif  // THREADPOOL_HPP
@@ -7,6 +7,8 @@
 #include <unordered_set>
 #include <vector>
 
+#include "TileCodec.hpp"
+
 struct CachedTile {
     std::string tileId;
     std::vector<unsigned char> data;
@@ -17,6 +19,14 @@ struct CachedTile {
     std::chrono::steady_clock::time_point lastAccessed;
     bool isPureColor;
     uint32_t pureColorValue;
+    // Low-color tiles stay as palette + packed indices; data is empty then
+    std::shared_ptr<const PaletteImage> palette;
+    // BC1/BC3 tiles keep their compressed blocks for a direct texture upload
+    std::shared_ptr<const BlockImage> blocks;
+    // Opaque, gray and alpha-mask tiles keep only the channels they use
+    std::shared_ptr<const ChannelImage> reduced;
+    // Mostly uniform tiles stay as per-row color runs
+    std::shared_ptr<const RleImage> rle;
     
     CachedTile(const std::string& id, std::vector<unsigned char>&& tileData, 
                int w, int h, int c, bool isPure = false, uint32_t color = 0)
@@ -67,6 +77,14 @@ public:
     
     void putPureColor(const std::string& tileId, uint32_t color, int width, int height);
     
+    void putPalette(const std::string& tileId, std::shared_ptr<const PaletteImage> image);
+    
+    void putBlocks(const std::string& tileId, std::shared_ptr<const BlockImage> image);
+    
+    void putChannels(const std::string& tileId, std::shared_ptr<const ChannelImage> image);
+    
+    void putRle(const std::string& tileId, std::shared_ptr<const RleImage> image);
+    
     void evictOutOfViewport(const std::vector<std::string>& visibleTileIds);
     
     void clear();
@@ -96,6 +114,8 @@ private:
     
     void removeTile(const std::string& tileId);
     
+    void insertTile(const std::shared_ptr<CachedTile>& tile);
+    
     size_t estimateTileSize(int width, int height, int channels, const std::string& tileId) const {
         return width * height * channels + sizeof(CachedTile) + tileId.size();
     }
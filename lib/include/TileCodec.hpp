@@ -0,0 +1,430 @@
+#ifndef TILECODEC_HPP
+#define TILECODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 调色板瓦片：调色板 + 紧凑存放的颜色索引
+ *
+ * 颜色数不超过 TileCodec::kMaxPaletteColors 的瓦片以这种形式保存和缓存，
+ * 绘制时才按索引展开为 RGBA。每个索引占 bitsPerIndex 位，同一字节内
+ * 从高位开始存放，每行按字节对齐。
+ */
+struct PaletteImage {
+    int width = 0;
+    int height = 0;
+    int bitsPerIndex = 0;                ///< 1、2 或 4
+    size_t stride = 0;                   ///< 每行索引的字节数
+    std::vector<unsigned char> palette;  ///< 颜色表（RGBA）
+    std::vector<unsigned char> indices;  ///< height * stride 字节
+
+    /**
+     * @brief 获取像素 (x, y) 的 RGBA 颜色
+     */
+    const unsigned char* color(int x, int y) const {
+        const int bitOffset = x * bitsPerIndex;
+        const int shift = 8 - bitsPerIndex - (bitOffset & 7);
+        const int index = (indices[y * stride + (bitOffset >> 3)] >> shift) &
+                          ((1 << bitsPerIndex) - 1);
+        return &palette[index * 4];
+    }
+
+    /**
+     * @brief 占用的内存字节数（调色板与索引）
+     */
+    size_t sizeBytes() const { return palette.size() + indices.size(); }
+
+    /**
+     * @brief 展开为 width * height * 4 的 RGBA 像素
+     */
+    void expand(std::vector<unsigned char>& pixels) const;
+};
+
+/**
+ * @brief 块压缩瓦片：GPU 可直接采样的 BC1 / BC3 数据
+ *
+ * 图像按 4x4 像素分块，块按行优先存放，右侧和底部不足 4 像素的块同样
+ * 完整存储。加载和缓存时保持块压缩形式，可原样上传为压缩纹理；软件
+ * 绘制时才解码为 RGBA。
+ */
+struct BlockImage {
+    /**
+     * @brief 块压缩格式
+     */
+    enum class Format {
+        Bc1,  ///< 每块 8 字节，RGB 565 + 1 位透明
+        Bc3   ///< 每块 16 字节，BC1 颜色块 + 插值 alpha 块
+    };
+
+    int width = 0;
+    int height = 0;
+    Format format = Format::Bc1;
+    std::vector<unsigned char> blocks;  ///< 行优先的压缩块
+
+    /**
+     * @brief 每块的字节数
+     */
+    size_t blockBytes() const { return format == Format::Bc1 ? 8 : 16; }
+
+    /**
+     * @brief 每行的块数
+     */
+    int blocksPerRow() const { return (width + 3) / 4; }
+
+    /**
+     * @brief 占用的内存字节数
+     */
+    size_t sizeBytes() const { return blocks.size(); }
+
+    /**
+     * @brief 把区域 (x, y, w, h) 解码为 w * h * 4 的 RGBA 像素
+     *
+     * 只解码与区域相交的块，区域必须位于图像内。
+     */
+    void decodeRegion(int x, int y, int w, int h, unsigned char* out) const;
+
+    /**
+     * @brief 解码为 width * height * 4 的 RGBA 像素
+     */
+    void expand(std::vector<unsigned char>& pixels) const;
+};
+
+/**
+ * @brief 通道精简瓦片：只保存实际用到的通道
+ *
+ * 完全不透明的瓦片只保存 RGB 三个通道，不透明且灰度的瓦片只保存一个
+ * 灰度通道；所有像素 RGB 相同、只有 alpha 变化的遮罩瓦片只保存 alpha
+ * 通道和这个公共颜色。以这种形式保存和缓存，绘制时才逐行展开为 RGBA。
+ */
+struct ChannelImage {
+    /**
+     * @brief 保存的通道
+     */
+    enum class Layout {
+        Rgb,   ///< RGB，alpha 恒为 255
+        Gray,  ///< 灰度，R = G = B，alpha 恒为 255
+        Alpha  ///< alpha，RGB 恒为 color
+    };
+
+    int width = 0;
+    int height = 0;
+    Layout layout = Layout::Rgb;
+    unsigned char color[3] = {0, 0, 0};  ///< Alpha 布局下所有像素的 RGB
+    std::vector<unsigned char> pixels;   ///< width * height * channels()
+
+    /**
+     * @brief 每个像素保存的通道数
+     */
+    int channels() const { return layout == Layout::Rgb ? 3 : 1; }
+
+    /**
+     * @brief 占用的内存字节数
+     */
+    size_t sizeBytes() const { return pixels.size(); }
+
+    /**
+     * @brief 把第 y 行从 x 开始的 count 个像素展开为 RGBA
+     */
+    void expandRow(int x, int y, int count, unsigned char* out) const;
+
+    /**
+     * @brief 展开为 width * height * 4 的 RGBA 像素
+     */
+    void expand(std::vector<unsigned char>& pixels) const;
+};
+
+/**
+ * @brief 行程编码瓦片：每行若干段同色像素
+ *
+ * 大部分为同一颜色、只有少量细节的瓦片以这种形式保存和缓存，绘制时
+ * 按段整段填充或混合，不逐像素展开。段不跨行，长度超过 65535 的段拆为
+ * 多段。
+ */
+struct RleImage {
+    /**
+     * @brief 同色段
+     */
+    struct Run {
+        unsigned char color[4];  ///< RGBA
+        uint16_t length;         ///< 像素数
+    };
+
+    int width = 0;
+    int height = 0;
+    std::vector<Run> runs;  ///< 按行依次存放
+    /// height + 1 项，第 y 行的段为 runs[rowStart[y], rowStart[y + 1])
+    std::vector<uint32_t> rowStart;
+
+    /**
+     * @brief 占用的内存字节数（段与行索引）
+     */
+    size_t sizeBytes() const {
+        return runs.size() * sizeof(Run) + rowStart.size() * sizeof(uint32_t);
+    }
+
+    /**
+     * @brief 展开为 width * height * 4 的 RGBA 像素
+     */
+    void expand(std::vector<unsigned char>& pixels) const;
+};
+
+/**
+ * @brief 瓦片编解码
+ *
+ * 一套瓦片只使用一种编码，由拆分时选择并记录在 meta.txt 中；
+ * 解码时按数据开头的魔数识别编码，因此混合编码的目录也能正确读取。
+ *
+ * - PNG：体积最小，解码较慢（stb_image）
+ * - QOI：无损、按字节流的简单编码，解码速度为 PNG 的数倍，体积略大
+ * - BC1 / BC3：有损的 GPU 块压缩格式（见 BlockImage），显存占用为 RGBA 的
+ *   1/8 和 1/4。BC1 只保留 1 位透明（alpha 小于 128 的像素变为全透明），
+ *   半透明内容应使用 BC3
+ *
+ * 此外，颜色数很少的瓦片可以不论所选编码保存为调色板格式（见
+ * encodePalette），文件扩展名为 kPaletteExtension；PNG 编码下不透明、
+ * 灰度和 alpha 遮罩瓦片可以只保存用到的通道（见 encodeChannels），文件
+ * 扩展名为 kChannelExtension；同色段很少的瓦片可以保存为行程编码
+ * （见 encodeRle），文件扩展名为 kRleExtension。
+ */
+class TileCodec {
+   public:
+    /**
+     * @brief 编码类型
+     */
+    enum class Type {
+        Png,  ///< PNG（默认）
+        Qoi,  ///< QOI（Quite OK Image）
+        Bc1,  ///< BC1（DXT1）块压缩
+        Bc3   ///< BC3（DXT5）块压缩
+    };
+
+    /**
+     * @brief 获取编码名称（用于命令行和 meta.txt）
+     * @param type 编码类型
+     * @return "png"、"qoi"、"bc1" 或 "bc3"
+     */
+    static const char* name(Type type);
+
+    /**
+     * @brief 由名称解析编码类型
+     *
+     * @param name 编码名称
+     * @param type 输出：编码类型
+     * @return true 如果名称有效
+     */
+    static bool fromName(const std::string& name, Type& type);
+
+    /**
+     * @brief 获取瓦片文件扩展名
+     * @param type 编码类型
+     * @return 含点号的扩展名，如 ".png"
+     */
+    static const char* extension(Type type);
+
+    /**
+     * @brief 编码 RGBA 图像
+     *
+     * @param type 编码类型
+     * @param pixels RGBA 像素数据
+     * @param width 宽度
+     * @param height 高度
+     * @param out 输出：编码后的数据（追加写入）
+     * @return true 如果编码成功
+     */
+    static bool encode(Type type, const unsigned char* pixels, int width,
+                       int height, std::vector<unsigned char>& out);
+
+    /**
+     * @brief 解码瓦片数据为 RGBA 像素，按魔数自动识别编码
+     *
+     * @param data 编码数据
+     * @param size 数据长度
+     * @param pixels 输出：RGBA 像素数据
+     * @param width 输出：宽度
+     * @param height 输出：高度
+     * @return true 如果解码成功
+     */
+    static bool decode(const unsigned char* data, size_t size,
+                       std::vector<unsigned char>& pixels, int* width,
+                       int* height);
+
+    /**
+     * @brief 调色板瓦片的最大颜色数
+     */
+    static constexpr int kMaxPaletteColors = 16;
+
+    /**
+     * @brief 调色板瓦片的文件扩展名
+     */
+    static constexpr const char* kPaletteExtension = ".pal";
+
+    /**
+     * @brief 判断 RGBA 图像的颜色数是否不超过 kMaxPaletteColors
+     *
+     * 遇到第 kMaxPaletteColors + 1 种颜色即返回。
+     */
+    static bool fitsPalette(const unsigned char* pixels, int width,
+                            int height);
+
+    /**
+     * @brief 编码为调色板格式
+     *
+     * 布局：4 字节魔数 "mfpl"，大端 uint32 宽、高，uint8 颜色数 n，
+     * n 个 RGBA 颜色（按首次出现的顺序），之后为逐行的紧凑索引。
+     *
+     * @param pixels RGBA 像素数据
+     * @param width 宽度
+     * @param height 高度
+     * @param out 输出：编码后的数据（追加写入）
+     * @return false 如果颜色数超过 kMaxPaletteColors
+     */
+    static bool encodePalette(const unsigned char* pixels, int width,
+                              int height, std::vector<unsigned char>& out);
+
+    /**
+     * @brief 判断数据是否为调色板格式
+     */
+    static bool isPalette(const unsigned char* data, size_t size);
+
+    /**
+     * @brief 解码调色板格式，保持索引形式
+     *
+     * @param data 编码数据
+     * @param size 数据长度
+     * @param image 输出：调色板瓦片
+     * @return true 如果解码成功
+     */
+    static bool decodePalette(const unsigned char* data, size_t size,
+                              PaletteImage& image);
+
+    /**
+     * @brief 编码为块压缩格式
+     *
+     * 布局：4 字节魔数 "mfbc"，大端 uint32 宽、高，uint8 格式（1 为 BC1，
+     * 3 为 BC3），之后为行优先的压缩块。颜色端点取块内像素主成分方向上的
+     * 两端，再按最小二乘调整一次。
+     *
+     * @param format 块压缩格式
+     * @param pixels RGBA 像素数据
+     * @param width 宽度
+     * @param height 高度
+     * @param out 输出：编码后的数据（追加写入）
+     * @return true 如果编码成功
+     */
+    static bool encodeBlocks(BlockImage::Format format,
+                             const unsigned char* pixels, int width,
+                             int height, std::vector<unsigned char>& out);
+
+    /**
+     * @brief 判断数据是否为块压缩格式
+     */
+    static bool isBlockCompressed(const unsigned char* data, size_t size);
+
+    /**
+     * @brief 读取块压缩格式，保持压缩形式
+     *
+     * @param data 编码数据
+     * @param size 数据长度
+     * @param image 输出：块压缩瓦片
+     * @return true 如果数据完整
+     */
+    static bool decodeBlocks(const unsigned char* data, size_t size,
+                             BlockImage& image);
+
+    /**
+     * @brief 通道精简瓦片的文件扩展名
+     */
+    static constexpr const char* kChannelExtension = ".chn";
+
+    /**
+     * @brief 判断 RGBA 图像能否精简通道，并确定保存的通道
+     *
+     * @param pixels RGBA 像素数据
+     * @param width 宽度
+     * @param height 高度
+     * @param layout 输出：保存的通道
+     * @param color 输出：Alpha 布局下的公共 RGB
+     * @return false 如果四个通道都需要保存
+     */
+    static bool reducibleChannels(const unsigned char* pixels, int width,
+                                  int height, ChannelImage::Layout& layout,
+                                  unsigned char color[3]);
+
+    /**
+     * @brief 编码为通道精简格式
+     *
+     * 布局：4 字节魔数 "mfch"，大端 uint32 宽、高，uint8 通道布局（0 为
+     * RGB，1 为灰度，2 为 alpha），3 字节公共 RGB，之后为只含保存通道的
+     * PNG（3 或 1 个通道）。
+     *
+     * @param pixels RGBA 像素数据
+     * @param width 宽度
+     * @param height 高度
+     * @param out 输出：编码后的数据（追加写入）
+     * @return false 如果四个通道都需要保存
+     */
+    static bool encodeChannels(const unsigned char* pixels, int width,
+                               int height, std::vector<unsigned char>& out);
+
+    /**
+     * @brief 判断数据是否为通道精简格式
+     */
+    static bool isChannelReduced(const unsigned char* data, size_t size);
+
+    /**
+     * @brief 解码通道精简格式，保持精简后的通道
+     *
+     * @param data 编码数据
+     * @param size 数据长度
+     * @param image 输出：通道精简瓦片
+     * @return true 如果解码成功
+     */
+    static bool decodeChannels(const unsigned char* data, size_t size,
+                               ChannelImage& image);
+
+    /**
+     * @brief 行程编码瓦片的文件扩展名
+     */
+    static constexpr const char* kRleExtension = ".rle";
+
+    /**
+     * @brief 判断 RGBA 图像按行程编码后是否小于原始大小
+     */
+    static bool fitsRle(const unsigned char* pixels, int width, int height);
+
+    /**
+     * @brief 编码为行程编码格式
+     *
+     * 布局：4 字节魔数 "mfrl"，大端 uint32 宽、高、段数，之后逐行存放各段：
+     * RGBA 颜色和大端 uint16 长度。
+     *
+     * @param pixels RGBA 像素数据
+     * @param width 宽度
+     * @param height 高度
+     * @param out 输出：编码后的数据（追加写入）
+     * @return false 如果编码后不小于 RGBA 原始大小
+     */
+    static bool encodeRle(const unsigned char* pixels, int width, int height,
+                          std::vector<unsigned char>& out);
+
+    /**
+     * @brief 判断数据是否为行程编码格式
+     */
+    static bool isRle(const unsigned char* data, size_t size);
+
+    /**
+     * @brief 读取行程编码格式，保持段的形式
+     *
+     * @param data 编码数据
+     * @param size 数据长度
+     * @param image 输出：行程编码瓦片
+     * @return true 如果数据完整且每行的段长之和等于宽度
+     */
+    static bool decodeRle(const unsigned char* data, size_t size,
+                          RleImage& image);
+};
+
+#endif  // TILECODEC_HPP
@@ -1,9 +1,13 @@
 #pragma once
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "BinaryMeta.hpp"
+#include "TileCodec.hpp"
 #include "TileSplitter.hpp"
 
 struct Viewport {
@@ -15,15 +19,56 @@ struct Viewport {
 
 class TileIndex {
    public:
+    // Loads meta.txt or a binary meta.bin; the format is detected from the
+    // file's first bytes. A binary file is mapped and queried in place.
     bool load(const std::string& metaFile);
+    // Full-resolution tiles overlapping vp
     std::vector<TileMeta> query(const Viewport& vp) const;
+    // Tiles of LOD level (1 = half resolution, ...) overlapping vp, which is
+    // given in full-resolution map coordinates. Level 0 is the same as query.
+    std::vector<TileMeta> queryLod(const Viewport& vp, int level) const;
+    // Number of LOD levels stored in addition to full resolution
+    int getLodLevels() const;
     bool save(const std::string& metaFile) const;  // for split phase
-    void setTiles(std::vector<TileMeta> tiles);
+    // Same content as save() in the fixed-record format of BinaryMeta
+    bool saveBinary(const std::string& metaFile) const;
+    void setTiles(std::vector<TileMeta> tiles);  // LOD tiles included
     int getMapWidth() const { return mapWidth_; }
     int getMapHeight() const { return mapHeight_; }
+    // Codec of the tile set, stored as a "# codec <name>" line in meta.txt.
+    // Lines starting with '#' are skipped by loaders that predate directives.
+    void setCodec(TileCodec::Type codec) { codec_ = codec; }
+    TileCodec::Type getCodec() const { return codec_; }
+    // Size of the source map when the tiles do not cover it up to its edges
+    // (transparent trimming). Stored as a "# size <w> <h>" line; the map
+    // size is the larger of this and the extent of the tiles.
+    void setMapSize(int width, int height);
 
    protected:
-    std::vector<TileMeta> tiles_;
+    // Copies the tiles of a mapped binary file into tiles_ / lodTiles_ and
+    // releases the mapping, for subclasses that index tiles_ themselves.
+    void materialize();
+
+    // Calls fn for every tile, full resolution first, then LOD levels.
+    void forEachTile(const std::function<void(const TileMeta&)>& fn) const;
+
+    void parseDirective(const std::string& line);
+    // Optional per-tile "key=value" tokens after the file column. Unknown
+    // keys are ignored; loaders that predate them stop reading at the file.
+    static void parseAttribute(TileMeta& meta, const std::string& token);
+
+    void updateMapSize();
+
+    void addTile(TileMeta meta);
+
+    std::vector<TileMeta> tiles_;  // full resolution only
+    std::vector<std::vector<TileMeta>> lodTiles_;  // [level - 1]
     int mapWidth_ = 0;   // derived from tiles: max(x+w)
     int mapHeight_ = 0;  // derived from tiles: max(y+h) (y 自顶向下递增)
+    int declaredWidth_ = 0;  // from setMapSize / "# size"
+    int declaredHeight_ = 0;
+    TileCodec::Type codec_ = TileCodec::Type::Png;
+    // Set while tiles come from a mapped binary file; tiles_ and lodTiles_
+    // are empty then.
+    std::shared_ptr<const BinaryMeta> binary_;
 };
@@ -0,0 +1,200 @@
+#ifndef TILEPACK_HPP
+#define TILEPACK_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct BlockImage;
+struct ChannelImage;
+struct PaletteImage;
+struct RleImage;
+
+/**
+ * @brief 瓦片打包文件（tiles.pack），以单个文件代替成千上万个瓦片文件
+ *
+ * 文件布局（整数均为小端）：
+ *   文件头：8 字节魔数 "MFTPACK1"，uint32 条目数，uint32 保留，
+ *           uint64 偏移表起始位置
+ *   数据区：各瓦片编码后的数据依次连续存放
+ *   偏移表：每个条目为 uint16 名称长度、名称、uint64 偏移、uint64 长度
+ *
+ * 条目名称即元数据中的 file 字段，运行时以此查找瓦片。
+ */
+class TilePack {
+   public:
+    /**
+     * @brief 打包文件在瓦片目录中的默认文件名
+     */
+    static constexpr const char* kFileName = "tiles.pack";
+
+    TilePack() = default;
+    ~TilePack();
+
+    TilePack(const TilePack&) = delete;
+    TilePack& operator=(const TilePack&) = delete;
+
+    /**
+     * @brief 打开打包文件并载入偏移表
+     *
+     * 支持 mmap 的平台上整个文件以只读方式映射，读取瓦片无需系统调用；
+     * 其他平台退化为按偏移读取。
+     *
+     * @param path 打包文件路径
+     * @return true 如果文件有效
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief 判断打包文件中是否包含指定瓦片
+     */
+    bool contains(const std::string& name) const;
+
+    /**
+     * @brief 获取瓦片的编码数据
+     *
+     * @param name 瓦片名称
+     * @param data 输出：数据指针（映射内存或 scratch 中的数据）
+     * @param size 输出：数据长度
+     * @param scratch 无法映射时用于存放读取结果的缓冲
+     * @return true 如果找到并读取成功
+     */
+    bool getPayload(const std::string& name, const unsigned char*& data,
+                    size_t& size, std::vector<unsigned char>& scratch) const;
+
+    /**
+     * @brief 获取条目数
+     */
+    size_t size() const { return entries_.size(); }
+
+    /**
+     * @brief 获取瓦片目录对应的共享打包文件
+     *
+     * 每个目录只打开一次，直到 releaseShared 释放；目录中没有打包文件时
+     * 返回空指针且不缓存，之后写出的打包文件仍会被读取。目录按
+     * 规范化后的路径区分，"dir"、"dir/" 和 "./dir" 共用一个打包文件。
+     *
+     * @param resourceDir 瓦片目录
+     * @return 打包文件，或空指针
+     */
+    static std::shared_ptr<const TilePack> forDirectory(
+        const std::string& resourceDir);
+
+    /**
+     * @brief 释放 forDirectory 缓存的全部打包文件
+     */
+    static void releaseShared();
+
+    /**
+     * @brief 释放 forDirectory 缓存的一个目录的打包文件
+     *
+     * 打包文件被替换后调用（TileWriter::finish 会自动调用）；仍在使用
+     * 旧文件的调用方持有的映射保持有效。
+     *
+     * @param resourceDir 瓦片目录
+     */
+    static void releaseShared(const std::string& resourceDir);
+
+    /**
+     * @brief 加载瓦片为 RGBA 像素
+     *
+     * 瓦片所在目录存在打包文件时从打包文件读取，否则读取瓦片文件；
+     * 数据均在内存中解码，编码由 TileCodec 按魔数识别。
+     *
+     * @param filePath 瓦片路径（瓦片目录 + "/" + 元数据中的文件名）
+     * @param pixels 输出：RGBA 像素数据
+     * @param width 输出：宽度
+     * @param height 输出：高度
+     * @param palette 可选输出：非空且瓦片为调色板格式时解码到这里，保持
+     *                索引形式，pixels 置空
+     * @param blocks 可选输出：非空且瓦片为块压缩格式时读取到这里，保持
+     *               压缩形式，pixels 置空
+     * @param channels 可选输出：非空且瓦片为通道精简格式时解码到这里，
+     *                 保持精简后的通道，pixels 置空
+     * @param rle 可选输出：非空且瓦片为行程编码格式时读取到这里，保持段的
+     *            形式，pixels 置空
+     * @return true 如果读取并解码成功
+     */
+    static bool loadTile(const std::string& filePath,
+                         std::vector<unsigned char>& pixels, int* width,
+                         int* height, PaletteImage* palette = nullptr,
+                         BlockImage* blocks = nullptr,
+                         ChannelImage* channels = nullptr,
+                         RleImage* rle = nullptr);
+
+   private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    void close();
+
+    std::unordered_map<std::string, Entry> entries_;
+    const unsigned char* mapped_ = nullptr;  ///< mmap 映射的整个文件
+    size_t mappedSize_ = 0;
+    FILE* file_ = nullptr;             ///< 无法映射时使用的文件句柄
+    mutable std::mutex fileMutex_;     ///< 保护 file_ 的读取位置
+};
+
+/**
+ * @brief 瓦片打包文件写出器
+ *
+ * 数据先写入 "<path>.tmp"，finish() 时补写偏移表并原子地重命名，
+ * 正在映射旧打包文件的读取方不受影响。
+ */
+class TilePackWriter {
+   public:
+    TilePackWriter() = default;
+    ~TilePackWriter();
+
+    TilePackWriter(const TilePackWriter&) = delete;
+    TilePackWriter& operator=(const TilePackWriter&) = delete;
+
+    /**
+     * @brief 创建打包文件
+     * @param path 最终的打包文件路径
+     * @return true 如果创建成功
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief 追加一个瓦片
+     *
+     * @param name 瓦片名称
+     * @param data 编码后的数据
+     * @param size 数据长度
+     * @return true 如果写入成功
+     */
+    bool add(const std::string& name, const unsigned char* data, size_t size);
+
+    /**
+     * @brief 写出偏移表并完成打包文件
+     * @return true 如果成功
+     */
+    bool finish();
+
+    /**
+     * @brief 是否已打开且尚未完成
+     */
+    bool isOpen() const { return file_ != nullptr; }
+
+   private:
+    struct Entry {
+        std::string name;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    std::string path_;
+    FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    bool failed_ = false;
+    std::vector<Entry> entries_;
+};
+
+#endif  // TILEPACK_HPP
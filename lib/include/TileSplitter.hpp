@@ -4,12 +4,24 @@
 #include <string>
 #include <vector>
 
+#include "TileWriter.hpp"
+
 struct TileMeta {
     int x;
     int y;
     int w;
     int h;
     std::string file;
+    // Origin of the tile inside its decoded payload; non-zero for tiles
+    // packed into an atlas page. Saved as "sx=" / "sy=" after the file column.
+    int srcX = 0;
+    int srcY = 0;
+    // Level of detail: the payload is the x/y/w/h area reduced 2^lod times.
+    // 0 for full-resolution tiles; LOD tiles are saved with "lod=".
+    int lod = 0;
+    // Largest per-channel difference between a lossy pure-colour tile and the
+    // source pixels it replaces; 0 when exact. Saved as "err=".
+    int err = 0;
 };
 
 class TileSplitter {
@@ -19,4 +31,43 @@ class TileSplitter {
     std::vector<TileMeta> split(const std::string& inputPath,
                                 const std::string& outDir, int tileW,
                                 int tileH);
+
+    // Split a raw RGBA image (see RawImageReader) reading stripHeight rows at
+    // a time, so the whole map never has to fit in memory. stripHeight is
+    // rounded up to a multiple of tileH. Output matches split().
+    std::vector<TileMeta> splitStreaming(const std::string& inputPath,
+                                         const std::string& outDir, int tileW,
+                                         int tileH, int stripHeight);
+
+    // Configure the encode stage (worker threads and in-flight memory budget).
+    void setWriterConfig(const TileWriter::Config& config) {
+        writerConfig_ = config;
+    }
+
+    // Crop each tile to the bounding box of its non-transparent pixels;
+    // fully transparent tiles are dropped.
+    void setTrimTransparent(bool trim) { trimTransparent_ = trim; }
+
+    // Order metadata and payloads along a Hilbert curve instead of row-major
+    // (see HilbertCurve). Streaming splits only reorder the metadata.
+    void setHilbertOrder(bool hilbert) { hilbertOrder_ = hilbert; }
+
+    // Size of the last split image. With trimming the tiles may not reach
+    // the image edges, so save it alongside them (TileIndex::setMapSize).
+    int getImageWidth() const { return imageWidth_; }
+    int getImageHeight() const { return imageHeight_; }
+
+   protected:
+    // Point metas[firstMeta...] at the files actually written for jobs and
+    // shrink trimmed tiles to their written rect; drops transparent tiles.
+    static void applyOutputs(std::vector<TileMeta>& metas, size_t firstMeta,
+                             const std::vector<bool>& written,
+                             const std::vector<TileOutput>& outputs,
+                             const std::string& outDir);
+
+    TileWriter::Config writerConfig_;
+    bool trimTransparent_ = false;
+    bool hilbertOrder_ = false;
+    int imageWidth_ = 0;
+    int imageHeight_ = 0;
 };
@@ -0,0 +1,283 @@
+#ifndef TILEWRITER_HPP
+#define TILEWRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "SplitProfile.hpp"
+#include "TileCodec.hpp"
+#include "TilePack.hpp"
+
+class EncodeCache;
+class MemoryBudget;
+class ThreadPool;
+
+/**
+ * @brief 瓦片编码任务：从源图像截取一个区域，编码后写入输出目录
+ */
+struct TileJob {
+    int x;                 ///< 区域左上角X坐标
+    int y;                 ///< 区域左上角Y坐标
+    int width;             ///< 瓦片宽度（超出图像的部分填充透明像素）
+    int height;            ///< 瓦片高度
+    std::string fileName;  ///< 输出文件名（相对输出目录）
+    /// 预先截取的瓦片像素（width * height * 4），非空时直接编码，
+    /// 不再从源图像截取；用于流式拆分中跨越多个条带的瓦片
+    std::vector<unsigned char> pixels = {};
+    bool trim = false;  ///< 只写出非透明像素的包围盒
+};
+
+/**
+ * @brief 瓦片任务的实际写出结果
+ */
+struct TileOutput {
+    std::string fileName;  ///< 引用的文件名（去重时由内容生成）
+    int x = 0;             ///< 写出区域相对任务左上角的X偏移
+    int y = 0;             ///< 写出区域相对任务左上角的Y偏移
+    int width = 0;         ///< 写出区域宽度
+    int height = 0;        ///< 写出区域高度
+    bool trimmed = false;  ///< 写出区域经过透明裁剪
+    bool empty = false;    ///< 裁剪后没有非透明像素，未写出任何文件
+};
+
+/**
+ * @brief 瓦片编码写出器
+ *
+ * 拆分器先收集全部瓦片任务，再由本类交给工作线程并发截取、编码并写文件。
+ * 同时处于编码中的瓦片缓冲总量受 maxInFlightBytes 限制，使峰值内存可预测；
+ * 单个超过预算的瓦片在没有其他任务进行时仍会被处理。配置共享的
+ * MemoryBudget 时改为从共享预算中占用，本写出器没有进行中的任务时同样
+ * 不等待。
+ *
+ * 启用 packOutput 时瓦片不再写成单独文件，而是按任务顺序追加到输出目录的
+ * tiles.pack 中（见 TilePack），多次 writeAll 写入同一个打包文件，
+ * 全部写完后需调用 finish()。
+ *
+ * 启用 dedupContent 时按瓦片内容（含透明填充）计算 128 位哈希，文件名
+ * 由哈希生成，内容相同的瓦片只编码写出一次，多个元数据条目引用同一文件；
+ * 去重范围覆盖同一写出器的所有 writeAll 调用，直到 finish()。去重文件
+ * 先写临时文件再改名，中断的写出不会留下残缺的同名文件，因此输出目录中
+ * 已存在的同名文件内容必然相同，不会重写。
+ *
+ * 任务设置 trim 时只截取并编码非透明像素的包围盒，实际写出的区域通过
+ * TileOutput 返回；完全透明的任务不写出文件，视为成功。
+ *
+ * 配置 encodeCache 时先按截取的像素查找编码缓存，命中则跳过编码。
+ *
+ * 启用 paletteTiles 时，颜色数不超过 TileCodec::kMaxPaletteColors 的瓦片
+ * 不论所选编码都保存为调色板格式（TileCodec::encodePalette），文件扩展名
+ * 换为 TileCodec::kPaletteExtension。调色板编码比查找编码缓存更快，
+ * 这些瓦片不使用编码缓存。
+ *
+ * 启用 reduceChannels 且编码为 PNG 时，不透明、灰度和 alpha 遮罩瓦片
+ * 只保存用到的通道（TileCodec::encodeChannels），文件扩展名换为
+ * TileCodec::kChannelExtension，同样不使用编码缓存；调色板格式优先。
+ *
+ * 启用 rleTiles 时，按行程编码小于 RGBA 原始大小的瓦片不论所选编码都
+ * 保存为行程编码格式（TileCodec::encodeRle），文件扩展名换为
+ * TileCodec::kRleExtension，不使用编码缓存。行程编码绘制时整段填充，
+ * 因此优先于调色板和通道精简格式。
+ */
+class TileWriter {
+   public:
+    /**
+     * @brief 编码写出配置
+     */
+    struct Config {
+        int numThreads;           ///< 编码线程数（1为串行，0为硬件并发数）
+        size_t maxInFlightBytes;  ///< 编码中瓦片缓冲的内存预算（字节）
+        bool packOutput;          ///< 写入单个打包文件而非单独的瓦片文件
+        TileCodec::Type codec;    ///< 瓦片编码
+        bool dedupContent;        ///< 内容相同的瓦片共用一个文件
+        SplitProfile* profile;    ///< 记录编码和写出耗时，为空时不统计
+        /// 可选的共享线程池，非空时忽略 numThreads（批量拆分时多张地图
+        /// 共用同一个线程池）
+        ThreadPool* pool;
+        /// 可选的共享内存预算，非空时代替 maxInFlightBytes
+        MemoryBudget* memoryBudget;
+        EncodeCache* encodeCache;  ///< 编码结果的磁盘缓存，为空时不使用
+        bool paletteTiles;  ///< 颜色数少的瓦片保存为调色板格式
+        bool reduceChannels;  ///< 不需要四个通道的瓦片只保存用到的通道
+        bool rleTiles;  ///< 同色段少的瓦片保存为行程编码
+
+        Config()
+            : numThreads(1),
+              maxInFlightBytes(256u * 1024 * 1024),
+              packOutput(false),
+              codec(TileCodec::Type::Png),
+              dedupContent(false),
+              profile(nullptr),
+              pool(nullptr),
+              memoryBudget(nullptr),
+              encodeCache(nullptr),
+              paletteTiles(false),
+              reduceChannels(false),
+              rleTiles(false) {}
+    };
+
+    /**
+     * @brief 构造函数
+     * @param config 编码写出配置
+     */
+    explicit TileWriter(const Config& config = Config());
+
+    /**
+     * @brief 编码并写出全部瓦片
+     *
+     * @param imageData 源图像数据（RGBA格式）
+     * @param imageWidth 源图像宽度
+     * @param imageHeight 源图像高度
+     * @param jobs 瓦片任务列表
+     * @param outDir 输出目录
+     * @param outputs 可选输出：每个任务实际引用的文件名和写出区域；去重时
+     *                文件名可能与 TileJob::fileName 不同，且多个任务可能相同
+     * @return 每个任务是否写出成功，与 jobs 一一对应
+     */
+    std::vector<bool> writeAll(const unsigned char* imageData, int imageWidth,
+                               int imageHeight,
+                               const std::vector<TileJob>& jobs,
+                               const std::string& outDir,
+                               std::vector<TileOutput>* outputs = nullptr);
+
+    /**
+     * @brief 完成输出；打包模式下写出偏移表，并清空去重记录
+     *
+     * 打包模式下同时释放 TilePack::forDirectory 缓存的该目录旧打包文件，
+     * 之后的加载读取新写出的文件。
+     *
+     * @return true 如果成功
+     */
+    bool finish();
+
+    /**
+     * @brief 获取去重后实际编码写出的瓦片数（自上次 finish() 起）
+     */
+    size_t getUniqueTileCount() const { return dedup_.size(); }
+
+    /**
+     * @brief 获取最近一次 writeAll 中编码缓冲的峰值占用
+     * @return 峰值字节数（按预算估算口径）
+     */
+    size_t getPeakInFlightBytes() const { return peakInFlightBytes_; }
+
+    /**
+     * @brief 估算单个瓦片编码时占用的内存
+     *
+     * 包括截取的 RGBA 缓冲和编码器输出缓冲（按原始大小估计）。
+     *
+     * @param job 瓦片任务
+     * @return 估算的字节数
+     */
+    static size_t estimateJobBytes(const TileJob& job);
+
+    /**
+     * @brief 计算图像区域像素的 128 位哈希，尺寸参与计算
+     *
+     * 与去重使用同一哈希函数，但逐行累计，结果与 hashPixels 不同。
+     */
+    static std::pair<uint64_t, uint64_t> hashRegion(
+        const unsigned char* imageData, int imageWidth, int x, int y,
+        int width, int height);
+
+    /**
+     * @brief 把 128 位哈希格式化为 32 位小写十六进制字符串
+     *
+     * 内容哈希写入文件名或文本文件时都使用此格式。
+     */
+    static std::string hashToHex(const std::pair<uint64_t, uint64_t>& hash);
+
+   private:
+    /**
+     * @brief 任务内实际写出的矩形（相对任务左上角）
+     */
+    struct Rect {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    /**
+     * @brief 确定任务写出的矩形；未设置 trim 时为整个任务区域
+     * @return false 如果裁剪后没有非透明像素
+     */
+    static bool contentRect(const unsigned char* imageData, int imageWidth,
+                            int imageHeight, const TileJob& job, Rect& rect);
+
+    /**
+     * @brief 截取任务中的矩形（超出图像的部分填充透明像素）
+     */
+    static void cropJob(const unsigned char* imageData, int imageWidth,
+                        int imageHeight, const TileJob& job, const Rect& rect,
+                        std::vector<unsigned char>& out);
+
+    /**
+     * @brief 截取并编码单个瓦片
+     *
+     * encoded 非空时编码结果写入该缓冲，否则写成 outDir 中的 fileName。
+     * 保存为行程编码、调色板或通道精简格式时 fileName 先换为对应的
+     * 扩展名。
+     */
+    bool encodeJob(const unsigned char* imageData, int imageWidth,
+                   int imageHeight, const TileJob& job, const Rect& rect,
+                   std::string& fileName, const std::string& outDir,
+                   std::vector<unsigned char>* encoded) const;
+
+    /**
+     * @brief 是否对瓦片精简通道（只在 PNG 编码下生效）
+     */
+    bool reducesChannels() const {
+        return config_.reduceChannels && config_.codec == TileCodec::Type::Png;
+    }
+
+    /**
+     * @brief 按所选编码编码截取的像素，配置了编码缓存时先查找缓存
+     */
+    bool encodeCached(const std::vector<unsigned char>& tileData,
+                      const Rect& rect, std::vector<unsigned char>& out) const;
+
+    /**
+     * @brief 计算瓦片内容（width * height RGBA）的哈希，尺寸参与计算
+     */
+    static std::pair<uint64_t, uint64_t> hashPixels(
+        const unsigned char* pixels, int width, int height);
+
+    /**
+     * @brief 已登记的唯一瓦片
+     */
+    struct DedupEntry {
+        std::string fileName;  ///< 由内容哈希生成的文件名
+        bool written;          ///< 编码任务是否写出成功
+    };
+
+    /**
+     * @brief 把唯一瓦片的写出结果传递给引用它的重复任务
+     */
+    std::vector<bool> resolveDuplicates(
+        const std::vector<char>& written,
+        const std::vector<size_t>& encodeOrder,
+        const std::vector<DedupEntry*>& entries);
+
+    /**
+     * @brief 内容哈希的散列函数
+     */
+    struct HashKey {
+        size_t operator()(const std::pair<uint64_t, uint64_t>& key) const {
+            return static_cast<size_t>(key.first);
+        }
+    };
+
+    Config config_;
+    std::unordered_map<std::pair<uint64_t, uint64_t>, DedupEntry, HashKey>
+        dedup_;  ///< 内容哈希 -> 唯一瓦片
+    std::unique_ptr<TilePackWriter> pack_;  ///< 打包模式下的输出文件
+    std::string packDir_;                   ///< pack_ 所在的瓦片目录
+    size_t peakInFlightBytes_ = 0;
+};
+
+#endif  // TILEWRITER_HPP
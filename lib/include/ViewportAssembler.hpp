@@ -6,13 +6,19 @@
 
 class ViewportAssembler {
    public:
+    // level > 0 renders a zoomed-out view from the LOD tiles of that level:
+    // the image is reduced 2^level times and covers the reduced pixels whose
+    // blocks start inside vp (vp is in full-resolution map coordinates).
     bool assemble(const TileIndex& index, const Viewport& vp,
-                  const std::string& resourceDir,
-                  const std::string& outFile) const;
+                  const std::string& resourceDir, const std::string& outFile,
+                  int level = 0) const;
     std::string assembleToHex(const TileIndex& index, const Viewport& vp,
                               const std::string& resourceDir) const;
 
    private:
+    void renderTiles(std::vector<unsigned char>& canvas, const Viewport& vp,
+                     const std::vector<TileMeta>& tiles,
+                     const std::string& resourceDir) const;
     void blit(std::vector<unsigned char>& canvas, int canvas_w, int canvas_h,
               const unsigned char* src, int sw, int sh, int stride, int dstX,
               int dstY) const;
@@ -2,7 +2,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
-#include "stb_image.h"
+#include "TilePack.hpp"
 
 AsyncTileLoader::AsyncTileLoader(std::shared_ptr<TileCache> cache, const Config& config)
     : cache_(cache), config_(config) {
@@ -51,59 +51,12 @@ std::future<LoadResult> AsyncTileLoader::loadTileAsync(const std::string& tileId
                                                       const std::string& resourceDir,
                                                       const TileMeta& tileMeta, 
                                                       int priority) {
-    auto cachedTile = cache_->get(tileId);
-    if (cachedTile) {
-        stats_.cacheHits++;
-        
-        LoadResult result;
-        result.tileId = tileId;
-        result.status = LoadStatus::Completed;
-        result.isPureColor = cachedTile->isPureColor;
-        result.pureColorValue = cachedTile->pureColorValue;
-        result.width = cachedTile->width;
-        result.height = cachedTile->height;
-        result.channels = cachedTile->channels;
-        
-        if (!cachedTile->isPureColor) {
-            result.data = cachedTile->data;
-        }
-        
-        auto promise = std::make_shared<std::promise<LoadResult>>();
-        promise->set_value(std::move(result));
-        return promise->get_future();
-    }
-    
-    if (priority == -1) {
-        priority = config_.defaultPriority;
-    }
-    
     auto promise = std::make_shared<std::promise<LoadResult>>();
     auto future = promise->get_future();
     
-    std::string filePath = resourceDir + "/" + tileMeta.file;
-    bool isPure = isPureColorTile(tileMeta.file);
-    uint32_t color = isPure ? parseColorFromFileName(tileMeta.file) : 0;
-    
-    TileLoadRequest request(tileId, filePath, priority, isPure, color, tileMeta.w, tileMeta.h);
-    
-    {
-        std::unique_lock<std::mutex> lock(callbackMutex_);
-        callbacks_[tileId].push_back([promise](const LoadResult& result) {
-            promise->set_value(result);
-        });
-    }
-    
-    {
-        std::unique_lock<std::mutex> lock(queueMutex_);
-        if (loadQueue_.size() < config_.maxQueueSize) {
-            loadQueue_.push(request);
-            stats_.queuedRequests++;
-            updateStatus(tileId, LoadStatus::Pending);
-        }
-    }
-    
-    queueCondition_.notify_one();
-    stats_.totalRequests++;
+    loadTileAsync(tileId, resourceDir, tileMeta, [promise](const LoadResult& result) {
+        promise->set_value(result);
+    }, priority);
     
     return future;
 }
@@ -116,21 +69,7 @@ void AsyncTileLoader::loadTileAsync(const std::string& tileId,
     auto cachedTile = cache_->get(tileId);
     if (cachedTile) {
         stats_.cacheHits++;
-        
-        LoadResult result;
-        result.tileId = tileId;
-        result.status = LoadStatus::Completed;
-        result.isPureColor = cachedTile->isPureColor;
-        result.pureColorValue = cachedTile->pureColorValue;
-        result.width = cachedTile->width;
-        result.height = cachedTile->height;
-        result.channels = cachedTile->channels;
-        
-        if (!cachedTile->isPureColor) {
-            result.data = cachedTile->data;
-        }
-        
-        callback(result);
+        callback(makeCachedResult(tileId, *cachedTile));
         return;
     }
     
@@ -138,28 +77,48 @@ void AsyncTileLoader::loadTileAsync(const std::string& tileId,
         priority = config_.defaultPriority;
     }
     
+    stats_.totalRequests++;
+    
+    // Tile ids are content keys, so a viewport may request the same tile many
+    // times; only the first request is queued and the rest share its result
+    {
+        std::unique_lock<std::mutex> lock(callbackMutex_);
+        auto& pending = callbacks_[tileId];
+        pending.push_back(callback);
+        if (pending.size() > 1) {
+            return;
+        }
+    }
+    
     std::string filePath = resourceDir + "/" + tileMeta.file;
     bool isPure = isPureColorTile(tileMeta.file);
     uint32_t color = isPure ? parseColorFromFileName(tileMeta.file) : 0;
     
     TileLoadRequest request(tileId, filePath, priority, isPure, color, tileMeta.w, tileMeta.h);
     
-    {
-        std::unique_lock<std::mutex> lock(callbackMutex_);
-        callbacks_[tileId].push_back(callback);
-    }
-    
+    bool queued = false;
     {
         std::unique_lock<std::mutex> lock(queueMutex_);
         if (loadQueue_.size() < config_.maxQueueSize) {
             loadQueue_.push(request);
             stats_.queuedRequests++;
             updateStatus(tileId, LoadStatus::Pending);
+            queued = true;
         }
     }
     
+    if (!queued) {
+        // Fail now rather than leave the waiting callbacks unanswered
+        LoadResult result;
+        result.tileId = tileId;
+        result.status = LoadStatus::Failed;
+        result.error = "Load queue is full";
+        stats_.failedLoads++;
+        notifyCallbacks(result);
+        return;
+    }
+    
     queueCondition_.notify_one();
-    stats_.totalRequests++;
 }
 
 void AsyncTileLoader::preloadViewportTiles(const std::vector<TileMeta>& tiles, 
@@ -279,14 +238,33 @@ void AsyncTileLoader::workerThread() {
         if (hasRequest) {
             updateStatus(request.tileId, LoadStatus::Loading);
             
+            // A preload of the same content may have finished in the meantime
+            auto cachedTile = cache_->get(request.tileId);
+            if (cachedTile) {
+                updateStatus(request.tileId, LoadStatus::Completed);
+                notifyCallbacks(makeCachedResult(request.tileId, *cachedTile));
+                stats_.activeLoads--;
+                continue;
+            }
+            
             LoadResult result = loadTileSync(request);
             
             if (result.status == LoadStatus::Completed) {
                 if (result.isPureColor) {
                     cache_->putPureColor(result.tileId, result.pureColorValue, 
                                         result.width, result.height);
+                } else if (result.palette) {
+                    cache_->putPalette(result.tileId, result.palette);
+                } else if (result.blocks) {
+                    cache_->putBlocks(result.tileId, result.blocks);
+                } else if (result.reduced) {
+                    cache_->putChannels(result.tileId, result.reduced);
+                } else if (result.rle) {
+                    cache_->putRle(result.tileId, result.rle);
                 } else {
-                    cache_->put(result.tileId, std::move(result.data), 
+                    // The callbacks still need the pixels, so cache a copy
+                    std::vector<unsigned char> cachedData = result.data;
+                    cache_->put(result.tileId, std::move(cachedData), 
                                result.width, result.height, result.channels);
                 }
                 stats_.completedLoads++;
@@ -324,26 +302,59 @@ LoadResult AsyncTileLoader::loadTileSync(const TileLoadRequest& request) {
 LoadResult AsyncTileLoader::loadImageTile(const std::string& filePath) {
     LoadResult result;
     
-    int width, height, channels;
-    unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &channels, 4);
-    
-    if (!data) {
+    int width, height;
+    PaletteImage palette;
+    BlockImage blocks;
+    ChannelImage reduced;
+    RleImage rle;
+    if (!TilePack::loadTile(filePath, result.data, &width, &height, &palette, &blocks,
+                            &reduced, &rle)) {
         result.status = LoadStatus::Failed;
         result.error = "Failed to load image: " + filePath;
         return result;
     }
+    if (palette.width > 0) {
+        result.palette = std::make_shared<const PaletteImage>(std::move(palette));
+    } else if (blocks.width > 0) {
+        result.blocks = std::make_shared<const BlockImage>(std::move(blocks));
+    } else if (rle.width > 0) {
+        result.rle = std::make_shared<const RleImage>(std::move(rle));
+    }
     
     result.status = LoadStatus::Completed;
     result.width = width;
     result.height = height;
     result.channels = 4;
+    if (reduced.width > 0) {
+        result.channels = reduced.channels();
+        result.reduced = std::make_shared<const ChannelImage>(std::move(reduced));
+    }
     result.isPureColor = false;
     
-    size_t dataSize = width * height * 4;
-    result.data.resize(dataSize);
-    std::memcpy(result.data.data(), data, dataSize);
-    
-    stbi_image_free(data);
+    return result;
+}
+
+LoadResult AsyncTileLoader::makeCachedResult(const std::string& tileId, const CachedTile& tile) {
+    LoadResult result;
+    result.tileId = tileId;
+    result.status = LoadStatus::Completed;
+    result.isPureColor = tile.isPureColor;
+    result.pureColorValue = tile.pureColorValue;
+    result.width = tile.width;
+    result.height = tile.height;
+    result.channels = tile.channels;
+    
+    if (tile.palette) {
+        result.palette = tile.palette;
+    } else if (tile.blocks) {
+        result.blocks = tile.blocks;
+    } else if (tile.reduced) {
+        result.reduced = tile.reduced;
+    } else if (tile.rle) {
+        result.rle = tile.rle;
+    } else if (!tile.isPureColor) {
+        result.data = tile.data;
+    }
     
     return result;
 }
@@ -0,0 +1,108 @@
+#include "AtlasPacker.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <numeric>
+
+AtlasPacker::AtlasPacker(int pageWidth, int pageHeight)
+    : pageWidth_(pageWidth), pageHeight_(pageHeight) {}
+
+std::vector<AtlasPacker::Placement> AtlasPacker::pack(
+    const std::vector<int>& widths, const std::vector<int>& heights) {
+    std::vector<Placement> placements(widths.size(), Placement{-1, 0, 0});
+    extents_.clear();
+    skyline_.clear();
+
+    // 高度降序（同高按宽度降序）放入，天际线保持平整
+    std::vector<size_t> order(widths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (heights[a] != heights[b]) return heights[a] > heights[b];
+        return widths[a] > widths[b];
+    });
+
+    for (size_t i : order) {
+        int width = widths[i];
+        int height = heights[i];
+        if (width <= 0 || height <= 0 || width > pageWidth_ ||
+            height > pageHeight_) {
+            continue;
+        }
+
+        int x = 0;
+        int y = 0;
+        int index = extents_.empty() ? -1 : findPosition(width, height, x, y);
+        if (index < 0) {
+            // 当前页已放不下，开启新页
+            skyline_.assign(1, Segment{0, 0, pageWidth_});
+            extents_.push_back(PageExtent{0, 0});
+            index = findPosition(width, height, x, y);
+        }
+
+        place(index, x, y, width, height);
+        PageExtent& extent = extents_.back();
+        extent.width = std::max(extent.width, x + width);
+        extent.height = std::max(extent.height, y + height);
+        placements[i] = Placement{static_cast<int>(extents_.size()) - 1, x, y};
+    }
+    return placements;
+}
+
+int AtlasPacker::findPosition(int width, int height, int& bestX,
+                              int& bestY) const {
+    int bestIndex = -1;
+    int bestBottom = INT_MAX;
+    for (size_t i = 0; i < skyline_.size(); ++i) {
+        int x = skyline_[i].x;
+        if (x + width > pageWidth_) {
+            break;
+        }
+
+        // 矩形跨越的各段中最高者决定放置高度
+        int y = 0;
+        int remaining = width;
+        for (size_t j = i; remaining > 0; ++j) {
+            y = std::max(y, skyline_[j].y);
+            remaining -= skyline_[j].width;
+        }
+        if (y + height > pageHeight_) {
+            continue;
+        }
+        if (y + height < bestBottom) {
+            bestBottom = y + height;
+            bestIndex = static_cast<int>(i);
+            bestX = x;
+            bestY = y;
+        }
+    }
+    return bestIndex;
+}
+
+void AtlasPacker::place(int index, int x, int y, int width, int height) {
+    // 新段覆盖 [x, x + width)，被完全覆盖的段删除，部分覆盖的段截短
+    skyline_.insert(skyline_.begin() + index, Segment{x, y + height, width});
+    size_t next = index + 1;
+    while (next < skyline_.size()) {
+        Segment& segment = skyline_[next];
+        int covered = x + width - segment.x;
+        if (covered <= 0) {
+            break;
+        }
+        if (covered < segment.width) {
+            segment.x += covered;
+            segment.width -= covered;
+            break;
+        }
+        skyline_.erase(skyline_.begin() + next);
+    }
+
+    // 合并等高的相邻段
+    for (size_t i = 0; i + 1 < skyline_.size();) {
+        if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,275 @@
+#include "BinaryMeta.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BINARYMETA_HAVE_MMAP 1
+#endif
+
+namespace {
+
+const char kMetaMagic[8] = {'M', 'F', 'T', 'M', 'E', 'T', 'A', '1'};
+constexpr size_t kMetaHeaderSize = 64;
+
+void putLE(unsigned char* p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+uint64_t getLE(const unsigned char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+bool isLittleEndianHost() {
+    const uint32_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+}  // namespace
+
+BinaryMeta::~BinaryMeta() { close(); }
+
+void BinaryMeta::close() {
+#ifdef BINARYMETA_HAVE_MMAP
+    if (mapped_) {
+        munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+    levelFirst_.clear();
+    levelCount_.clear();
+    records_ = nullptr;
+    strings_ = nullptr;
+    info_ = Info();
+}
+
+bool BinaryMeta::isBinaryMeta(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    char magic[sizeof(kMetaMagic)];
+    bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+              std::memcmp(magic, kMetaMagic, sizeof(magic)) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+bool BinaryMeta::open(const std::string& path) {
+    close();
+    if (!isLittleEndianHost()) return false;
+
+#ifdef BINARYMETA_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<uint64_t>(st.st_size) < kMetaHeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+    data_ = static_cast<const unsigned char*>(addr);
+    size_ = fileSize;
+    mapped_ = true;
+#else
+    std::error_code ec;
+    size_t fileSize = static_cast<size_t>(std::filesystem::file_size(path, ec));
+    if (ec || fileSize < kMetaHeaderSize) return false;
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    buffer_.resize(fileSize);
+    bool ok = std::fread(buffer_.data(), 1, fileSize, file) == fileSize;
+    std::fclose(file);
+    if (!ok) {
+        close();
+        return false;
+    }
+    data_ = buffer_.data();
+    size_ = fileSize;
+#endif
+
+    const unsigned char* header = data_;
+    if (std::memcmp(header, kMetaMagic, sizeof(kMetaMagic)) != 0 ||
+        getLE(header + 8, 4) != kVersion) {
+        close();
+        return false;
+    }
+    uint32_t codec = static_cast<uint32_t>(getLE(header + 12, 4));
+    info_.codec = codec <= static_cast<uint32_t>(TileCodec::Type::Bc3)
+                      ? static_cast<TileCodec::Type>(codec)
+                      : TileCodec::Type::Png;
+    info_.mapWidth = static_cast<int32_t>(getLE(header + 16, 4));
+    info_.mapHeight = static_cast<int32_t>(getLE(header + 20, 4));
+    info_.declaredWidth = static_cast<int32_t>(getLE(header + 24, 4));
+    info_.declaredHeight = static_cast<int32_t>(getLE(header + 28, 4));
+    uint64_t lodLevels = getLE(header + 32, 4);
+    uint64_t recordCount = getLE(header + 36, 4);
+    uint64_t stringsOffset = getLE(header + 40, 8);
+    uint64_t stringsSize = getLE(header + 48, 8);
+
+    // 各区必须依次落在文件内
+    uint64_t levelsOffset = kMetaHeaderSize;
+    uint64_t recordsOffset = levelsOffset + (lodLevels + 1) * 8;
+    uint64_t recordsEnd = recordsOffset + recordCount * sizeof(Record);
+    if (lodLevels > 255 || recordsEnd > stringsOffset ||
+        stringsOffset + stringsSize > size_) {
+        close();
+        return false;
+    }
+
+    uint64_t total = 0;
+    for (uint64_t level = 0; level <= lodLevels; ++level) {
+        const unsigned char* entry = data_ + levelsOffset + level * 8;
+        uint32_t first = static_cast<uint32_t>(getLE(entry, 4));
+        uint32_t count = static_cast<uint32_t>(getLE(entry + 4, 4));
+        if (first != total || first + static_cast<uint64_t>(count) >
+                                  recordCount) {
+            close();
+            return false;
+        }
+        levelFirst_.push_back(first);
+        levelCount_.push_back(count);
+        total += count;
+    }
+    if (total != recordCount) {
+        close();
+        return false;
+    }
+    info_.lodLevels = static_cast<int>(lodLevels);
+    records_ = reinterpret_cast<const Record*>(data_ + recordsOffset);
+    strings_ = reinterpret_cast<const char*>(data_ + stringsOffset);
+
+    // 文件名范围只在打开时检查一次，之后按记录直接访问
+    for (uint64_t i = 0; i < recordCount; ++i) {
+        const Record& record = records_[i];
+        if (record.nameOffset + static_cast<uint64_t>(record.nameLength) >
+            stringsSize) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+const BinaryMeta::Record* BinaryMeta::records(int level,
+                                              size_t& count) const {
+    if (level < 0 || static_cast<size_t>(level) >= levelCount_.size()) {
+        count = 0;
+        return nullptr;
+    }
+    count = levelCount_[level];
+    return records_ + levelFirst_[level];
+}
+
+TileMeta BinaryMeta::toTileMeta(const Record& record) const {
+    TileMeta meta;
+    meta.x = record.x;
+    meta.y = record.y;
+    meta.w = record.w;
+    meta.h = record.h;
+    meta.file.assign(name(record), record.nameLength);
+    meta.srcX = record.srcX;
+    meta.srcY = record.srcY;
+    meta.lod = record.lod;
+    meta.err = record.err;
+    return meta;
+}
+
+bool BinaryMeta::write(const std::string& path, const Info& info,
+                       const std::vector<TileMeta>& tiles) {
+    // 级别表与字符串表
+    int lodLevels = 0;
+    for (const auto& m : tiles) {
+        if (m.lod < lodLevels || m.lod > 255 ||
+            m.file.size() > 0xFFFF) {
+            return false;
+        }
+        lodLevels = m.lod;
+    }
+    std::vector<uint32_t> levelCount(lodLevels + 1, 0);
+    std::vector<unsigned char> records(tiles.size() * sizeof(Record));
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> stringOffsets;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const TileMeta& m = tiles[i];
+        ++levelCount[m.lod];
+        auto inserted = stringOffsets.emplace(
+            m.file, static_cast<uint32_t>(strings.size()));
+        if (inserted.second) {
+            strings += m.file;
+        }
+
+        unsigned char* p = &records[i * sizeof(Record)];
+        putLE(p, static_cast<uint32_t>(m.x), 4);
+        putLE(p + 4, static_cast<uint32_t>(m.y), 4);
+        putLE(p + 8, static_cast<uint32_t>(m.w), 4);
+        putLE(p + 12, static_cast<uint32_t>(m.h), 4);
+        putLE(p + 16, static_cast<uint32_t>(m.srcX), 4);
+        putLE(p + 20, static_cast<uint32_t>(m.srcY), 4);
+        putLE(p + 24, inserted.first->second, 4);
+        putLE(p + 28, m.file.size(), 2);
+        p[30] = static_cast<unsigned char>(m.lod);
+        p[31] = static_cast<unsigned char>(std::min(std::max(m.err, 0), 255));
+    }
+
+    std::vector<unsigned char> levels(levelCount.size() * 8);
+    uint32_t first = 0;
+    for (size_t level = 0; level < levelCount.size(); ++level) {
+        putLE(&levels[level * 8], first, 4);
+        putLE(&levels[level * 8 + 4], levelCount[level], 4);
+        first += levelCount[level];
+    }
+
+    uint64_t stringsOffset = kMetaHeaderSize + levels.size() + records.size();
+    unsigned char header[kMetaHeaderSize] = {};
+    std::memcpy(header, kMetaMagic, sizeof(kMetaMagic));
+    putLE(header + 8, kVersion, 4);
+    putLE(header + 12, static_cast<uint32_t>(info.codec), 4);
+    putLE(header + 16, static_cast<uint32_t>(info.mapWidth), 4);
+    putLE(header + 20, static_cast<uint32_t>(info.mapHeight), 4);
+    putLE(header + 24, static_cast<uint32_t>(info.declaredWidth), 4);
+    putLE(header + 28, static_cast<uint32_t>(info.declaredHeight), 4);
+    putLE(header + 32, static_cast<uint32_t>(lodLevels), 4);
+    putLE(header + 36, tiles.size(), 4);
+    putLE(header + 40, stringsOffset, 8);
+    putLE(header + 48, strings.size(), 8);
+
+    std::string tmpPath = path + ".tmp";
+    FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok =
+        std::fwrite(header, 1, kMetaHeaderSize, file) == kMetaHeaderSize &&
+        std::fwrite(levels.data(), 1, levels.size(), file) == levels.size() &&
+        std::fwrite(records.data(), 1, records.size(), file) ==
+            records.size() &&
+        std::fwrite(strings.data(), 1, strings.size(), file) ==
+            strings.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
@@ -1,6 +1,252 @@
 #include "ColorChecker.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define COLORCHECKER_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(COLORCHECKER_HAVE_SSE2) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define COLORCHECKER_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**
+ * @brief 标量行比较：检查一行中的 count 个像素是否都与参考像素匹配
+ *
+ * 像素按内存中的 RGBA 字节比较；tolerance 为 0 时整字比较。
+ */
+bool rowMatchesScalar(const unsigned char* row, int count,
+                      const unsigned char* ref, int tolerance) {
+    if (tolerance == 0) {
+        uint32_t refWord;
+        std::memcpy(&refWord, ref, 4);
+        for (int i = 0; i < count; ++i) {
+            uint32_t word;
+            std::memcpy(&word, row + i * 4, 4);
+            if (word != refWord) return false;
+        }
+        return true;
+    }
+    for (int i = 0; i < count; ++i) {
+        const unsigned char* p = row + i * 4;
+        for (int c = 0; c < 4; ++c) {
+            if (std::abs(static_cast<int>(p[c]) - ref[c]) > tolerance) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+#ifdef COLORCHECKER_HAVE_SSE2
+/**
+ * @brief SSE2 行比较，每次处理4个像素
+ *
+ * 容差比较使用无符号饱和减法求逐字节绝对差，再减去容差判断是否为0。
+ * tolerance 必须在 [0, 254] 范围内。
+ */
+bool rowMatchesSse2(const unsigned char* row, int count,
+                    const unsigned char* ref, int tolerance) {
+    uint32_t refWord;
+    std::memcpy(&refWord, ref, 4);
+    const __m128i refVec = _mm_set1_epi32(static_cast<int>(refWord));
+    int i = 0;
+    if (tolerance == 0) {
+        for (; i + 4 <= count; i += 4) {
+            __m128i px = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(row + i * 4));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(px, refVec)) != 0xFFFF) {
+                return false;
+            }
+        }
+    } else {
+        const __m128i tolVec = _mm_set1_epi8(static_cast<char>(tolerance));
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 4 <= count; i += 4) {
+            __m128i px = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(row + i * 4));
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(px, refVec),
+                                        _mm_subs_epu8(refVec, px));
+            __m128i over = _mm_subs_epu8(diff, tolVec);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(over, zero)) != 0xFFFF) {
+                return false;
+            }
+        }
+    }
+    return rowMatchesScalar(row + i * 4, count - i, ref, tolerance);
+}
+#endif
+
+#ifdef COLORCHECKER_HAVE_SSE2
+/**
+ * @brief SSE2 区域比较：逐行调用 rowMatchesSse2，遇到不匹配的行立即返回
+ */
+bool regionMatchesSse2(const unsigned char* ref, size_t stride, int width,
+                       int height, int tolerance) {
+    for (int dy = 0; dy < height; ++dy) {
+        if (!rowMatchesSse2(ref + dy * stride, width, ref, tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+#ifdef COLORCHECKER_HAVE_AVX2
+/**
+ * @brief AVX2 区域比较，每次处理8个像素；仅在运行时检测到 AVX2 时调用
+ *
+ * 整个区域在一次调用内完成（行尾不足8个像素的部分也在本函数内处理），
+ * 避免每行进出 AVX 状态带来的切换开销。
+ */
+__attribute__((target("avx2"))) bool regionMatchesAvx2(
+    const unsigned char* ref, size_t stride, int width, int height,
+    int tolerance) {
+    uint32_t refWord;
+    std::memcpy(&refWord, ref, 4);
+    const __m256i refVec = _mm256_set1_epi32(static_cast<int>(refWord));
+    const __m256i tolVec = _mm256_set1_epi8(static_cast<char>(tolerance));
+    const __m256i zero = _mm256_setzero_si256();
+    const int vecEnd = width & ~7;
+
+    for (int dy = 0; dy < height; ++dy) {
+        const unsigned char* row = ref + dy * stride;
+        for (int i = 0; i < vecEnd; i += 8) {
+            __m256i px = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(row + i * 4));
+            __m256i eq;
+            if (tolerance == 0) {
+                eq = _mm256_cmpeq_epi32(px, refVec);
+            } else {
+                __m256i diff = _mm256_or_si256(_mm256_subs_epu8(px, refVec),
+                                               _mm256_subs_epu8(refVec, px));
+                eq = _mm256_cmpeq_epi8(_mm256_subs_epu8(diff, tolVec), zero);
+            }
+            if (_mm256_movemask_epi8(eq) != -1) {
+                return false;
+            }
+        }
+        // 行尾剩余像素
+        for (int i = vecEnd; i < width; ++i) {
+            const unsigned char* p = row + i * 4;
+            for (int c = 0; c < 4; ++c) {
+                int diff = static_cast<int>(p[c]) - ref[c];
+                if (diff > tolerance || -diff > tolerance) return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+#ifdef COLORCHECKER_HAVE_SSE2
+/**
+ * @brief SSE2 区域最小/最大值累积，每次处理4个像素
+ */
+void accumulateRangeSse2(const unsigned char* origin, size_t stride,
+                         int width, int height,
+                         ColorChecker::ColorRange& range) {
+    __m128i vlo = _mm_set1_epi8(static_cast<char>(0xFF));
+    __m128i vhi = _mm_setzero_si128();
+    const int vecEnd = width & ~3;
+    for (int dy = 0; dy < height; ++dy) {
+        const unsigned char* row = origin + dy * stride;
+        for (int i = 0; i < vecEnd; i += 4) {
+            __m128i px = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(row + i * 4));
+            vlo = _mm_min_epu8(vlo, px);
+            vhi = _mm_max_epu8(vhi, px);
+        }
+        for (int i = vecEnd; i < width; ++i) {
+            const unsigned char* p = row + i * 4;
+            for (int c = 0; c < 4; ++c) {
+                if (p[c] < range.lo[c]) range.lo[c] = p[c];
+                if (p[c] > range.hi[c]) range.hi[c] = p[c];
+            }
+        }
+    }
+
+    // 归约4个像素通道
+    alignas(16) unsigned char lo[16];
+    alignas(16) unsigned char hi[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lo), vlo);
+    _mm_store_si128(reinterpret_cast<__m128i*>(hi), vhi);
+    for (int lane = 0; lane < 4; ++lane) {
+        for (int c = 0; c < 4; ++c) {
+            if (lo[lane * 4 + c] < range.lo[c]) range.lo[c] = lo[lane * 4 + c];
+            if (hi[lane * 4 + c] > range.hi[c]) range.hi[c] = hi[lane * 4 + c];
+        }
+    }
+}
+#endif
+
+using RegionMatchFn = bool (*)(const unsigned char*, size_t, int, int, int);
+
+#ifndef COLORCHECKER_HAVE_SSE2
+/**
+ * @brief 标量区域比较（无 SSE2 的平台使用）
+ */
+bool regionMatchesScalar(const unsigned char* ref, size_t stride, int width,
+                         int height, int tolerance) {
+    for (int dy = 0; dy < height; ++dy) {
+        if (!rowMatchesScalar(ref + dy * stride, width, ref, tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/**
+ * @brief 区域宽度达到该值时才使用 AVX2 内核
+ *
+ * 进出 AVX 状态有固定开销，窄区域用 SSE2 更快。
+ */
+constexpr int kAvx2MinWidth = 64;
+
+/**
+ * @brief 检测CPU是否支持 AVX2（只检测一次）
+ */
+bool cpuHasAvx2() {
+#ifdef COLORCHECKER_HAVE_AVX2
+    static const bool hasAvx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return hasAvx2;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 根据CPU能力和区域宽度选择区域比较内核
+ */
+RegionMatchFn selectRegionKernel(int width) {
+#ifdef COLORCHECKER_HAVE_AVX2
+    if (width >= kAvx2MinWidth && cpuHasAvx2()) {
+        return regionMatchesAvx2;
+    }
+#endif
+#ifdef COLORCHECKER_HAVE_SSE2
+    (void)width;
+    return regionMatchesSse2;
+#else
+    (void)width;
+    return regionMatchesScalar;
+#endif
+}
+
+}  // namespace
 
 bool ColorChecker::isUniformColor(const unsigned char* imageData,
                                   int imageWidth, int x, int y, int width,
@@ -12,6 +258,53 @@ bool ColorChecker::isUniformColor(const unsigned char* imageData,
     // 获取第一个像素的颜色作为参考
     color = getPixelColor(imageData, imageWidth, x, y);
 
+    bool uniform;
+    if (!simdEnabled_) {
+        uniform = isUniformColorScalar(imageData, imageWidth, x, y, width,
+                                       height, color);
+    } else if (isTransparent(color)) {
+        // 参考像素透明：区域内所有像素都透明才算一致
+        uniform = computeRange(imageData, imageWidth, x, y, width, height)
+                      .hi[3] <= transparentAlpha_;
+    } else {
+        uniform = matchesReference(imageData, imageWidth, x, y, width, height);
+        // 容差范围内可能有透明像素，它们与不透明的参考像素不相等
+        if (uniform && transparentAlpha_ >= 0 &&
+            static_cast<int>(color & 0xFF) - colorTolerance_ <=
+                transparentAlpha_) {
+            uniform = computeRange(imageData, imageWidth, x, y, width, height)
+                          .lo[3] > transparentAlpha_;
+        }
+    }
+    if (uniform && isTransparent(color)) {
+        color = 0;
+    }
+    return uniform;
+}
+
+bool ColorChecker::matchesReference(const unsigned char* imageData,
+                                    int imageWidth, int x, int y, int width,
+                                    int height) const {
+    // 负容差下任何颜色都不相等；容差达到255时所有颜色都相等
+    if (colorTolerance_ < 0) {
+        return false;
+    }
+    if (colorTolerance_ >= 255) {
+        return true;
+    }
+
+    // 逐行与参考像素比较，遇到第一个不匹配的像素立即返回
+    const size_t stride = static_cast<size_t>(imageWidth) * 4;
+    const unsigned char* ref = imageData + static_cast<size_t>(y) * stride +
+                               static_cast<size_t>(x) * 4;
+    return selectRegionKernel(width)(ref, stride, width, height,
+                                     colorTolerance_);
+}
+
+bool ColorChecker::isUniformColorScalar(const unsigned char* imageData,
+                                        int imageWidth, int x, int y,
+                                        int width, int height,
+                                        uint32_t color) const {
     // 检查区域内所有像素是否与参考颜色相同
     for (int dy = 0; dy < height; ++dy) {
         for (int dx = 0; dx < width; ++dx) {
@@ -26,6 +319,175 @@ bool ColorChecker::isUniformColor(const unsigned char* imageData,
     return true;
 }
 
+ColorChecker::ColorRange ColorChecker::computeRange(
+    const unsigned char* imageData, int imageWidth, int x, int y, int width,
+    int height) const {
+    ColorRange range;
+    if (!imageData || width <= 0 || height <= 0) {
+        return range;
+    }
+
+    const size_t stride = static_cast<size_t>(imageWidth) * 4;
+    const unsigned char* origin = imageData + static_cast<size_t>(y) * stride +
+                                  static_cast<size_t>(x) * 4;
+#ifdef COLORCHECKER_HAVE_SSE2
+    if (simdEnabled_) {
+        accumulateRangeSse2(origin, stride, width, height, range);
+        return range;
+    }
+#endif
+    for (int dy = 0; dy < height; ++dy) {
+        const unsigned char* row = origin + dy * stride;
+        for (int dx = 0; dx < width; ++dx) {
+            const unsigned char* p = row + dx * 4;
+            for (int c = 0; c < 4; ++c) {
+                if (p[c] < range.lo[c]) range.lo[c] = p[c];
+                if (p[c] > range.hi[c]) range.hi[c] = p[c];
+            }
+        }
+    }
+    return range;
+}
+
+ColorChecker::ColorStats ColorChecker::computeStats(
+    const unsigned char* imageData, int imageWidth, int x, int y, int width,
+    int height) {
+    ColorStats stats;
+    if (!imageData || width <= 0 || height <= 0) {
+        return stats;
+    }
+
+    const size_t stride = static_cast<size_t>(imageWidth) * 4;
+    const unsigned char* origin = imageData + static_cast<size_t>(y) * stride +
+                                  static_cast<size_t>(x) * 4;
+    for (int dy = 0; dy < height; ++dy) {
+        // 每行先用 32 位累加，行宽不超过 2^16 时不会溢出
+        uint32_t rowSum[4] = {};
+        uint64_t rowSquares[4] = {};
+        const unsigned char* row = origin + dy * stride;
+        for (int dx = 0; dx < width; ++dx) {
+            const unsigned char* p = row + dx * 4;
+            for (int c = 0; c < 4; ++c) {
+                rowSum[c] += p[c];
+                rowSquares[c] += static_cast<uint32_t>(p[c]) * p[c];
+                if (p[c] < stats.range.lo[c]) stats.range.lo[c] = p[c];
+                if (p[c] > stats.range.hi[c]) stats.range.hi[c] = p[c];
+            }
+        }
+        for (int c = 0; c < 4; ++c) {
+            stats.sum[c] += rowSum[c];
+            stats.sumSquares[c] += rowSquares[c];
+        }
+    }
+    stats.count = static_cast<uint64_t>(width) * height;
+    return stats;
+}
+
+uint32_t ColorChecker::ColorStats::meanColor() const {
+    if (count == 0) {
+        return 0;
+    }
+    uint32_t color = 0;
+    for (int c = 0; c < 4; ++c) {
+        uint64_t mean = (sum[c] + count / 2) / count;
+        color = (color << 8) | static_cast<uint32_t>(mean);
+    }
+    return color;
+}
+
+int ColorChecker::ColorStats::maxError(uint32_t color) const {
+    int error = 0;
+    for (int c = 0; c < 4 && count > 0; ++c) {
+        int value = (color >> (24 - 8 * c)) & 0xFF;
+        error = std::max(error, std::max(value - range.lo[c],
+                                         range.hi[c] - value));
+    }
+    return error;
+}
+
+double ColorChecker::ColorStats::meanSquaredError(uint32_t color) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    // sum((p - v)^2) = sum(p^2) - 2 * v * sum(p) + n * v^2
+    double total = 0.0;
+    for (int c = 0; c < 4; ++c) {
+        double value = (color >> (24 - 8 * c)) & 0xFF;
+        total += static_cast<double>(sumSquares[c]) -
+                 2.0 * value * static_cast<double>(sum[c]) +
+                 static_cast<double>(count) * value * value;
+    }
+    return std::max(0.0, total / (4.0 * static_cast<double>(count)));
+}
+
+bool ColorChecker::opaqueBounds(const unsigned char* imageData,
+                                int imageWidth, int x, int y, int width,
+                                int height, int& boundX, int& boundY,
+                                int& boundWidth, int& boundHeight) {
+    int top = -1;
+    int bottom = -1;
+    int left = width;
+    int right = -1;
+    for (int dy = 0; dy < height; ++dy) {
+        const unsigned char* row =
+            imageData + (static_cast<size_t>(y + dy) * imageWidth + x) * 4;
+        int first = 0;
+        while (first < width && row[first * 4 + 3] == 0) {
+            ++first;
+        }
+        if (first == width) {
+            continue;
+        }
+        int last = width - 1;
+        while (row[last * 4 + 3] == 0) {
+            --last;
+        }
+        if (top < 0) {
+            top = dy;
+        }
+        bottom = dy;
+        left = std::min(left, first);
+        right = std::max(right, last);
+    }
+    if (top < 0) {
+        return false;
+    }
+    boundX = x + left;
+    boundY = y + top;
+    boundWidth = right - left + 1;
+    boundHeight = bottom - top + 1;
+    return true;
+}
+
+bool ColorChecker::isUniformRange(const ColorRange& range,
+                                  uint32_t referenceColor) const {
+    if (isTransparent(referenceColor)) {
+        return range.hi[3] <= transparentAlpha_;
+    }
+    if (colorTolerance_ < 0 ||
+        (transparentAlpha_ >= 0 && range.lo[3] <= transparentAlpha_)) {
+        return false;
+    }
+    for (int c = 0; c < 4; ++c) {
+        int ref = (referenceColor >> (24 - 8 * c)) & 0xFF;
+        // 所有像素都在 [ref - tol, ref + tol] 内等价于最小/最大值都在其中
+        if (ref - range.lo[c] > colorTolerance_ ||
+            range.hi[c] - ref > colorTolerance_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* ColorChecker::simdKernelName() {
+    if (cpuHasAvx2()) return "avx2";
+#ifdef COLORCHECKER_HAVE_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
 bool ColorChecker::isUniformColor(const unsigned char* imageData,
                                   int imageWidth, int x, int y, int width,
                                   int height) const {
@@ -47,6 +509,9 @@ uint32_t ColorChecker::getPixelColor(const unsigned char* imageData,
 }
 
 bool ColorChecker::colorsEqual(uint32_t color1, uint32_t color2) const {
+    if (isTransparent(color1) || isTransparent(color2)) {
+        return isTransparent(color1) && isTransparent(color2);
+    }
     if (colorTolerance_ == 0) {
         // 严格相等
         return color1 == color2;
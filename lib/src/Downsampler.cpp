@@ -0,0 +1,141 @@
+#include "Downsampler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define DOWNSAMPLER_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+std::atomic<bool> simdEnabled{true};
+
+/**
+ * @brief 标量内核：计算一行输出中 [begin, end) 列的像素
+ *
+ * row1 为奇数高度图像的最后一行时与 row0 相同；
+ * 最后一列的块在奇数宽度时复制边缘像素。
+ * RGB 为按 alpha 加权的平均值 round(Σc·a / Σa)（Σa 为 0 时为 0），
+ * alpha 为四个像素的平均值。
+ */
+void halveRowScalar(const unsigned char* row0, const unsigned char* row1,
+                    int width, int begin, int end, unsigned char* out) {
+    for (int i = begin; i < end; ++i) {
+        int x0 = 2 * i;
+        int x1 = std::min(x0 + 1, width - 1);
+        const unsigned char* block[4] = {row0 + x0 * 4, row0 + x1 * 4,
+                                         row1 + x0 * 4, row1 + x1 * 4};
+        int alphaSum = 0;
+        int sums[3] = {0, 0, 0};
+        for (const unsigned char* p : block) {
+            alphaSum += p[3];
+            for (int c = 0; c < 3; ++c) {
+                sums[c] += p[c] * p[3];
+            }
+        }
+        for (int c = 0; c < 3; ++c) {
+            out[i * 4 + c] = static_cast<unsigned char>(
+                alphaSum ? (2 * sums[c] + alphaSum) / (2 * alphaSum) : 0);
+        }
+        out[i * 4 + 3] = static_cast<unsigned char>((alphaSum + 2) >> 2);
+    }
+}
+
+#ifdef DOWNSAMPLER_HAVE_SSE2
+/**
+ * @brief SSE2 内核：每次由两行各8个像素得到4个输出像素
+ *
+ * 每个输出像素的四个通道放在一个浮点向量中计算。乘积和与 alpha 和都
+ * 小于 2^24，在单精度下是精确的；商与 k + 0.5 不相等时至少相差
+ * 1 / (2Σa)，远大于舍入误差，因此 +0.5 截断与标量内核的整数舍入
+ * 逐字节一致。
+ *
+ * @return 已处理的输出像素数
+ */
+int halveRowSse2(const unsigned char* row0, const unsigned char* row1,
+                 int width, unsigned char* out) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 alphaLane = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+    const int count = width / 8 * 4;
+
+    // 低 4 个16位通道（一个像素）转为浮点
+    auto pixel = [&](__m128i bytes16) {
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(bytes16, zero));
+    };
+    // 由两行各两个像素（已扩展为16位）得到一个输出像素的32位整数
+    auto average = [&](__m128i top, __m128i bottom) {
+        __m128 p[4] = {pixel(top), pixel(_mm_srli_si128(top, 8)),
+                       pixel(bottom), pixel(_mm_srli_si128(bottom, 8))};
+        __m128 weighted = _mm_setzero_ps();
+        __m128 alphaSum = _mm_setzero_ps();
+        for (const __m128& v : p) {
+            __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+            weighted = _mm_add_ps(weighted, _mm_mul_ps(v, a));
+            alphaSum = _mm_add_ps(alphaSum, a);
+        }
+        // Σa 为 0 时 Σc·a 也为 0，分母取 1 即得 0
+        __m128 color = _mm_add_ps(
+            _mm_div_ps(weighted, _mm_max_ps(alphaSum, one)), half);
+        __m128 alpha = _mm_mul_ps(_mm_add_ps(alphaSum, two), quarter);
+        return _mm_cvttps_epi32(_mm_or_ps(_mm_andnot_ps(alphaLane, color),
+                                          _mm_and_ps(alphaLane, alpha)));
+    };
+
+    for (int i = 0; i < count; i += 4) {
+        const size_t offset = static_cast<size_t>(i) * 8;
+        __m128i result[4];
+        for (int part = 0; part < 2; ++part) {
+            const size_t at = offset + part * 16;
+            __m128i a = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(row0 + at));
+            __m128i b = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(row1 + at));
+            result[part * 2] = average(_mm_unpacklo_epi8(a, zero),
+                                         _mm_unpacklo_epi8(b, zero));
+            result[part * 2 + 1] = average(_mm_unpackhi_epi8(a, zero),
+                                             _mm_unpackhi_epi8(b, zero));
+        }
+        __m128i lo = _mm_packs_epi32(result[0], result[1]);
+        __m128i hi = _mm_packs_epi32(result[2], result[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4),
+                         _mm_packus_epi16(lo, hi));
+    }
+    return count;
+}
+#endif
+
+}  // namespace
+
+void Downsampler::setSimdEnabled(bool enabled) { simdEnabled = enabled; }
+
+void Downsampler::halve(const unsigned char* src, int width, int height,
+                        std::vector<unsigned char>& dst) {
+    const int outWidth = halfSize(width);
+    const int outHeight = halfSize(height);
+    dst.resize(static_cast<size_t>(outWidth) * outHeight * 4);
+    const size_t stride = static_cast<size_t>(width) * 4;
+    const bool simd = simdEnabled;
+
+    for (int y = 0; y < outHeight; ++y) {
+        const unsigned char* row0 = src + 2 * y * stride;
+        const unsigned char* row1 = 2 * y + 1 < height ? row0 + stride : row0;
+        unsigned char* out = &dst[static_cast<size_t>(y) * outWidth * 4];
+        int done = 0;
+#ifdef DOWNSAMPLER_HAVE_SSE2
+        if (simd) {
+            done = halveRowSse2(row0, row1, width, out);
+        }
+#else
+        (void)simd;
+#endif
+        halveRowScalar(row0, row1, width, done, outWidth, out);
+    }
+}
@@ -0,0 +1,80 @@
+#include "EncodeCache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+#include "TileWriter.hpp"
+
+EncodeCache::EncodeCache(std::string dir) : dir_(std::move(dir)) {}
+
+std::string EncodeCache::entryPath(const std::pair<uint64_t, uint64_t>& key,
+                                   TileCodec::Type codec) const {
+    const std::string hex = TileWriter::hashToHex(key);
+    return dir_ + "/v" + std::to_string(kFormatVersion) + "/" +
+           hex.substr(0, 2) + "/" + hex + TileCodec::extension(codec);
+}
+
+bool EncodeCache::load(const std::pair<uint64_t, uint64_t>& key,
+                       TileCodec::Type codec,
+                       std::vector<unsigned char>& out) {
+    std::string path = entryPath(key, codec);
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        ++misses_;
+        return false;
+    }
+
+    bool ok = std::fseek(file, 0, SEEK_END) == 0;
+    long size = ok ? std::ftell(file) : -1;
+    ok = size > 0 && std::fseek(file, 0, SEEK_SET) == 0;
+    if (ok) {
+        out.resize(static_cast<size_t>(size));
+        ok = std::fread(out.data(), 1, out.size(), file) == out.size();
+    }
+    std::fclose(file);
+    if (!ok) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    return true;
+}
+
+void EncodeCache::store(const std::pair<uint64_t, uint64_t>& key,
+                        TileCodec::Type codec,
+                        const std::vector<unsigned char>& data) {
+    namespace fs = std::filesystem;
+    std::string path = entryPath(key, codec);
+    std::error_code ec;
+
+    // 临时文件名由线程和时钟区分，同时写同一条目的线程或进程互不覆盖；
+    // 改名是原子的，读者不会看到写了一半的条目
+    std::string tempPath =
+        path + ".tmp" +
+        std::to_string(
+            std::hash<std::thread::id>()(std::this_thread::get_id())) +
+        "_" +
+        std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        // 目录只在首次写入该前缀时创建
+        fs::create_directories(fs::path(path).parent_path(), ec);
+        file = ec ? nullptr : std::fopen(tempPath.c_str(), "wb");
+        if (!file) {
+            return;
+        }
+    }
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (ok) {
+        fs::rename(tempPath, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        fs::remove(tempPath, ec);
+    }
+}
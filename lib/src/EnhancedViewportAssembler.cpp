@@ -1,11 +1,13 @@
 #include "EnhancedViewportAssembler.hpp"
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
-#include "stb_image.h"
+#include <unordered_map>
+#include "TilePack.hpp"
 #include "stb_image_write.h"
 
 EnhancedViewportAssembler::EnhancedViewportAssembler(std::shared_ptr<TileCache> cache,
@@ -48,10 +50,7 @@ bool EnhancedViewportAssembler::assemble(const TileIndex& index, const Viewport&
     if (config_.enableAsyncLoading && loader_) {
         tileData = loadTilesAsync(tiles, resourceDir);
     } else {
-        tileData.reserve(tiles.size());
-        for (const auto& tileMeta : tiles) {
-            tileData.push_back(loadTileSync(tileMeta, resourceDir));
-        }
+        tileData = loadTilesSync(tiles, resourceDir);
     }
     
     renderTilesOnCanvas(canvas, vp, tiles, tileData);
@@ -96,10 +95,7 @@ std::string EnhancedViewportAssembler::assembleToHex(const TileIndex& index, con
     if (config_.enableAsyncLoading && loader_) {
         tileData = loadTilesAsync(tiles, resourceDir);
     } else {
-        tileData.reserve(tiles.size());
-        for (const auto& tileMeta : tiles) {
-            tileData.push_back(loadTileSync(tileMeta, resourceDir));
-        }
+        tileData = loadTilesSync(tiles, resourceDir);
     }
     
     renderTilesOnCanvas(canvas, vp, tiles, tileData);
@@ -219,6 +215,114 @@ void EnhancedViewportAssembler::blit(std::vector<unsigned char>& canvas, int can
     }
 }
 
+void EnhancedViewportAssembler::blitPalette(std::vector<unsigned char>& canvas,
+                                           int canvas_w, int canvas_h,
+                                           const PaletteImage& image, int srcX, int srcY,
+                                           int sw, int sh, int dstX, int dstY) const {
+    // Expand one visible row at a time so the blend matches blit exactly
+    int firstX = std::max(0, -dstX);
+    int lastX = std::min(sw, canvas_w - dstX);
+    if (firstX >= lastX) return;
+    std::vector<unsigned char> row(static_cast<size_t>(lastX - firstX) * 4);
+    for (int y = 0; y < sh; ++y) {
+        if (dstY + y < 0 || dstY + y >= canvas_h) continue;
+        for (int x = firstX; x < lastX; ++x) {
+            std::memcpy(&row[(x - firstX) * 4], image.color(srcX + x, srcY + y), 4);
+        }
+        blit(canvas, canvas_w, canvas_h, row.data(), lastX - firstX, 1,
+             static_cast<int>(row.size()), dstX + firstX, dstY + y);
+    }
+}
+
+void EnhancedViewportAssembler::blitBlocks(std::vector<unsigned char>& canvas,
+                                          int canvas_w, int canvas_h,
+                                          const BlockImage& image, int srcX, int srcY,
+                                          int sw, int sh, int dstX, int dstY) const {
+    // Decode only the blocks under the visible part of the tile
+    int firstX = std::max(0, -dstX);
+    int lastX = std::min(sw, canvas_w - dstX);
+    int firstY = std::max(0, -dstY);
+    int lastY = std::min(sh, canvas_h - dstY);
+    if (firstX >= lastX || firstY >= lastY) return;
+    int w = lastX - firstX;
+    int h = lastY - firstY;
+    std::vector<unsigned char> pixels(static_cast<size_t>(w) * h * 4);
+    image.decodeRegion(srcX + firstX, srcY + firstY, w, h, pixels.data());
+    blit(canvas, canvas_w, canvas_h, pixels.data(), w, h, w * 4,
+         dstX + firstX, dstY + firstY);
+}
+
+void EnhancedViewportAssembler::blitChannels(std::vector<unsigned char>& canvas,
+                                            int canvas_w, int canvas_h,
+                                            const ChannelImage& image, int srcX, int srcY,
+                                            int sw, int sh, int dstX, int dstY) const {
+    int firstX = std::max(0, -dstX);
+    int lastX = std::min(sw, canvas_w - dstX);
+    if (firstX >= lastX) return;
+    std::vector<unsigned char> row;
+    if (image.layout == ChannelImage::Layout::Alpha) {
+        row.resize(static_cast<size_t>(lastX - firstX) * 4);
+    }
+    for (int y = 0; y < sh; ++y) {
+        if (dstY + y < 0 || dstY + y >= canvas_h) continue;
+        if (image.layout == ChannelImage::Layout::Alpha) {
+            image.expandRow(srcX + firstX, srcY + y, lastX - firstX, row.data());
+            blit(canvas, canvas_w, canvas_h, row.data(), lastX - firstX, 1,
+                 static_cast<int>(row.size()), dstX + firstX, dstY + y);
+        } else {
+            // Opaque pixels replace the canvas outright (the blend in blit
+            // at alpha 255), so they are expanded straight into it
+            image.expandRow(srcX + firstX, srcY + y, lastX - firstX,
+                            &canvas[(static_cast<size_t>(dstY + y) * canvas_w + dstX + firstX) * 4]);
+        }
+    }
+}
+
+void EnhancedViewportAssembler::blitRle(std::vector<unsigned char>& canvas,
+                                       int canvas_w, int canvas_h,
+                                       const RleImage& image, int srcX, int srcY,
+                                       int sw, int sh, int dstX, int dstY) const {
+    int firstX = std::max(0, -dstX);
+    int lastX = std::min(sw, canvas_w - dstX);
+    if (firstX >= lastX) return;
+    for (int y = 0; y < sh; ++y) {
+        if (dstY + y < 0 || dstY + y >= canvas_h) continue;
+        unsigned char* dstRow = &canvas[static_cast<size_t>(dstY + y) * canvas_w * 4];
+        int runX = 0;  // tile column where the current run starts
+        for (uint32_t r = image.rowStart[srcY + y]; r < image.rowStart[srcY + y + 1]; ++r) {
+            const RleImage::Run& run = image.runs[r];
+            // Clip the run to the visible columns of the tile
+            int x0 = std::max(runX - srcX, firstX);
+            int x1 = std::min(runX + run.length - srcX, lastX);
+            runX += run.length;
+            if (x0 >= x1) {
+                if (runX - srcX >= lastX) break;
+                continue;
+            }
+            const unsigned char* sp = run.color;
+            if (sp[3] == 255) {
+                // An opaque run replaces the canvas, as the blend in blit does
+                for (int x = x0; x < x1; ++x) {
+                    std::memcpy(&dstRow[(dstX + x) * 4], sp, 4);
+                }
+            } else if (sp[3] > 0) {
+                // Same blend as blit, with the run's terms computed once
+                float a = sp[3] / 255.0f;
+                float srcTerm[3] = {sp[0] * a, sp[1] * a, sp[2] * a};
+                for (int x = x0; x < x1; ++x) {
+                    unsigned char* dp = &dstRow[(dstX + x) * 4];
+                    for (int c = 0; c < 3; ++c) {
+                        dp[c] = static_cast<unsigned char>(srcTerm[c] + dp[c] * (1 - a));
+                    }
+                    dp[3] = static_cast<unsigned char>(
+                        std::min(255.0f, sp[3] + dp[3] * (1 - a)));
+                }
+            }
+            // Fully transparent runs leave the canvas unchanged
+        }
+    }
+}
+
 void EnhancedViewportAssembler::blitSolidColor(std::vector<unsigned char>& canvas,
                                               int canvas_w, int canvas_h,
                                               uint32_t color, int w, int h, int dstX,
@@ -264,8 +368,17 @@ EnhancedViewportAssembler::TileRenderData EnhancedViewportAssembler::loadTileDat
             result.isPureColor = cachedTile->isPureColor;
             result.pureColorValue = cachedTile->pureColorValue;
             
-            if (!cachedTile->isPureColor) {
-                result.data = cachedTile->data;
+            if (cachedTile->palette) {
+                result.palette = cachedTile->palette;
+            } else if (cachedTile->blocks) {
+                result.blocks = cachedTile->blocks;
+            } else if (cachedTile->reduced) {
+                result.reduced = cachedTile->reduced;
+            } else if (cachedTile->rle) {
+                result.rle = cachedTile->rle;
+            } else if (!cachedTile->isPureColor) {
+                result.data = std::shared_ptr<const std::vector<unsigned char>>(
+                    cachedTile, &cachedTile->data);
             }
             
             return result;
@@ -297,24 +410,45 @@ EnhancedViewportAssembler::TileRenderData EnhancedViewportAssembler::loadTileSyn
         lastStats_.syncLoadedTiles++;
     } else {
         std::string filePath = resourceDir + "/" + tileMeta.file;
-        int w, h, c;
-        unsigned char* data = stbi_load(filePath.c_str(), &w, &h, &c, 4);
-        
-        if (data) {
+        std::vector<unsigned char> pixels;
+        PaletteImage palette;
+        BlockImage blocks;
+        ChannelImage reduced;
+        RleImage rle;
+        int w, h;
+        if (TilePack::loadTile(filePath, pixels, &w, &h, &palette, &blocks, &reduced, &rle)) {
             result.width = w;
             result.height = h;
             result.channels = 4;
             result.loaded = true;
             
-            size_t dataSize = w * h * 4;
-            result.data.resize(dataSize);
-            std::memcpy(result.data.data(), data, dataSize);
-            
-            stbi_image_free(data);
-            
-            if (cache_) {
-                std::vector<unsigned char> dataCopy = result.data;
-                cache_->put(result.tileId, std::move(dataCopy), w, h, 4);
+            if (palette.width > 0) {
+                result.palette = std::make_shared<const PaletteImage>(std::move(palette));
+                if (cache_) {
+                    cache_->putPalette(result.tileId, result.palette);
+                }
+            } else if (blocks.width > 0) {
+                result.blocks = std::make_shared<const BlockImage>(std::move(blocks));
+                if (cache_) {
+                    cache_->putBlocks(result.tileId, result.blocks);
+                }
+            } else if (reduced.width > 0) {
+                result.channels = reduced.channels();
+                result.reduced = std::make_shared<const ChannelImage>(std::move(reduced));
+                if (cache_) {
+                    cache_->putChannels(result.tileId, result.reduced);
+                }
+            } else if (rle.width > 0) {
+                result.rle = std::make_shared<const RleImage>(std::move(rle));
+                if (cache_) {
+                    cache_->putRle(result.tileId, result.rle);
+                }
+            } else {
+                if (cache_) {
+                    std::vector<unsigned char> dataCopy = pixels;
+                    cache_->put(result.tileId, std::move(dataCopy), w, h, 4);
+                }
+                result.data = std::make_shared<const std::vector<unsigned char>>(std::move(pixels));
             }
             
             lastStats_.syncLoadedTiles++;
@@ -331,18 +465,29 @@ std::vector<EnhancedViewportAssembler::TileRenderData>
 EnhancedViewportAssembler::loadTilesAsync(const std::vector<TileMeta>& tiles,
                                          const std::string& resourceDir) {
     
-    std::vector<TileRenderData> results;
-    results.reserve(tiles.size());
+    // Results stay aligned with tiles; renderTilesOnCanvas pairs them by index
+    std::vector<TileRenderData> results(tiles.size());
     
-    std::vector<std::future<LoadResult>> futures;
+    std::vector<std::pair<size_t, std::future<LoadResult>>> futures;
     futures.reserve(tiles.size());
     
-    for (const auto& tileMeta : tiles) {
+    // Tiles sharing an id (atlas pages, deduplicated tiles) are loaded once
+    std::unordered_map<std::string, size_t> firstWithId;
+    std::vector<std::pair<size_t, size_t>> duplicates;
+    
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const auto& tileMeta = tiles[i];
         std::string tileId = generateTileId(tileMeta);
         
+        auto first = firstWithId.emplace(tileId, i);
+        if (!first.second) {
+            duplicates.emplace_back(i, first.first->second);
+            continue;
+        }
+        
         auto cachedTile = cache_ ? cache_->get(tileId) : nullptr;
         if (cachedTile) {
-            TileRenderData cached;
+            TileRenderData& cached = results[i];
             cached.tileId = tileId;
             cached.loaded = true;
             cached.width = cachedTile->width;
@@ -351,23 +496,31 @@ EnhancedViewportAssembler::loadTilesAsync(const std::vector<TileMeta>& tiles,
             cached.isPureColor = cachedTile->isPureColor;
             cached.pureColorValue = cachedTile->pureColorValue;
             
-            if (!cachedTile->isPureColor) {
-                cached.data = cachedTile->data;
+            if (cachedTile->palette) {
+                cached.palette = cachedTile->palette;
+            } else if (cachedTile->blocks) {
+                cached.blocks = cachedTile->blocks;
+            } else if (cachedTile->reduced) {
+                cached.reduced = cachedTile->reduced;
+            } else if (cachedTile->rle) {
+                cached.rle = cachedTile->rle;
+            } else if (!cachedTile->isPureColor) {
+                cached.data = std::shared_ptr<const std::vector<unsigned char>>(
+                    cachedTile, &cachedTile->data);
             }
             
-            results.push_back(std::move(cached));
             lastStats_.cachedTiles++;
         } else {
             auto future = loader_->loadTileAsync(tileId, resourceDir, tileMeta, 200);
-            futures.push_back(std::move(future));
+            futures.emplace_back(i, std::move(future));
         }
     }
     
-    for (auto& future : futures) {
+    for (auto& entry : futures) {
+        TileRenderData& tileData = results[entry.first];
         try {
-            auto loadResult = future.get();
+            auto loadResult = entry.second.get();
             
-            TileRenderData tileData;
             tileData.tileId = loadResult.tileId;
             tileData.loaded = (loadResult.status == LoadStatus::Completed);
             
@@ -378,27 +531,66 @@ EnhancedViewportAssembler::loadTilesAsync(const std::vector<TileMeta>& tiles,
                 tileData.isPureColor = loadResult.isPureColor;
                 tileData.pureColorValue = loadResult.pureColorValue;
                 
-                if (!loadResult.isPureColor) {
-                    tileData.data = std::move(loadResult.data);
+                if (loadResult.palette) {
+                    tileData.palette = std::move(loadResult.palette);
+                } else if (loadResult.blocks) {
+                    tileData.blocks = std::move(loadResult.blocks);
+                } else if (loadResult.reduced) {
+                    tileData.reduced = std::move(loadResult.reduced);
+                } else if (loadResult.rle) {
+                    tileData.rle = std::move(loadResult.rle);
+                } else if (!loadResult.isPureColor) {
+                    tileData.data = std::make_shared<const std::vector<unsigned char>>(
+                        std::move(loadResult.data));
                 }
                 
                 lastStats_.asyncLoadedTiles++;
-            } else {
-                lastStats_.failedTiles++;
+                continue;
             }
-            
-            results.push_back(std::move(tileData));
-            
         } catch (const std::exception& e) {
             std::cerr << "Async load failed: " << e.what() << "\n";
-            
-            TileRenderData failedTile;
-            failedTile.loaded = false;
-            results.push_back(std::move(failedTile));
+        }
+        
+        if (config_.fallbackToSync) {
+            tileData = loadTileSync(tiles[entry.first], resourceDir);
+        } else {
+            tileData.loaded = false;
             lastStats_.failedTiles++;
         }
     }
     
+    for (const auto& duplicate : duplicates) {
+        results[duplicate.first] = results[duplicate.second];
+        if (results[duplicate.first].loaded) {
+            lastStats_.cachedTiles++;
+        }
+    }
+    
+    return results;
+}
+
+std::vector<EnhancedViewportAssembler::TileRenderData> 
+EnhancedViewportAssembler::loadTilesSync(const std::vector<TileMeta>& tiles,
+                                        const std::string& resourceDir) {
+    
+    std::vector<TileRenderData> results;
+    results.reserve(tiles.size());
+    
+    // Tiles sharing an id (atlas pages, deduplicated tiles) are loaded once
+    std::unordered_map<std::string, size_t> firstWithId;
+    
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        auto first = firstWithId.emplace(generateTileId(tiles[i]), i);
+        if (!first.second) {
+            results.push_back(results[first.first->second]);
+            if (results.back().loaded) {
+                lastStats_.cachedTiles++;
+            }
+            continue;
+        }
+        results.push_back(loadTileData(tiles[i], resourceDir));
+    }
+    
     return results;
 }
 
@@ -419,11 +611,45 @@ void EnhancedViewportAssembler::renderTilesOnCanvas(std::vector<unsigned char>&
         int localY = tileMeta.y - vp.y;
         
         if (data.isPureColor) {
+            // Pure color tiles of any size share one cache entry per color,
+            // so the size comes from the tile itself
             blitSolidColor(canvas, vp.w, vp.h, data.pureColorValue, 
-                          data.width, data.height, localX, localY);
+                          tileMeta.w, tileMeta.h, localX, localY);
         } else {
-            blit(canvas, vp.w, vp.h, data.data.data(), data.width, data.height,
-                data.width * 4, localX, localY);
+            if ((!data.data && !data.palette && !data.blocks && !data.reduced &&
+                 !data.rle) ||
+                tileMeta.srcX >= data.width || tileMeta.srcY >= data.height) {
+                continue;
+            }
+            if (data.rle) {
+                blitRle(canvas, vp.w, vp.h, *data.rle, tileMeta.srcX, tileMeta.srcY,
+                        std::min(tileMeta.w, data.width - tileMeta.srcX),
+                        std::min(tileMeta.h, data.height - tileMeta.srcY), localX, localY);
+                continue;
+            }
+            if (data.reduced) {
+                blitChannels(canvas, vp.w, vp.h, *data.reduced, tileMeta.srcX, tileMeta.srcY,
+                             std::min(tileMeta.w, data.width - tileMeta.srcX),
+                             std::min(tileMeta.h, data.height - tileMeta.srcY), localX, localY);
+                continue;
+            }
+            if (data.blocks) {
+                blitBlocks(canvas, vp.w, vp.h, *data.blocks, tileMeta.srcX, tileMeta.srcY,
+                           std::min(tileMeta.w, data.width - tileMeta.srcX),
+                           std::min(tileMeta.h, data.height - tileMeta.srcY), localX, localY);
+                continue;
+            }
+            if (data.palette) {
+                blitPalette(canvas, vp.w, vp.h, *data.palette, tileMeta.srcX, tileMeta.srcY,
+                            std::min(tileMeta.w, data.width - tileMeta.srcX),
+                            std::min(tileMeta.h, data.height - tileMeta.srcY), localX, localY);
+                continue;
+            }
+            // The tile's rectangle inside the payload (a sub-rectangle for atlases)
+            const unsigned char* src = data.data->data() +
+                (static_cast<size_t>(tileMeta.srcY) * data.width + tileMeta.srcX) * 4;
+            blit(canvas, vp.w, vp.h, src, std::min(tileMeta.w, data.width - tileMeta.srcX),
+                std::min(tileMeta.h, data.height - tileMeta.srcY), data.width * 4, localX, localY);
         }
     }
 }
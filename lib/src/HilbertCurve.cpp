@@ -0,0 +1,58 @@
+#include "HilbertCurve.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "TileSplitter.hpp"
+
+int HilbertCurve::orderFor(int width, int height) {
+    int side = std::max(std::max(width, height), 1);
+    int order = 0;
+    while (order < 31 && (1 << order) < side) {
+        ++order;
+    }
+    return order;
+}
+
+uint64_t HilbertCurve::index(uint32_t x, uint32_t y, int order) {
+    if (order <= 0) {
+        return 0;
+    }
+    const uint32_t last = (1u << order) - 1;
+    uint64_t d = 0;
+    for (uint32_t s = 1u << (order - 1); s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        // 旋转子象限，使下一层的曲线与本层首尾相接
+        if (ry == 0) {
+            if (rx == 1) {
+                x = last - x;
+                y = last - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+std::vector<size_t> HilbertCurve::sortedOrder(
+    const std::vector<TileMeta>& tiles, int imageWidth, int imageHeight) {
+    const int order = orderFor(imageWidth, imageHeight);
+    std::vector<uint64_t> keys(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const TileMeta& tile = tiles[i];
+        uint32_t x = static_cast<uint32_t>(std::max(tile.x, 0));
+        uint32_t y = static_cast<uint32_t>(std::max(tile.y, 0));
+        keys[i] = index(x, y, order);
+    }
+
+    std::vector<size_t> sorted(tiles.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::stable_sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) {
+        if (tiles[a].lod != tiles[b].lod) return tiles[a].lod < tiles[b].lod;
+        return keys[a] < keys[b];
+    });
+    return sorted;
+}
@@ -0,0 +1,27 @@
+#include "MemoryBudget.hpp"
+
+#include <algorithm>
+
+void MemoryBudget::acquire(size_t bytes,
+                           const std::atomic<size_t>* holderCount) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    released_.wait(lock, [&] {
+        return used_ == 0 || used_ + bytes <= limit_ ||
+               (holderCount && holderCount->load() == 0);
+    });
+    used_ += bytes;
+    peak_ = std::max(peak_, used_);
+}
+
+void MemoryBudget::release(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        used_ -= std::min(bytes, used_);
+    }
+    released_.notify_all();
+}
+
+size_t MemoryBudget::getPeak() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
+}
@@ -15,6 +15,8 @@ bool QuadTreeIndex::load(const std::string& metaFile) {
     if (!TileIndex::load(metaFile)) {
         return false;
     }
+    // 四叉树按下标引用 tiles_，二进制元数据需先展开到内存
+    materialize();
 
     // 构建四叉树
     buildQuadTree();
@@ -7,7 +7,8 @@ QuadTreeNode::QuadTreeNode(int x, int y, int width, int height)
       height_(height),
       isLeaf_(true),
       uniformColor_(0),
-      hasUniformColor_(false) {
+      hasUniformColor_(false),
+      colorError_(0) {
     // 构造函数初始化所有成员变量
     // 默认创建为叶子节点，没有统一颜色
 }
@@ -44,3 +45,8 @@ void QuadTreeNode::subdivide() {
     // 标记为非叶子节点
     isLeaf_ = false;
 }
+
+void QuadTreeNode::merge() {
+    children_.clear();
+    isLeaf_ = true;
+}
\ No newline at end of file
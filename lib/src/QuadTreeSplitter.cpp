@@ -1,12 +1,27 @@
 #include "QuadTreeSplitter.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
+#include "AtlasPacker.hpp"
+#include "Downsampler.hpp"
+#include "HilbertCurve.hpp"
+#include "RawImage.hpp"
+#include "ThreadPool.hpp"
+#include "TileIndex.hpp"
 #include "stb_image.h"
-#include "stb_image_write.h"
 
 QuadTreeSplitter::QuadTreeSplitter() {
     // 构造函数，初始化颜色检查器
@@ -16,18 +31,21 @@ std::vector<TileMeta> QuadTreeSplitter::splitQuadTree(
     const std::string& inputPath, const std::string& outDir,
     const Config& config) {
     std::vector<TileMeta> tiles;
+    verbosity_ = config.verbosity;
 
     // 加载图像
     int width, height, channels;
     unsigned char* imageData =
-        stbi_load(inputPath.c_str(), &width, &height, &channels, 4);
+        loadImage(inputPath, config, width, height, channels);
     if (!imageData) {
         std::cerr << "Failed to load image: " << inputPath << std::endl;
         return tiles;
     }
 
-    std::cout << "Loaded image: " << width << "x" << height << " (" << channels
-              << " channels)" << std::endl;
+    log(1) << "Loaded image: " << width << "x" << height << " (" << channels
+           << " channels)" << std::endl;
+    imageWidth_ = width;
+    imageHeight_ = height;
 
     // 确保输出目录存在
     if (!ensureDirectoryExists(outDir)) {
@@ -37,8 +55,10 @@ std::vector<TileMeta> QuadTreeSplitter::splitQuadTree(
         return tiles;
     }
 
-    // 设置颜色检查器的容差
+    // 设置颜色检查器的容差和瓦片编码
     colorChecker_.setColorTolerance(config.colorTolerance);
+    colorChecker_.setTransparentAlpha(config.transparentAlpha);
+    codec_ = config.codec;
 
     // 构建四叉树
     auto quadTree = buildQuadTree(imageData, width, height, config);
@@ -47,18 +67,573 @@ std::vector<TileMeta> QuadTreeSplitter::splitQuadTree(
         stbi_image_free(imageData);
         return tiles;
     }
+    if (config.costSplit) {
+        size_t merged = 0;
+        applyCostModel(quadTree.get(), width, height, config, merged);
+        log(1) << "Cost model: " << merged << " leaves merged into larger "
+               << "tiles" << std::endl;
+    }
+    if (config.profile) {
+        config.profile->setImageSize(width, height);
+        config.profile->recordTree(quadTree.get(), width, height);
+    }
 
-    // 收集叶子节点并生成瓦片
-    collectLeafTiles(quadTree.get(), imageData, width, height, outDir, tiles);
+    // 收集叶子节点
+    std::vector<TileJob> jobs;
+    collectLeafTiles(quadTree.get(), width, height, tiles, jobs);
+    if (isLossy(config)) {
+        reportLossyTiles(tiles);
+    }
+    if (config.trimTransparent) {
+        enableTrimming(tiles, jobs);
+    } else if (config.transparentAlpha >= 0) {
+        removeTransparentTiles(tiles);
+    }
+    if (config.mergeUniform) {
+        mergeUniformTiles(tiles);
+    }
+    std::vector<size_t> tileJobs = mapTilesToJobs(tiles);
+
+    // 小叶子打包进图集页
+    if (config.atlasMaxTileSize > 0) {
+        buildAtlasPages(imageData, width, config, tiles, tileJobs, jobs);
+    }
+
+    // 内部节点的降采样瓦片
+    if (config.lodLevels > 0) {
+        buildLodTiles(imageData, width, height, config, quadTree.get(), tiles,
+                      tileJobs, jobs);
+    }
+
+    if (config.hilbertOrder) {
+        orderAlongHilbert(tiles, tileJobs, jobs, width, height);
+    }
+
+    // 并发编码非纯色瓦片
+    TileWriter writer(writerConfigFor(config));
+    std::vector<TileOutput> outputs;
+    std::vector<bool> written =
+        writer.writeAll(imageData, width, height, jobs, outDir, &outputs);
 
     // 释放图像数据
     stbi_image_free(imageData);
 
-    std::cout << "QuadTree split completed: " << tiles.size()
-              << " tiles generated" << std::endl;
+    size_t uniqueTiles = writer.getUniqueTileCount();
+    if (!writer.finish()) {
+        std::cerr << "Failed to write tile pack in " << outDir << std::endl;
+        return std::vector<TileMeta>();
+    }
+
+    // 剔除写出失败的瓦片
+    applyWriteResults(tiles, tileJobs, written, outputs);
+    if (config.hilbertOrder && config.trimTransparent) {
+        sortAlongHilbert(tiles, width, height);
+    }
+    if (config.dedupContent) {
+        log(1) << "Content dedup: " << jobs.size() << " tiles, "
+               << uniqueTiles << " unique payloads" << std::endl;
+    }
+
+    if (config.profile) {
+        config.profile->setTileCount(tiles.size());
+    }
+    log(1) << "QuadTree split completed: " << tiles.size()
+           << " tiles generated" << std::endl;
     return tiles;
 }
 
+std::vector<TileMeta> QuadTreeSplitter::splitQuadTreeStreaming(
+    const std::string& inputPath, const std::string& outDir,
+    const Config& config) {
+    std::vector<TileMeta> tiles;
+    verbosity_ = config.verbosity;
+
+    RawImageReader reader;
+    if (!reader.open(inputPath)) {
+        std::cerr << "Failed to open raw image: " << inputPath << std::endl;
+        return tiles;
+    }
+    const int width = reader.getWidth();
+    const int height = reader.getHeight();
+    const int stripHeight = std::max(1, config.stripHeight);
+    imageWidth_ = width;
+    imageHeight_ = height;
+
+    log(1) << "Streaming image: " << width << "x" << height
+           << " (strip height " << stripHeight << ")" << std::endl;
+
+    if (!ensureDirectoryExists(outDir)) {
+        std::cerr << "Failed to create output directory: " << outDir
+                  << std::endl;
+        return tiles;
+    }
+
+    colorChecker_.setColorTolerance(config.colorTolerance);
+    colorChecker_.setTransparentAlpha(config.transparentAlpha);
+    codec_ = config.codec;
+
+    if (config.atlasMaxTileSize > 0 || config.lodLevels > 0 ||
+        isLossy(config)) {
+        std::cerr << "Atlas packing, LOD tiles and lossy coarsening need the "
+                     "whole image; ignored when streaming"
+                  << std::endl;
+    }
+
+    if (config.profile) {
+        config.profile->setImageSize(width, height);
+    }
+    std::optional<SplitProfile::Timer> buildTimer;
+    buildTimer.emplace(config.profile, SplitProfile::Phase::TreeBuild,
+                       static_cast<uint64_t>(width) * height * 4);
+
+    // 1. 按形状展开整棵树（先序），记录上层节点和形状终止的节点
+    auto root = std::make_unique<QuadTreeNode>(0, 0, width, height);
+    std::vector<QuadTreeNode*> upperNodes;
+    std::vector<QuadTreeNode*> leaves;
+    std::vector<std::pair<QuadTreeNode*, int>> stack{{root.get(), 0}};
+    while (!stack.empty()) {
+        QuadTreeNode* node = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+
+        if (node->getX() >= width || node->getY() >= height) {
+            continue;
+        }
+        if (isTerminalShape(node, width, height, config, depth)) {
+            leaves.push_back(node);
+            continue;
+        }
+        node->subdivide();
+        upperNodes.push_back(node);
+        for (const auto& child : node->getChildren()) {
+            stack.emplace_back(child.get(), depth + 1);
+        }
+    }
+
+    // 按起始行排序，条带推进时依次激活
+    auto byTop = [](std::vector<size_t>& order, auto getY) {
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return getY(a) < getY(b);
+        });
+    };
+
+    std::vector<unsigned char> strip(static_cast<size_t>(width) * stripHeight *
+                                     4);
+    auto readStrip = [&](int top, int rows) {
+        SplitProfile::Timer timer(config.profile, SplitProfile::Phase::Decode,
+                                  static_cast<uint64_t>(width) * rows * 4);
+        return reader.readRows(top, rows, strip.data());
+    };
+
+    // 2. 第一遍：逐条带累计每个终止节点的颜色范围和左上角像素
+    std::vector<ColorChecker::ColorRange> leafRanges(leaves.size());
+    std::vector<uint32_t> leafColors(leaves.size(), 0);
+    {
+        std::vector<size_t> order(leaves.size());
+        byTop(order, [&](size_t i) { return leaves[i]->getY(); });
+
+        size_t nextLeaf = 0;
+        std::vector<size_t> active;
+        for (int top = 0; top < height; top += stripHeight) {
+            int rows = std::min(stripHeight, height - top);
+            int bottom = top + rows;
+            if (!readStrip(top, rows)) {
+                std::cerr << "Failed to read rows " << top << "-" << bottom
+                          << " of " << inputPath << std::endl;
+                return std::vector<TileMeta>();
+            }
+
+            while (nextLeaf < order.size() &&
+                   leaves[order[nextLeaf]]->getY() < bottom) {
+                active.push_back(order[nextLeaf++]);
+            }
+
+            size_t kept = 0;
+            for (size_t index : active) {
+                const QuadTreeNode* leaf = leaves[index];
+                int x = leaf->getX();
+                int actualWidth = std::min(leaf->getWidth(), width - x);
+                int leafBottom =
+                    std::min(leaf->getY() + leaf->getHeight(), height);
+                int bandTop = std::max(leaf->getY(), top);
+                int bandRows = std::min(leafBottom, bottom) - bandTop;
+
+                SplitProfile::Timer timer(
+                    config.profile, SplitProfile::Phase::Uniformity,
+                    static_cast<uint64_t>(actualWidth) * bandRows * 4);
+                leafRanges[index].merge(
+                    colorChecker_.computeRange(strip.data(), width, x,
+                                               bandTop - top, actualWidth,
+                                               bandRows));
+                if (leaf->getY() >= top) {
+                    leafColors[index] = colorChecker_.getPixelColor(
+                        strip.data(), width, x, leaf->getY() - top);
+                }
+                if (leafBottom > bottom) {
+                    active[kept++] = index;
+                }
+            }
+            active.resize(kept);
+        }
+    }
+
+    // 3. 自底向上确定纯色节点；节点左上角像素即其左上子节点的左上角像素
+    std::unordered_map<const QuadTreeNode*,
+                       std::pair<ColorChecker::ColorRange, uint32_t>>
+        stats;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        resolvePyramidNode(leaves[i], leafRanges[i], leafColors[i]);
+        stats[leaves[i]] = {leafRanges[i], leafColors[i]};
+    }
+    for (auto it = upperNodes.rbegin(); it != upperNodes.rend(); ++it) {
+        QuadTreeNode* node = *it;
+        ColorChecker::ColorRange range;
+        for (const auto& child : node->getChildren()) {
+            range.merge(stats[child.get()].first);
+        }
+        uint32_t referenceColor = stats[node->getChildren()[0].get()].second;
+        resolvePyramidNode(node, range, referenceColor);
+        stats[node] = {range, referenceColor};
+    }
+    stats.clear();
+    leafRanges.clear();
+    leafColors.clear();
+    if (config.costSplit) {
+        size_t merged = 0;
+        applyCostModel(root.get(), width, height, config, merged);
+        log(1) << "Cost model: " << merged << " leaves merged into larger "
+               << "tiles" << std::endl;
+    }
+    buildTimer.reset();
+    if (config.profile) {
+        config.profile->recordTree(root.get(), width, height);
+    }
+
+    std::vector<TileJob> jobs;
+    collectLeafTiles(root.get(), width, height, tiles, jobs);
+    if (config.trimTransparent) {
+        enableTrimming(tiles, jobs);
+    } else if (config.transparentAlpha >= 0) {
+        removeTransparentTiles(tiles);
+    }
+    if (config.mergeUniform) {
+        mergeUniformTiles(tiles);
+    }
+
+    // 4. 第二遍：瓦片最后一行读入后立即编码；完全位于条带内的瓦片直接
+    //    从条带截取，跨条带的瓦片先累积到各自的缓冲中
+    TileWriter writer(writerConfigFor(config));
+
+    std::vector<bool> written(jobs.size(), false);
+    std::vector<TileOutput> outputs(jobs.size());
+    std::vector<std::vector<unsigned char>> pending(jobs.size());
+    size_t pendingBytes = 0;
+    size_t peakPendingBytes = 0;
+    {
+        std::vector<size_t> order(jobs.size());
+        byTop(order, [&](size_t i) { return jobs[i].y; });
+
+        size_t nextJob = 0;
+        std::vector<size_t> active;
+        for (int top = 0; top < height; top += stripHeight) {
+            int rows = std::min(stripHeight, height - top);
+            int bottom = top + rows;
+            if (!readStrip(top, rows)) {
+                std::cerr << "Failed to read rows " << top << "-" << bottom
+                          << " of " << inputPath << std::endl;
+                return std::vector<TileMeta>();
+            }
+
+            while (nextJob < order.size() && jobs[order[nextJob]].y < bottom) {
+                active.push_back(order[nextJob++]);
+            }
+
+            std::vector<TileJob> stripJobs;
+            std::vector<size_t> stripIndices;
+            size_t kept = 0;
+            for (size_t index : active) {
+                TileJob& job = jobs[index];
+                int jobBottom = std::min(job.y + job.height, height);
+                bool complete = jobBottom <= bottom;
+
+                if (complete && job.y >= top) {
+                    // 整块位于当前条带内，坐标换算为条带内坐标
+                    stripJobs.push_back(TileJob{job.x, job.y - top, job.width,
+                                                job.height, job.fileName});
+                    stripJobs.back().trim = job.trim;
+                    stripIndices.push_back(index);
+                    continue;
+                }
+
+                std::vector<unsigned char>& pixels = pending[index];
+                if (pixels.empty()) {
+                    pixels.assign(
+                        static_cast<size_t>(job.width) * job.height * 4, 0);
+                    pendingBytes += pixels.size();
+                    peakPendingBytes = std::max(peakPendingBytes, pendingBytes);
+                }
+                int actualWidth = std::min(job.width, width - job.x);
+                int bandTop = std::max(job.y, top);
+                int bandBottom = std::min(jobBottom, bottom);
+                for (int y = bandTop; y < bandBottom; ++y) {
+                    std::memcpy(&pixels[static_cast<size_t>(y - job.y) *
+                                        job.width * 4],
+                                &strip[(static_cast<size_t>(y - top) * width +
+                                        job.x) *
+                                       4],
+                                static_cast<size_t>(actualWidth) * 4);
+                }
+
+                if (complete) {
+                    TileJob stripJob{job.x, 0, job.width, job.height,
+                                     job.fileName};
+                    stripJob.pixels = std::move(pixels);
+                    stripJob.trim = job.trim;
+                    pendingBytes -= stripJob.pixels.size();
+                    stripJobs.push_back(std::move(stripJob));
+                    stripIndices.push_back(index);
+                } else {
+                    active[kept++] = index;
+                }
+            }
+            active.resize(kept);
+
+            std::vector<TileOutput> stripOutputs;
+            std::vector<bool> stripWritten = writer.writeAll(
+                strip.data(), width, rows, stripJobs, outDir, &stripOutputs);
+            for (size_t i = 0; i < stripIndices.size(); ++i) {
+                written[stripIndices[i]] = stripWritten[i];
+                outputs[stripIndices[i]] = std::move(stripOutputs[i]);
+            }
+        }
+    }
+
+    size_t uniqueTiles = writer.getUniqueTileCount();
+    if (!writer.finish()) {
+        std::cerr << "Failed to write tile pack in " << outDir << std::endl;
+        return std::vector<TileMeta>();
+    }
+
+    log(1) << "Streaming buffers: strip " << strip.size() / 1024
+           << " KiB, peak pending tiles " << peakPendingBytes / 1024
+           << " KiB" << std::endl;
+
+    applyWriteResults(tiles, mapTilesToJobs(tiles), written, outputs);
+    if (config.hilbertOrder) {
+        // 瓦片数据已按条带写出，只能对元数据排序
+        sortAlongHilbert(tiles, width, height);
+    }
+    if (config.dedupContent) {
+        log(1) << "Content dedup: " << jobs.size() << " tiles, "
+               << uniqueTiles << " unique payloads" << std::endl;
+    }
+
+    if (config.profile) {
+        config.profile->setTileCount(tiles.size());
+    }
+    log(1) << "QuadTree split completed: " << tiles.size()
+           << " tiles generated" << std::endl;
+    return tiles;
+}
+
+std::vector<TileMeta> QuadTreeSplitter::splitQuadTreeIncremental(
+    const std::string& inputPath, const std::string& outDir,
+    const std::string& previousMeta, const Config& config) {
+    std::vector<TileMeta> tiles;
+    verbosity_ = config.verbosity;
+
+    int width, height, channels;
+    unsigned char* imageData =
+        loadImage(inputPath, config, width, height, channels);
+    if (!imageData) {
+        std::cerr << "Failed to load image: " << inputPath << std::endl;
+        return tiles;
+    }
+    imageWidth_ = width;
+    imageHeight_ = height;
+
+    log(1) << "Loaded image: " << width << "x" << height << " (" << channels
+           << " channels)" << std::endl;
+
+    if (!ensureDirectoryExists(outDir)) {
+        std::cerr << "Failed to create output directory: " << outDir
+                  << std::endl;
+        stbi_image_free(imageData);
+        return tiles;
+    }
+
+    colorChecker_.setColorTolerance(config.colorTolerance);
+    colorChecker_.setTransparentAlpha(config.transparentAlpha);
+    codec_ = config.codec;
+
+    // 1. 读取上次的叶子哈希和瓦片元数据，把瓦片按顺序归入所在的叶子
+    const std::string configLine = describeConfig(config, width, height);
+    const std::string hashPath = outDir + "/" + kLeafHashFileName;
+    std::vector<LeafHash> previous;
+    std::vector<TileMeta> previousTiles;
+    std::vector<size_t> firstTile;
+    std::unordered_map<uint64_t, size_t> leafAt;
+    if (config.costSplit) {
+        // 合并决定取决于整个子树的代价，沿用的子树无法参与比较
+        log(1) << "Cost-model splitting needs the whole tree; doing a full "
+                  "split"
+               << std::endl;
+    } else if (loadLeafHashes(hashPath, configLine, previous)) {
+        TileIndex index;
+        if (index.load(previousMeta)) {
+            previousTiles = index.query(
+                {0, 0, index.getMapWidth(), index.getMapHeight()});
+        }
+        for (size_t i = 0; i < previous.size(); ++i) {
+            leafAt[nodeKey(previous[i].x, previous[i].y)] = i;
+        }
+        // 元数据可能按希尔伯特曲线排列，先恢复为叶子的顺序
+        std::vector<size_t> leafOf(previousTiles.size());
+        for (size_t i = 0; i < previousTiles.size(); ++i) {
+            leafOf[i] = findLeaf(previous, leafAt, width, height,
+                                 previousTiles[i].x, previousTiles[i].y);
+        }
+        std::vector<size_t> order(previousTiles.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return leafOf[a] < leafOf[b];
+        });
+        std::vector<TileMeta> sorted;
+        sorted.reserve(previousTiles.size());
+        for (size_t i : order) {
+            sorted.push_back(std::move(previousTiles[i]));
+        }
+        previousTiles = std::move(sorted);
+
+        firstTile.reserve(previous.size() + 1);
+        size_t next = 0;
+        for (const LeafHash& leaf : previous) {
+            firstTile.push_back(next);
+            while (next < previousTiles.size() &&
+                   contains(leaf, previousTiles[next])) {
+                ++next;
+            }
+        }
+        firstTile.push_back(next);
+        if (next != previousTiles.size()) {
+            std::cerr << "Tiles in " << previousMeta << " do not match "
+                      << hashPath << "; doing a full split" << std::endl;
+            previous.clear();
+            previousTiles.clear();
+            leafAt.clear();
+        }
+    } else {
+        log(1) << "No usable leaf hashes in " << hashPath
+               << "; doing a full split" << std::endl;
+    }
+
+    // 2. 在新图像上重新计算上次各叶子的哈希，找出变化的叶子
+    std::vector<size_t> dirty;
+    for (size_t i = 0; i < previous.size(); ++i) {
+        const LeafHash& leaf = previous[i];
+        if (hashLeaf(imageData, width, height, leaf.x, leaf.y, leaf.width,
+                     leaf.height) != leaf.hash) {
+            dirty.push_back(i);
+        }
+    }
+
+    // 3. 只分割与变化叶子相交的节点，其余节点沿用上次的子树
+    std::unique_ptr<QuadTreeNode> root;
+    std::unordered_map<const QuadTreeNode*, size_t> reused;
+    if (previous.empty()) {
+        root = buildQuadTree(imageData, width, height, config);
+        if (config.costSplit) {
+            size_t merged = 0;
+            applyCostModel(root.get(), width, height, config, merged);
+        }
+    } else {
+        SplitProfile::Timer timer(config.profile,
+                                  SplitProfile::Phase::TreeBuild,
+                                  static_cast<uint64_t>(width) * height * 4);
+        root = std::make_unique<QuadTreeNode>(0, 0, width, height);
+        subdivideIncremental(root.get(), imageData, width, height, config, 0,
+                             previous, dirty, leafAt, reused);
+    }
+    if (config.profile) {
+        config.profile->setImageSize(width, height);
+        config.profile->recordTree(root.get(), width, height);
+    }
+
+    // 4. 收集瓦片：沿用的子树复制上次的元数据，新叶子登记编码任务
+    std::vector<TileJob> jobs;
+    std::vector<size_t> tileJobs;
+    std::vector<LeafHash> leaves;
+    collectIncremental(root.get(), imageData, width, height, config, previous,
+                       previousTiles, firstTile, reused, tiles, tileJobs, jobs,
+                       leaves);
+    if (config.hilbertOrder) {
+        orderAlongHilbert(tiles, tileJobs, jobs, width, height);
+    }
+
+    TileWriter writer(writerConfigFor(config));
+    std::vector<TileOutput> outputs;
+    std::vector<bool> written =
+        writer.writeAll(imageData, width, height, jobs, outDir, &outputs);
+    stbi_image_free(imageData);
+    if (!writer.finish()) {
+        std::cerr << "Failed to write tiles in " << outDir << std::endl;
+        return std::vector<TileMeta>();
+    }
+    applyWriteResults(tiles, tileJobs, written, outputs);
+    if (config.hilbertOrder && config.trimTransparent) {
+        sortAlongHilbert(tiles, width, height);
+    }
+
+    // 5. 删除不再被引用的旧瓦片文件
+    std::unordered_set<std::string> referenced;
+    for (const TileMeta& tile : tiles) {
+        referenced.insert(tile.file);
+    }
+    size_t removed = 0;
+    for (const TileMeta& tile : previousTiles) {
+        if (isPureColorTile(tile.file) || referenced.count(tile.file)) {
+            continue;
+        }
+        std::error_code ec;
+        if (std::filesystem::remove(outDir + "/" + tile.file, ec)) {
+            ++removed;
+        }
+        referenced.insert(tile.file);
+    }
+
+    if (!saveLeafHashes(hashPath, configLine, leaves)) {
+        std::cerr << "Failed to save " << hashPath << std::endl;
+    }
+
+    log(1) << "Incremental split: " << dirty.size() << " of "
+           << previous.size() << " leaves changed, " << jobs.size()
+           << " new tiles, " << removed << " stale files removed"
+           << std::endl;
+    if (config.profile) {
+        config.profile->setTileCount(tiles.size());
+    }
+    log(1) << "QuadTree split completed: " << tiles.size()
+           << " tiles generated" << std::endl;
+    return tiles;
+}
+
+unsigned char* QuadTreeSplitter::loadImage(const std::string& inputPath,
+                                           const Config& config, int& width,
+                                           int& height, int& channels) {
+    std::error_code ec;
+    uintmax_t fileBytes = std::filesystem::file_size(inputPath, ec);
+    SplitProfile::Timer timer(config.profile, SplitProfile::Phase::Decode,
+                              ec ? 0 : fileBytes);
+    return stbi_load(inputPath.c_str(), &width, &height, &channels, 4);
+}
+
+std::ostream& QuadTreeSplitter::log(int level) const {
+    // 没有缓冲区的流处于失败状态，写入的内容直接丢弃
+    static std::ostream discard(nullptr);
+    return verbosity_ >= level ? std::cout : discard;
+}
+
 std::vector<TileMeta> QuadTreeSplitter::split(const std::string& inputPath,
                                               const std::string& outDir,
                                               int tileW, int tileH) {
@@ -71,14 +646,40 @@ std::vector<TileMeta> QuadTreeSplitter::split(const std::string& inputPath,
 std::unique_ptr<QuadTreeNode> QuadTreeSplitter::buildQuadTree(
     const unsigned char* imageData, int imageWidth, int imageHeight,
     const Config& config) {
-    std::cout << "Building quad tree with size: " << imageWidth << "x"
-              << imageHeight << std::endl;
+    log(1) << "Building quad tree with size: " << imageWidth << "x"
+           << imageHeight << std::endl;
+    SplitProfile::Timer timer(
+        config.profile, SplitProfile::Phase::TreeBuild,
+        static_cast<uint64_t>(imageWidth) * imageHeight * 4);
 
     // 创建根节点，覆盖整个图像
     auto root = std::make_unique<QuadTreeNode>(0, 0, imageWidth, imageHeight);
 
-    // 递归分割
-    subdivideNode(root.get(), imageData, imageWidth, imageHeight, config, 0);
+    int numThreads = config.pool
+                         ? config.pool->size()
+                         : ThreadPool::resolveThreadCount(config.numThreads);
+    if (config.buildMode == BuildMode::Pyramid && isLossy(config)) {
+        // 颜色范围无法判断平均色误差，有损合并只能逐节点统计
+        log(1) << "Lossy coarsening builds the quad tree top-down" << std::endl;
+    }
+    if (config.buildMode == BuildMode::Pyramid && !isLossy(config)) {
+        // 自底向上构建
+        if (numThreads > 1) {
+            buildPyramidParallel(root.get(), imageData, imageWidth,
+                                 imageHeight, config, numThreads);
+        } else {
+            buildPyramidNode(root.get(), imageData, imageWidth, imageHeight,
+                             config, 0);
+        }
+    } else if (numThreads > 1) {
+        // 并行分割
+        subdivideParallel(root.get(), imageData, imageWidth, imageHeight,
+                          config, numThreads);
+    } else {
+        // 递归分割
+        subdivideNode(root.get(), imageData, imageWidth, imageHeight, config,
+                      0);
+    }
 
     return root;
 }
@@ -87,9 +688,25 @@ void QuadTreeSplitter::subdivideNode(QuadTreeNode* node,
                                      const unsigned char* imageData,
                                      int imageWidth, int imageHeight,
                                      const Config& config, int currentDepth) {
+    if (!evaluateNode(node, imageData, imageWidth, imageHeight, config,
+                      currentDepth)) {
+        return;
+    }
+
+    // 递归处理四个子节点
+    for (const auto& child : node->getChildren()) {
+        subdivideNode(child.get(), imageData, imageWidth, imageHeight, config,
+                      currentDepth + 1);
+    }
+}
+
+bool QuadTreeSplitter::evaluateNode(QuadTreeNode* node,
+                                    const unsigned char* imageData,
+                                    int imageWidth, int imageHeight,
+                                    const Config& config, int currentDepth) {
     // 检查边界条件
     if (node->getX() >= imageWidth || node->getY() >= imageHeight) {
-        return;
+        return false;
     }
 
     // 计算实际可用的区域尺寸
@@ -98,9 +715,22 @@ void QuadTreeSplitter::subdivideNode(QuadTreeNode* node,
 
     // 检查终止条件
     uint32_t uniformColor;
-    bool isUniform = colorChecker_.isUniformColor(
-        imageData, imageWidth, node->getX(), node->getY(), actualWidth,
-        actualHeight, uniformColor);
+    int colorError = 0;
+    bool isUniform;
+    {
+        SplitProfile::Timer timer(
+            config.profile, SplitProfile::Phase::Uniformity,
+            static_cast<uint64_t>(actualWidth) * actualHeight * 4);
+        isUniform = colorChecker_.isUniformColor(
+            imageData, imageWidth, node->getX(), node->getY(), actualWidth,
+            actualHeight, uniformColor);
+        if (!isUniform && isLossy(config)) {
+            isUniform = fitsErrorBudget(imageData, imageWidth, node->getX(),
+                                        node->getY(), actualWidth,
+                                        actualHeight, config, uniformColor,
+                                        colorError);
+        }
+    }
 
     // 终止条件：1. 颜色一致 2. 达到最大深度 3. 达到最小尺寸
     if (isUniform || currentDepth >= config.maxDepth ||
@@ -110,26 +740,351 @@ void QuadTreeSplitter::subdivideNode(QuadTreeNode* node,
         if (isUniform) {
             node->setUniformColor(uniformColor);
             node->setHasUniformColor(true);
+            node->setColorError(colorError);
         }
-        return;
+        return false;
     }
 
     // 只有当区域足够大时才进行分割
     if (actualWidth > 1 && actualHeight > 1) {
-        // 四等分并递归处理
+        // 四等分
         node->subdivide();
+        return !node->isLeaf();
+    }
+    return false;
+}
+
+bool QuadTreeSplitter::fitsErrorBudget(const unsigned char* imageData,
+                                       int imageWidth, int x, int y, int width,
+                                       int height, const Config& config,
+                                       uint32_t& color, int& error) const {
+    if (config.lossyMaxError > 0) {
+        ColorChecker::ColorRange range = colorChecker_.computeRange(
+            imageData, imageWidth, x, y, width, height);
+        for (int c = 0; c < 4; ++c) {
+            if ((range.hi[c] - range.lo[c] + 1) / 2 > config.lossyMaxError) {
+                return false;
+            }
+        }
+    }
+
+    ColorChecker::ColorStats stats =
+        ColorChecker::computeStats(imageData, imageWidth, x, y, width, height);
+    color = stats.meanColor();
+    error = stats.maxError(color);
+    if (config.lossyMaxError > 0 && error > config.lossyMaxError) {
+        return false;
+    }
+    if (config.lossyMinPsnr > 0.0) {
+        // PSNR = 10 * log10(255^2 / MSE)，比较 MSE 避免对数运算
+        double maxMse =
+            255.0 * 255.0 / std::pow(10.0, config.lossyMinPsnr / 10.0);
+        if (stats.meanSquaredError(color) > maxMse) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void QuadTreeSplitter::subdivideParallel(QuadTreeNode* root,
+                                         const unsigned char* imageData,
+                                         int imageWidth, int imageHeight,
+                                         const Config& config,
+                                         int numThreads) {
+    std::unique_ptr<ThreadPool> ownPool;
+    ThreadPool* pool = config.pool;
+    if (!pool) {
+        ownPool = std::make_unique<ThreadPool>(numThreads);
+        pool = ownPool.get();
+    }
+
+    // 当前波次待处理的节点及其深度
+    std::vector<std::pair<QuadTreeNode*, int>> frontier{{root, 0}};
+
+    while (!frontier.empty()) {
+        // 每个任务只写入自己的槽位，保证下一波次的节点顺序确定
+        std::vector<std::vector<std::pair<QuadTreeNode*, int>>> next(
+            frontier.size());
+        std::vector<std::future<void>> futures;
+        futures.reserve(frontier.size());
+
+        for (size_t i = 0; i < frontier.size(); ++i) {
+            futures.push_back(pool->submit([&, i] {
+                QuadTreeNode* node = frontier[i].first;
+                int depth = frontier[i].second;
+                long long area = static_cast<long long>(node->getWidth()) *
+                                 node->getHeight();
+
+                // 小子树：在当前任务内串行递归
+                if (area <= config.serialSubtreePixels) {
+                    subdivideNode(node, imageData, imageWidth, imageHeight,
+                                  config, depth);
+                    return;
+                }
+
+                // 大节点：只处理本节点，子节点进入下一波次
+                if (evaluateNode(node, imageData, imageWidth, imageHeight,
+                                 config, depth)) {
+                    for (const auto& child : node->getChildren()) {
+                        next[i].emplace_back(child.get(), depth + 1);
+                    }
+                }
+            }));
+        }
+
+        // 等待本波次完成（异常在此处重新抛出）
+        for (auto& future : futures) {
+            future.get();
+        }
+
+        frontier.clear();
+        for (auto& children : next) {
+            frontier.insert(frontier.end(), children.begin(), children.end());
+        }
+    }
+}
+
+QuadTreeSplitter::CostModel QuadTreeSplitter::CostModel::forCodec(
+    TileCodec::Type codec, bool packed) {
+    CostModel model;
+    switch (codec) {
+        case TileCodec::Type::Qoi:
+            model.fileCost = packed ? 0.2 : 2.7;
+            model.byteCost = 0.0001;
+            model.pixelCost = 0.0045;
+            model.busyBytesPerPixel = 1.75;
+            model.uniformBytesPerPixel = 0.013;
+            break;
+        case TileCodec::Type::Bc1:
+        case TileCodec::Type::Bc3:
+            // 块压缩瓦片加载时不解码，大小只取决于面积
+            model.fileCost = packed ? 0.15 : 2.4;
+            model.byteCost = 0.0001;
+            model.pixelCost = 0.0;
+            model.busyBytesPerPixel = model.uniformBytesPerPixel =
+                codec == TileCodec::Type::Bc1 ? 0.5 : 1.0;
+            break;
+        case TileCodec::Type::Png:
+            // 打包后仍有 zlib 与 PNG 头的初始化
+            if (packed) model.fileCost = 3.3;
+            break;
+    }
+    return model;
+}
+
+QuadTreeSplitter::SubtreeCost QuadTreeSplitter::applyCostModel(
+    QuadTreeNode* node, int imageWidth, int imageHeight, const Config& config,
+    size_t& merged) const {
+    const CostModel& model = config.costModel;
+    const uint64_t area =
+        static_cast<uint64_t>(node->getWidth()) * node->getHeight();
+    SubtreeCost result;
+    if (node->isLeaf()) {
+        if (node->hasUniformColor()) {
+            bool dropped = dropsTransparent(config) &&
+                           (node->getUniformColor() & 0xFF) == 0;
+            result.cost = dropped ? 0.0
+                                  : model.tileCost *
+                                        model.viewportWeight(node->getWidth(),
+                                                             node->getHeight());
+            result.uniformPixels = area;
+            result.leaves = 1;
+        } else {
+            // 编码瓦片超出图像的部分填充透明像素
+            result.busyPixels =
+                static_cast<uint64_t>(
+                    std::min(node->getWidth(), imageWidth - node->getX())) *
+                std::min(node->getHeight(), imageHeight - node->getY());
+            result.uniformPixels = area - result.busyPixels;
+            result.cost = encodedTileCost(model, result.uniformPixels,
+                                          result.busyPixels) *
+                          model.viewportWeight(node->getWidth(),
+                                               node->getHeight());
+            result.leaves = 1;
+        }
+        return result;
+    }
+
+    for (const auto& child : node->getChildren()) {
+        if (child->getX() >= imageWidth || child->getY() >= imageHeight) {
+            // 图像外的子节点不生成瓦片，合并后是透明填充
+            result.uniformPixels += static_cast<uint64_t>(child->getWidth()) *
+                                    child->getHeight();
+            continue;
+        }
+        SubtreeCost childCost = applyCostModel(child.get(), imageWidth,
+                                               imageHeight, config, merged);
+        result.cost += childCost.cost;
+        result.uniformPixels += childCost.uniformPixels;
+        result.busyPixels += childCost.busyPixels;
+        result.leaves += childCost.leaves;
+    }
+    if (node->getWidth() > model.maxTileSize ||
+        node->getHeight() > model.maxTileSize) {
+        return result;
+    }
+
+    double whole =
+        encodedTileCost(model, result.uniformPixels, result.busyPixels) *
+        model.viewportWeight(node->getWidth(), node->getHeight());
+    if (whole <= result.cost) {
+        node->merge();
+        node->setHasUniformColor(false);
+        node->setColorError(0);
+        result.cost = whole;
+        merged += result.leaves - 1;
+        result.leaves = 1;
+    }
+    return result;
+}
+
+double QuadTreeSplitter::encodedTileCost(const CostModel& model,
+                                         uint64_t uniformPixels,
+                                         uint64_t busyPixels) {
+    double bytes = model.busyBytesPerPixel * busyPixels +
+                   model.uniformBytesPerPixel * uniformPixels;
+    return model.tileCost + model.fileCost + model.byteCost * bytes +
+           model.pixelCost * static_cast<double>(uniformPixels + busyPixels);
+}
+
+bool QuadTreeSplitter::isTerminalShape(const QuadTreeNode* node,
+                                       int imageWidth, int imageHeight,
+                                       const Config& config,
+                                       int currentDepth) const {
+    int actualWidth = std::min(node->getWidth(), imageWidth - node->getX());
+    int actualHeight = std::min(node->getHeight(), imageHeight - node->getY());
+
+    // 与 evaluateNode 中除颜色一致性以外的终止条件相同
+    return currentDepth >= config.maxDepth ||
+           actualWidth <= config.minTileSize ||
+           actualHeight <= config.minTileSize || actualWidth <= 1 ||
+           actualHeight <= 1;
+}
+
+ColorChecker::ColorRange QuadTreeSplitter::buildPyramidNode(
+    QuadTreeNode* node, const unsigned char* imageData, int imageWidth,
+    int imageHeight, const Config& config, int currentDepth) {
+    ColorChecker::ColorRange range;
+    if (node->getX() >= imageWidth || node->getY() >= imageHeight) {
+        return range;
+    }
+
+    if (isTerminalShape(node, imageWidth, imageHeight, config,
+                        currentDepth)) {
+        // 金字塔底层：扫描像素
+        int actualWidth = std::min(node->getWidth(), imageWidth - node->getX());
+        int actualHeight =
+            std::min(node->getHeight(), imageHeight - node->getY());
+        SplitProfile::Timer timer(
+            config.profile, SplitProfile::Phase::Uniformity,
+            static_cast<uint64_t>(actualWidth) * actualHeight * 4);
+        range = colorChecker_.computeRange(imageData, imageWidth, node->getX(),
+                                           node->getY(), actualWidth,
+                                           actualHeight);
+    } else {
+        // 内部节点：合并子节点的范围
+        node->subdivide();
+        for (const auto& child : node->getChildren()) {
+            range.merge(buildPyramidNode(child.get(), imageData, imageWidth,
+                                         imageHeight, config,
+                                         currentDepth + 1));
+        }
+    }
+
+    resolvePyramidNode(node, range,
+                       colorChecker_.getPixelColor(imageData, imageWidth,
+                                                   node->getX(), node->getY()));
+    return range;
+}
+
+void QuadTreeSplitter::resolvePyramidNode(
+    QuadTreeNode* node, const ColorChecker::ColorRange& range,
+    uint32_t referenceColor) {
+    if (colorChecker_.isUniformRange(range, referenceColor)) {
+        node->merge();
+        node->setUniformColor(colorChecker_.isTransparent(referenceColor)
+                                  ? 0
+                                  : referenceColor);
+        node->setHasUniformColor(true);
+    }
+}
+
+void QuadTreeSplitter::buildPyramidParallel(QuadTreeNode* root,
+                                            const unsigned char* imageData,
+                                            int imageWidth, int imageHeight,
+                                            const Config& config,
+                                            int numThreads) {
+    // 1. 按形状展开上层节点（先序），其余节点作为并行任务
+    std::vector<QuadTreeNode*> upperNodes;
+    std::vector<std::pair<QuadTreeNode*, int>> tasks;
+    std::vector<std::pair<QuadTreeNode*, int>> stack{{root, 0}};
+    while (!stack.empty()) {
+        QuadTreeNode* node = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+
+        long long area =
+            static_cast<long long>(node->getWidth()) * node->getHeight();
+        if (area <= config.serialSubtreePixels ||
+            isTerminalShape(node, imageWidth, imageHeight, config, depth)) {
+            tasks.emplace_back(node, depth);
+            continue;
+        }
+
+        node->subdivide();
+        upperNodes.push_back(node);
+        for (const auto& child : node->getChildren()) {
+            stack.emplace_back(child.get(), depth + 1);
+        }
+    }
+
+    // 2. 并行构建各子树
+    std::vector<ColorChecker::ColorRange> taskRanges(tasks.size());
+    {
+        std::unique_ptr<ThreadPool> ownPool;
+        ThreadPool* pool = config.pool;
+        if (!pool) {
+            ownPool = std::make_unique<ThreadPool>(numThreads);
+            pool = ownPool.get();
+        }
+        std::vector<std::future<void>> futures;
+        futures.reserve(tasks.size());
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            futures.push_back(pool->submit([&, i] {
+                taskRanges[i] =
+                    buildPyramidNode(tasks[i].first, imageData, imageWidth,
+                                     imageHeight, config, tasks[i].second);
+            }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+
+    std::unordered_map<const QuadTreeNode*, ColorChecker::ColorRange> ranges;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        ranges[tasks[i].first] = taskRanges[i];
+    }
+
+    // 3. 逆先序合并上层节点，保证子节点先于父节点完成
+    for (auto it = upperNodes.rbegin(); it != upperNodes.rend(); ++it) {
+        QuadTreeNode* node = *it;
+        ColorChecker::ColorRange range;
         for (const auto& child : node->getChildren()) {
-            subdivideNode(child.get(), imageData, imageWidth, imageHeight,
-                          config, currentDepth + 1);
+            range.merge(ranges[child.get()]);
         }
+        resolvePyramidNode(
+            node, range,
+            colorChecker_.getPixelColor(imageData, imageWidth, node->getX(),
+                                        node->getY()));
+        ranges[node] = range;
     }
 }
 
 void QuadTreeSplitter::collectLeafTiles(const QuadTreeNode* node,
-                                        const unsigned char* imageData,
                                         int imageWidth, int imageHeight,
-                                        const std::string& outDir,
-                                        std::vector<TileMeta>& tiles) {
+                                        std::vector<TileMeta>& tiles,
+                                        std::vector<TileJob>& jobs) {
     if (node->isLeaf()) {
         // 叶子节点，生成瓦片
         int x = node->getX();
@@ -152,7 +1107,6 @@ void QuadTreeSplitter::collectLeafTiles(const QuadTreeNode* node,
 
         // 生成瓦片文件名和处理纯色瓦片
         std::string fileName;
-        bool success = false;
 
         if (node->hasUniformColor()) {
             // 纯色瓦片：使用RGBA十六进制值作为文件名
@@ -162,88 +1116,655 @@ void QuadTreeSplitter::collectLeafTiles(const QuadTreeNode* node,
             fileName = std::string(hexColor);
 
             // 对于纯色瓦片，不需要生成实际的PNG文件
-            success = true;
+            log(2) << "Pure color tile: (" << x << "," << y << ") "
+                   << actualWidth << "x" << actualHeight
+                   << " -> color: " << fileName << std::endl;
         } else {
-            // 混合颜色瓦片：生成正常的瓦片文件
+            // 混合颜色瓦片：登记编码任务，稍后统一写出
             fileName = generateTileFileName(x, y, width, height);
-            std::string filePath = outDir + "/" + fileName;
+            jobs.push_back(TileJob{x, y, width, height, fileName});
+        }
+
+        // 添加到瓦片元数据
+        TileMeta meta;
+        meta.x = x;
+        meta.y = y;
+        meta.w = actualWidth;
+        meta.h = actualHeight;
+        meta.file = fileName;
+        meta.err = node->getColorError();
+        tiles.push_back(meta);
+    } else {
+        // 内部节点，递归处理子节点
+        for (const auto& child : node->getChildren()) {
+            collectLeafTiles(child.get(), imageWidth, imageHeight, tiles,
+                             jobs);
+        }
+    }
+}
+
+TileWriter::Config QuadTreeSplitter::writerConfigFor(const Config& config) {
+    TileWriter::Config writerConfig;
+    writerConfig.numThreads = config.numThreads;
+    writerConfig.maxInFlightBytes = config.maxInFlightBytes;
+    writerConfig.packOutput = config.packOutput;
+    writerConfig.codec = config.codec;
+    writerConfig.dedupContent = config.dedupContent;
+    writerConfig.profile = config.profile;
+    writerConfig.pool = config.pool;
+    writerConfig.memoryBudget = config.memoryBudget;
+    writerConfig.encodeCache = config.encodeCache;
+    writerConfig.paletteTiles = config.paletteTiles;
+    writerConfig.reduceChannels = config.reduceChannels;
+    writerConfig.rleTiles = config.rleTiles;
+    return writerConfig;
+}
+
+void QuadTreeSplitter::enableTrimming(std::vector<TileMeta>& tiles,
+                                      std::vector<TileJob>& jobs) {
+    removeTransparentTiles(tiles);
+    for (auto& job : jobs) {
+        job.trim = true;
+    }
+}
+
+void QuadTreeSplitter::removeTransparentTiles(std::vector<TileMeta>& tiles) {
+    // 完全透明的纯色瓦片不影响绘制结果，直接去掉
+    tiles.erase(
+        std::remove_if(tiles.begin(), tiles.end(), isTransparentColorTile),
+        tiles.end());
+}
+
+bool QuadTreeSplitter::dropsTransparent(const Config& config) {
+    return config.trimTransparent || config.transparentAlpha >= 0;
+}
+
+void QuadTreeSplitter::reportLossyTiles(
+    const std::vector<TileMeta>& tiles) const {
+    size_t lossyTiles = 0;
+    long long lossyPixels = 0;
+    int maxError = 0;
+    for (const auto& tile : tiles) {
+        if (tile.err > 0) {
+            ++lossyTiles;
+            lossyPixels += static_cast<long long>(tile.w) * tile.h;
+            maxError = std::max(maxError, tile.err);
+        }
+    }
+    log(1) << "Lossy coarsening: " << lossyTiles << " tiles replaced by "
+           << "their mean color (" << lossyPixels << " pixels, max error "
+           << maxError << ")" << std::endl;
+}
+
+void QuadTreeSplitter::mergeUniformTiles(std::vector<TileMeta>& tiles) const {
+    std::vector<TileMeta> rects;
+    size_t kept = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (isPureColorTile(tiles[i].file)) {
+            rects.push_back(std::move(tiles[i]));
+        } else {
+            if (i != kept) tiles[kept] = std::move(tiles[i]);
+            ++kept;
+        }
+    }
+    tiles.resize(kept);
+    const size_t before = rects.size();
+
+    // 一次合并：按（颜色, 行/列, 高/宽, 起点）排序后相接的瓦片首尾相连
+    auto mergePass = [&rects](bool horizontal) {
+        auto key = [horizontal](const TileMeta& t) {
+            return horizontal ? std::tie(t.file, t.lod, t.y, t.h, t.x)
+                              : std::tie(t.file, t.lod, t.x, t.w, t.y);
+        };
+        std::sort(rects.begin(), rects.end(),
+                  [&key](const TileMeta& a, const TileMeta& b) {
+                      return key(a) < key(b);
+                  });
+        bool merged = false;
+        size_t count = 0;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            if (count > 0) {
+                TileMeta& last = rects[count - 1];
+                const TileMeta& t = rects[i];
+                bool sameLine = last.file == t.file && last.lod == t.lod &&
+                                (horizontal ? last.y == t.y && last.h == t.h &&
+                                                  last.x + last.w == t.x
+                                            : last.x == t.x && last.w == t.w &&
+                                                  last.y + last.h == t.y);
+                if (sameLine) {
+                    (horizontal ? last.w : last.h) += horizontal ? t.w : t.h;
+                    last.err = std::max(last.err, t.err);
+                    merged = true;
+                    continue;
+                }
+            }
+            if (i != count) rects[count] = std::move(rects[i]);
+            ++count;
+        }
+        rects.resize(count);
+        return merged;
+    };
+
+    // 横向、纵向交替进行，连续两次没有合并即收敛
+    int idlePasses = 0;
+    for (bool horizontal = true; idlePasses < 2; horizontal = !horizontal) {
+        idlePasses = mergePass(horizontal) ? 0 : idlePasses + 1;
+    }
+
+    std::sort(rects.begin(), rects.end(),
+              [](const TileMeta& a, const TileMeta& b) {
+                  return std::tie(a.lod, a.y, a.x) < std::tie(b.lod, b.y, b.x);
+              });
+    log(1) << "Uniform merge: " << before << " pure color tiles -> "
+           << rects.size() << " rectangles" << std::endl;
+    for (auto& rect : rects) {
+        tiles.push_back(std::move(rect));
+    }
+}
+
+std::vector<size_t> QuadTreeSplitter::mapTilesToJobs(
+    const std::vector<TileMeta>& tiles) {
+    std::vector<size_t> tileJobs(tiles.size(), kNoJob);
+    size_t jobIndex = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (!isPureColorTile(tiles[i].file)) {
+            tileJobs[i] = jobIndex++;
+        }
+    }
+    return tileJobs;
+}
+
+void QuadTreeSplitter::orderAlongHilbert(std::vector<TileMeta>& tiles,
+                                         std::vector<size_t>& tileJobs,
+                                         std::vector<TileJob>& jobs,
+                                         int imageWidth, int imageHeight) {
+    std::vector<TileMeta> sortedTiles;
+    std::vector<size_t> sortedTileJobs;
+    std::vector<TileJob> sortedJobs;
+    sortedTiles.reserve(tiles.size());
+    sortedTileJobs.reserve(tiles.size());
+    sortedJobs.reserve(jobs.size());
+    std::vector<size_t> remap(jobs.size(), kNoJob);
+    for (size_t i : HilbertCurve::sortedOrder(tiles, imageWidth, imageHeight)) {
+        size_t jobIndex = tileJobs[i];
+        if (jobIndex != kNoJob) {
+            // 图集页等共享任务排在首个引用它的瓦片处
+            if (remap[jobIndex] == kNoJob) {
+                remap[jobIndex] = sortedJobs.size();
+                sortedJobs.push_back(std::move(jobs[jobIndex]));
+            }
+            jobIndex = remap[jobIndex];
+        }
+        sortedTiles.push_back(std::move(tiles[i]));
+        sortedTileJobs.push_back(jobIndex);
+    }
+    tiles = std::move(sortedTiles);
+    tileJobs = std::move(sortedTileJobs);
+    jobs = std::move(sortedJobs);
+}
+
+void QuadTreeSplitter::sortAlongHilbert(std::vector<TileMeta>& tiles,
+                                        int imageWidth, int imageHeight) {
+    std::vector<TileMeta> sorted;
+    sorted.reserve(tiles.size());
+    for (size_t i : HilbertCurve::sortedOrder(tiles, imageWidth, imageHeight)) {
+        sorted.push_back(std::move(tiles[i]));
+    }
+    tiles = std::move(sorted);
+}
 
-            success = generateTile(imageData, imageWidth, imageHeight, x, y,
-                                   width, height, filePath);
+void QuadTreeSplitter::buildAtlasPages(const unsigned char* imageData,
+                                       int imageWidth, const Config& config,
+                                       std::vector<TileMeta>& tiles,
+                                       std::vector<size_t>& tileJobs,
+                                       std::vector<TileJob>& jobs) const {
+    const int maxSize = std::min(config.atlasMaxTileSize, config.atlasPageSize);
+
+    // 选出小叶子，按实际尺寸（裁剪时按非透明包围盒）装箱；
+    // 裁剪后完全透明的叶子连同其任务一起去掉
+    std::vector<size_t> candidates;
+    std::vector<int> widths;
+    std::vector<int> heights;
+    std::vector<char> dropped(tiles.size(), 0);
+    std::vector<char> packed(jobs.size(), 0);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (tileJobs[i] == kNoJob) continue;
+        const TileJob& job = jobs[tileJobs[i]];
+        if (job.width > maxSize || job.height > maxSize) continue;
+        TileMeta& tile = tiles[i];
+        if (job.trim) {
+            int boundX, boundY, boundWidth, boundHeight;
+            if (!ColorChecker::opaqueBounds(imageData, imageWidth, tile.x,
+                                            tile.y, tile.w, tile.h, boundX,
+                                            boundY, boundWidth, boundHeight)) {
+                dropped[i] = 1;
+                packed[tileJobs[i]] = 1;
+                continue;
+            }
+            tile.x = boundX;
+            tile.y = boundY;
+            tile.w = boundWidth;
+            tile.h = boundHeight;
         }
+        candidates.push_back(i);
+        widths.push_back(tile.w);
+        heights.push_back(tile.h);
+    }
+    if (candidates.empty() &&
+        std::find(dropped.begin(), dropped.end(), 1) == dropped.end()) {
+        return;
+    }
+
+    AtlasPacker packer(config.atlasPageSize, config.atlasPageSize);
+    std::vector<AtlasPacker::Placement> placements =
+        packer.pack(widths, heights);
+    const auto& extents = packer.getPageExtents();
+
+    // 保留未打包叶子的任务，图集页任务追加在后
+    for (size_t k = 0; k < candidates.size(); ++k) {
+        if (placements[k].page >= 0) {
+            packed[tileJobs[candidates[k]]] = 1;
+        }
+    }
+    std::vector<size_t> remap(jobs.size(), kNoJob);
+    std::vector<TileJob> kept;
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        if (!packed[j]) {
+            remap[j] = kept.size();
+            kept.push_back(std::move(jobs[j]));
+        }
+    }
+    for (auto& jobIndex : tileJobs) {
+        if (jobIndex != kNoJob) jobIndex = remap[jobIndex];
+    }
+
+    const size_t firstPage = kept.size();
+    for (size_t page = 0; page < extents.size(); ++page) {
+        TileJob pageJob{0, 0, extents[page].width, extents[page].height,
+                        generateAtlasFileName(static_cast<int>(page))};
+        pageJob.pixels.assign(
+            static_cast<size_t>(pageJob.width) * pageJob.height * 4, 0);
+        kept.push_back(std::move(pageJob));
+    }
+
+    // 把叶子像素复制到图集页，元数据改为引用图集页
+    const size_t srcStride = static_cast<size_t>(imageWidth) * 4;
+    for (size_t k = 0; k < candidates.size(); ++k) {
+        const AtlasPacker::Placement& placement = placements[k];
+        if (placement.page < 0) continue;
+        TileMeta& tile = tiles[candidates[k]];
+        TileJob& pageJob = kept[firstPage + placement.page];
+        const size_t dstStride = static_cast<size_t>(pageJob.width) * 4;
+        for (int dy = 0; dy < tile.h; ++dy) {
+            std::memcpy(&pageJob.pixels[(placement.y + dy) * dstStride +
+                                        static_cast<size_t>(placement.x) * 4],
+                        imageData + (tile.y + dy) * srcStride +
+                            static_cast<size_t>(tile.x) * 4,
+                        static_cast<size_t>(tile.w) * 4);
+        }
+        tile.file = pageJob.fileName;
+        tile.srcX = placement.x;
+        tile.srcY = placement.y;
+        tileJobs[candidates[k]] = firstPage + placement.page;
+    }
+    jobs = std::move(kept);
+
+    size_t keptTiles = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        if (dropped[i]) continue;
+        if (keptTiles != i) {
+            tiles[keptTiles] = std::move(tiles[i]);
+            tileJobs[keptTiles] = tileJobs[i];
+        }
+        ++keptTiles;
+    }
+    tiles.resize(keptTiles);
+    tileJobs.resize(keptTiles);
+
+    log(1) << "Atlas: " << candidates.size() << " leaves packed into "
+           << extents.size() << " pages" << std::endl;
+}
+
+void QuadTreeSplitter::buildLodTiles(const unsigned char* imageData,
+                                     int imageWidth, int imageHeight,
+                                     const Config& config,
+                                     const QuadTreeNode* root,
+                                     std::vector<TileMeta>& tiles,
+                                     std::vector<size_t>& tileJobs,
+                                     std::vector<TileJob>& jobs) const {
+    std::vector<unsigned char> previous;
+    std::vector<unsigned char> current;
+    const unsigned char* source = imageData;
+    int levelWidth = imageWidth;
+    int levelHeight = imageHeight;
+    size_t lodTiles = 0;
+
+    for (int level = 1; level <= config.lodLevels; ++level) {
+        Downsampler::halve(source, levelWidth, levelHeight, current);
+        levelWidth = Downsampler::halfSize(levelWidth);
+        levelHeight = Downsampler::halfSize(levelHeight);
+        const int scale = 1 << level;
+        const long long maxSize = static_cast<long long>(config.lodTileSize)
+                                  << level;
+
+        std::vector<const QuadTreeNode*> stack{root};
+        while (!stack.empty()) {
+            const QuadTreeNode* node = stack.back();
+            stack.pop_back();
+            int x = node->getX();
+            int y = node->getY();
+            if (x >= imageWidth || y >= imageHeight) continue;
+            int width = std::min(node->getWidth(), imageWidth - x);
+            int height = std::min(node->getHeight(), imageHeight - y);
+            if (!node->isLeaf() && std::max(width, height) > maxSize) {
+                // 逆序压栈，按先序输出
+                const auto& children = node->getChildren();
+                for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                    stack.push_back(it->get());
+                }
+                continue;
+            }
+
+            // 块左上角位于节点内的降采样像素
+            int left = (x + scale - 1) >> level;
+            int top = (y + scale - 1) >> level;
+            int right = (x + width + scale - 1) >> level;
+            int bottom = (y + height + scale - 1) >> level;
+            if (left >= right || top >= bottom) continue;
 
-        if (success) {
-            // 添加到瓦片元数据
             TileMeta meta;
             meta.x = x;
             meta.y = y;
-            meta.w = actualWidth;
-            meta.h = actualHeight;
-            meta.file = fileName;
-            tiles.push_back(meta);
-
-            // 输出调试信息
-            if (node->hasUniformColor()) {
-                std::cout << "Pure color tile: (" << x << "," << y << ") "
-                          << actualWidth << "x" << actualHeight
-                          << " -> color: " << fileName << std::endl;
+            meta.w = width;
+            meta.h = height;
+            meta.lod = level;
+
+            bool blocksInside =
+                ((right << level) <= x + width || x + width == imageWidth) &&
+                ((bottom << level) <= y + height || y + height == imageHeight);
+            if (node->isLeaf() && node->hasUniformColor() && blocksInside) {
+                uint32_t color = node->getUniformColor();
+                if (dropsTransparent(config) && (color & 0xFF) == 0) continue;
+                char hexColor[10];
+                snprintf(hexColor, sizeof(hexColor), "%08X", color);
+                meta.file = hexColor;
+                tileJobs.push_back(kNoJob);
+            } else {
+                TileJob job{0, 0, right - left, bottom - top,
+                            generateLodFileName(level, x, y, width, height)};
+                job.pixels.resize(static_cast<size_t>(job.width) *
+                                  job.height * 4);
+                const size_t stride = static_cast<size_t>(levelWidth) * 4;
+                for (int row = 0; row < job.height; ++row) {
+                    std::memcpy(&job.pixels[static_cast<size_t>(row) *
+                                            job.width * 4],
+                                &current[(top + row) * stride +
+                                         static_cast<size_t>(left) * 4],
+                                static_cast<size_t>(job.width) * 4);
+                }
+                meta.file = job.fileName;
+                tileJobs.push_back(jobs.size());
+                jobs.push_back(std::move(job));
             }
+            tiles.push_back(std::move(meta));
+            ++lodTiles;
         }
-    } else {
-        // 内部节点，递归处理子节点
-        for (const auto& child : node->getChildren()) {
-            collectLeafTiles(child.get(), imageData, imageWidth, imageHeight,
-                             outDir, tiles);
+
+        previous.swap(current);
+        source = previous.data();
+    }
+
+    log(1) << "LOD: " << lodTiles << " tiles over " << config.lodLevels
+           << " levels" << std::endl;
+}
+
+void QuadTreeSplitter::applyWriteResults(
+    std::vector<TileMeta>& tiles, const std::vector<size_t>& tileJobs,
+    const std::vector<bool>& written, const std::vector<TileOutput>& outputs) {
+    std::vector<TileMeta> writtenTiles;
+    writtenTiles.reserve(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        size_t jobIndex = tileJobs[i];
+        if (jobIndex != kNoJob) {
+            const TileOutput& output = outputs[jobIndex];
+            if (!written[jobIndex] || output.empty) {
+                continue;
+            }
+            tiles[i].file = output.fileName;
+            if (output.trimmed) {
+                // 图集页任务不裁剪，裁剪的任务与瓦片一一对应
+                tiles[i].x += output.x;
+                tiles[i].y += output.y;
+                tiles[i].w = output.width;
+                tiles[i].h = output.height;
+            }
         }
+        writtenTiles.push_back(std::move(tiles[i]));
     }
+    tiles = std::move(writtenTiles);
 }
 
-bool QuadTreeSplitter::generateTile(const unsigned char* imageData,
-                                    int imageWidth, int imageHeight, int x,
-                                    int y, int width, int height,
-                                    const std::string& outputPath) {
-    // 计算实际输出尺寸
-    int actualWidth = std::min(width, imageWidth - x);
-    int actualHeight = std::min(height, imageHeight - y);
+void QuadTreeSplitter::subdivideIncremental(
+    QuadTreeNode* node, const unsigned char* imageData, int imageWidth,
+    int imageHeight, const Config& config, int currentDepth,
+    const std::vector<LeafHash>& previous, const std::vector<size_t>& dirty,
+    const std::unordered_map<uint64_t, size_t>& leafAt,
+    std::unordered_map<const QuadTreeNode*, size_t>& reused) {
+    if (dirty.empty()) {
+        // 子树只取决于节点区域内的像素；区域未变化时该节点也是上次的
+        // 节点，其子树的第一个叶子与它左上角相同
+        auto it = leafAt.find(nodeKey(node->getX(), node->getY()));
+        if (it != leafAt.end() &&
+            previous[it->second].width <= node->getWidth() &&
+            previous[it->second].height <= node->getHeight()) {
+            reused[node] = it->second;
+            return;
+        }
+        subdivideNode(node, imageData, imageWidth, imageHeight, config,
+                      currentDepth);
+        return;
+    }
 
-    if (actualWidth <= 0 || actualHeight <= 0) {
-        return false;
+    if (!evaluateNode(node, imageData, imageWidth, imageHeight, config,
+                      currentDepth)) {
+        return;
+    }
+    for (const auto& child : node->getChildren()) {
+        std::vector<size_t> childDirty;
+        for (size_t index : dirty) {
+            const LeafHash& leaf = previous[index];
+            if (leaf.x < child->getX() + child->getWidth() &&
+                child->getX() < leaf.x + leaf.width &&
+                leaf.y < child->getY() + child->getHeight() &&
+                child->getY() < leaf.y + leaf.height) {
+                childDirty.push_back(index);
+            }
+        }
+        subdivideIncremental(child.get(), imageData, imageWidth, imageHeight,
+                             config, currentDepth + 1, previous, childDirty,
+                             leafAt, reused);
     }
+}
 
-    // 创建瓦片数据（只处理非纯色瓦片）
-    std::vector<unsigned char> tileData(width * height * 4);
+void QuadTreeSplitter::collectIncremental(
+    const QuadTreeNode* node, const unsigned char* imageData, int imageWidth,
+    int imageHeight, const Config& config,
+    const std::vector<LeafHash>& previous,
+    const std::vector<TileMeta>& previousTiles,
+    const std::vector<size_t>& firstTile,
+    const std::unordered_map<const QuadTreeNode*, size_t>& reused,
+    std::vector<TileMeta>& tiles, std::vector<size_t>& tileJobs,
+    std::vector<TileJob>& jobs, std::vector<LeafHash>& leaves) {
+    auto it = reused.find(node);
+    if (it != reused.end()) {
+        // 子树的叶子在上次的叶子列表中连续排列
+        LeafHash bounds{node->getX(), node->getY(), node->getWidth(),
+                        node->getHeight(), {}};
+        size_t end = it->second;
+        while (end < previous.size() && contains(bounds, previous[end])) {
+            leaves.push_back(previous[end++]);
+        }
+        for (size_t i = firstTile[it->second]; i < firstTile[end]; ++i) {
+            tiles.push_back(previousTiles[i]);
+            tileJobs.push_back(kNoJob);
+        }
+        return;
+    }
 
-    // 从原图复制数据
-    for (int dy = 0; dy < height; ++dy) {
-        for (int dx = 0; dx < width; ++dx) {
-            int srcX = x + dx;
-            int srcY = y + dy;
+    if (!node->isLeaf()) {
+        for (const auto& child : node->getChildren()) {
+            collectIncremental(child.get(), imageData, imageWidth, imageHeight,
+                               config, previous, previousTiles, firstTile,
+                               reused, tiles, tileJobs, jobs, leaves);
+        }
+        return;
+    }
+    if (node->getX() >= imageWidth || node->getY() >= imageHeight) {
+        return;
+    }
 
-            if (srcX < imageWidth && srcY < imageHeight) {
-                // 复制像素数据
-                const unsigned char* srcPixel =
-                    &imageData[(srcY * imageWidth + srcX) * 4];
-                unsigned char* dstPixel = &tileData[(dy * width + dx) * 4];
+    leaves.push_back(LeafHash{
+        node->getX(), node->getY(), node->getWidth(), node->getHeight(),
+        hashLeaf(imageData, imageWidth, imageHeight, node->getX(),
+                 node->getY(), node->getWidth(), node->getHeight())});
+    size_t jobCount = jobs.size();
+    collectLeafTiles(node, imageWidth, imageHeight, tiles, jobs);
+    if (jobs.size() > jobCount) {
+        jobs.back().trim = config.trimTransparent;
+        tileJobs.push_back(jobCount);
+    } else if (dropsTransparent(config) &&
+               isTransparentColorTile(tiles.back())) {
+        tiles.pop_back();
+    } else {
+        tileJobs.push_back(kNoJob);
+    }
+}
 
-                dstPixel[0] = srcPixel[0];  // R
-                dstPixel[1] = srcPixel[1];  // G
-                dstPixel[2] = srcPixel[2];  // B
-                dstPixel[3] = srcPixel[3];  // A
-            } else {
-                // 超出边界，填充透明像素
-                unsigned char* dstPixel = &tileData[(dy * width + dx) * 4];
-                dstPixel[0] = 0;
-                dstPixel[1] = 0;
-                dstPixel[2] = 0;
-                dstPixel[3] = 0;
-            }
+std::pair<uint64_t, uint64_t> QuadTreeSplitter::hashLeaf(
+    const unsigned char* imageData, int imageWidth, int imageHeight, int x,
+    int y, int width, int height) {
+    return TileWriter::hashRegion(imageData, imageWidth, x, y,
+                                  std::min(width, imageWidth - x),
+                                  std::min(height, imageHeight - y));
+}
+
+bool QuadTreeSplitter::contains(const LeafHash& leaf, const TileMeta& tile) {
+    return tile.x >= leaf.x && tile.y >= leaf.y &&
+           tile.x + tile.w <= leaf.x + leaf.width &&
+           tile.y + tile.h <= leaf.y + leaf.height;
+}
+
+bool QuadTreeSplitter::contains(const LeafHash& node, const LeafHash& leaf) {
+    return leaf.x >= node.x && leaf.y >= node.y &&
+           leaf.x + leaf.width <= node.x + node.width &&
+           leaf.y + leaf.height <= node.y + node.height;
+}
+
+size_t QuadTreeSplitter::findLeaf(
+    const std::vector<LeafHash>& leaves,
+    const std::unordered_map<uint64_t, size_t>& leafAt, int imageWidth,
+    int imageHeight, int x, int y) {
+    // 与 QuadTreeNode::subdivide 相同的划分：左上子节点取一半（向下取整）
+    int nodeX = 0;
+    int nodeY = 0;
+    int nodeWidth = imageWidth;
+    int nodeHeight = imageHeight;
+    while (true) {
+        auto it = leafAt.find(nodeKey(nodeX, nodeY));
+        if (it != leafAt.end() && leaves[it->second].width == nodeWidth &&
+            leaves[it->second].height == nodeHeight) {
+            return it->second;
         }
+        int halfWidth = nodeWidth / 2;
+        int halfHeight = nodeHeight / 2;
+        if (halfWidth <= 0 || halfHeight <= 0) {
+            return kNoJob;
+        }
+        if (x >= nodeX + halfWidth) {
+            nodeX += halfWidth;
+            nodeWidth -= halfWidth;
+        } else {
+            nodeWidth = halfWidth;
+        }
+        if (y >= nodeY + halfHeight) {
+            nodeY += halfHeight;
+            nodeHeight -= halfHeight;
+        } else {
+            nodeHeight = halfHeight;
+        }
+    }
+}
+
+std::string QuadTreeSplitter::describeConfig(const Config& config,
+                                             int imageWidth, int imageHeight) {
+    // 影响四叉树形状或瓦片内容的参数，任一不同时不能沿用上次的结果
+    return "# config depth=" + std::to_string(config.maxDepth) +
+           " min=" + std::to_string(config.minTileSize) +
+           " tolerance=" + std::to_string(config.colorTolerance) +
+           " transparent=" + std::to_string(config.transparentAlpha) +
+           " codec=" + TileCodec::name(config.codec) +
+           " trim=" + std::to_string(config.trimTransparent ? 1 : 0) +
+           " dedup=" + std::to_string(config.dedupContent ? 1 : 0) +
+           " palette=" + std::to_string(config.paletteTiles ? 1 : 0) +
+           " channels=" + std::to_string(config.reduceChannels ? 1 : 0) +
+           " rle=" + std::to_string(config.rleTiles ? 1 : 0) +
+           " lossy=" + std::to_string(config.lossyMaxError) + "," +
+           std::to_string(config.lossyMinPsnr) +
+           " cost=" + std::to_string(config.costSplit ? 1 : 0) +
+           " size=" + std::to_string(imageWidth) + "x" +
+           std::to_string(imageHeight);
+}
+
+bool QuadTreeSplitter::loadLeafHashes(const std::string& path,
+                                      const std::string& configLine,
+                                      std::vector<LeafHash>& leaves) {
+    leaves.clear();
+    std::ifstream fin(path);
+    if (!fin) return false;
+    std::string line;
+    std::getline(fin, line);  // header
+    bool configMatches = false;
+    while (std::getline(fin, line)) {
+        if (line.empty()) continue;
+        if (line[0] == '#') {
+            configMatches = configMatches || line == configLine;
+            continue;
+        }
+        std::stringstream ss(line);
+        LeafHash leaf;
+        std::string hex;
+        if (!(ss >> leaf.x >> leaf.y >> leaf.width >> leaf.height >> hex) ||
+            hex.size() != 32) {
+            leaves.clear();
+            return false;
+        }
+        try {
+            leaf.hash.first = std::stoull(hex.substr(0, 16), nullptr, 16);
+            leaf.hash.second = std::stoull(hex.substr(16), nullptr, 16);
+        } catch (const std::exception&) {
+            leaves.clear();
+            return false;
+        }
+        leaves.push_back(leaf);
     }
+    if (!configMatches) {
+        leaves.clear();
+    }
+    return configMatches;
+}
 
-    // 保存PNG文件
-    int result = stbi_write_png(outputPath.c_str(), width, height, 4,
-                                tileData.data(), width * 4);
-    return result != 0;
+bool QuadTreeSplitter::saveLeafHashes(const std::string& path,
+                                      const std::string& configLine,
+                                      const std::vector<LeafHash>& leaves) {
+    std::ofstream fout(path);
+    if (!fout) return false;
+    fout << "x y w h hash" << '\n' << configLine << '\n';
+    for (const LeafHash& leaf : leaves) {
+        fout << leaf.x << ' ' << leaf.y << ' ' << leaf.width << ' '
+             << leaf.height << ' ' << TileWriter::hashToHex(leaf.hash)
+             << '\n';
+    }
+    return static_cast<bool>(fout);
 }
 
 bool QuadTreeSplitter::ensureDirectoryExists(const std::string& outDir) {
@@ -260,7 +1781,25 @@ bool QuadTreeSplitter::ensureDirectoryExists(const std::string& outDir) {
 std::string QuadTreeSplitter::generateTileFileName(int x, int y, int width,
                                                    int height) const {
     return "qtile_" + std::to_string(x) + "_" + std::to_string(y) + "_" +
-           std::to_string(width) + "x" + std::to_string(height) + ".png";
+           std::to_string(width) + "x" + std::to_string(height) +
+           TileCodec::extension(codec_);
+}
+
+std::string QuadTreeSplitter::generateAtlasFileName(int page) const {
+    return "atlas_" + std::to_string(page) + TileCodec::extension(codec_);
+}
+
+std::string QuadTreeSplitter::generateLodFileName(int level, int x, int y,
+                                                  int width,
+                                                  int height) const {
+    return "lod" + std::to_string(level) + "_" + std::to_string(x) + "_" +
+           std::to_string(y) + "_" + std::to_string(width) + "x" +
+           std::to_string(height) + TileCodec::extension(codec_);
+}
+
+bool QuadTreeSplitter::isTransparentColorTile(const TileMeta& tile) {
+    return isPureColorTile(tile.file) &&
+           (parseColorFromFileName(tile.file) & 0xFF) == 0;
 }
 
 bool QuadTreeSplitter::isPureColorTile(const std::string& fileName) {
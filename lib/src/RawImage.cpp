@@ -0,0 +1,92 @@
+#include "RawImage.hpp"
+
+#include <cstring>
+
+#include "stb_image.h"
+
+namespace {
+
+const char kRawMagic[8] = {'M', 'F', 'R', 'G', 'B', 'A', '0', '1'};
+
+uint32_t readLE32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void writeLE32(unsigned char* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+}  // namespace
+
+bool RawImageReader::open(const std::string& path) {
+    file_.close();
+    file_.clear();
+    file_.open(path, std::ios::binary);
+    if (!file_) return false;
+
+    unsigned char header[kHeaderSize];
+    if (!file_.read(reinterpret_cast<char*>(header), kHeaderSize)) {
+        return false;
+    }
+    if (std::memcmp(header, kRawMagic, sizeof(kRawMagic)) != 0) {
+        return false;
+    }
+    uint32_t w = readLE32(header + 8);
+    uint32_t h = readLE32(header + 12);
+    if (w == 0 || h == 0 || w > 0x7FFFFFFF || h > 0x7FFFFFFF) {
+        return false;
+    }
+    width_ = static_cast<int>(w);
+    height_ = static_cast<int>(h);
+    return true;
+}
+
+bool RawImageReader::readRows(int y, int rows, unsigned char* dst) {
+    if (y < 0 || rows <= 0 || y + rows > height_) return false;
+
+    const std::streamoff rowBytes = static_cast<std::streamoff>(width_) * 4;
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(kHeaderSize) + y * rowBytes);
+    return static_cast<bool>(
+        file_.read(reinterpret_cast<char*>(dst), rows * rowBytes));
+}
+
+bool RawImageReader::isRawImage(const std::string& path) {
+    std::ifstream fin(path, std::ios::binary);
+    char magic[sizeof(kRawMagic)];
+    if (!fin.read(magic, sizeof(magic))) return false;
+    return std::memcmp(magic, kRawMagic, sizeof(kRawMagic)) == 0;
+}
+
+bool RawImageReader::write(const std::string& path, const unsigned char* data,
+                           int width, int height) {
+    std::ofstream fout(path, std::ios::binary);
+    if (!fout) return false;
+
+    unsigned char header[kHeaderSize];
+    std::memcpy(header, kRawMagic, sizeof(kRawMagic));
+    writeLE32(header + 8, static_cast<uint32_t>(width));
+    writeLE32(header + 12, static_cast<uint32_t>(height));
+    fout.write(reinterpret_cast<const char*>(header), kHeaderSize);
+    fout.write(reinterpret_cast<const char*>(data),
+               static_cast<std::streamsize>(width) * height * 4);
+    return static_cast<bool>(fout);
+}
+
+bool RawImageReader::convert(const std::string& imagePath,
+                             const std::string& rawPath) {
+    int width, height, channels;
+    unsigned char* data =
+        stbi_load(imagePath.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        return false;
+    }
+    bool ok = write(rawPath, data, width, height);
+    stbi_image_free(data);
+    return ok;
+}
@@ -0,0 +1,131 @@
+#include "SplitProfile.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "QuadTreeNode.hpp"
+
+SplitProfile::SplitProfile() : start_(Clock::now()) {}
+
+void SplitProfile::add(Phase phase, Clock::duration elapsed, uint64_t bytes) {
+    PhaseTotals& totals = phases_[static_cast<int>(phase)];
+    totals.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              elapsed)
+                              .count();
+    ++totals.calls;
+    totals.bytes += bytes;
+}
+
+void SplitProfile::setImageSize(int width, int height) {
+    imageWidth_ = width;
+    imageHeight_ = height;
+}
+
+void SplitProfile::recordTree(const QuadTreeNode* root, int imageWidth,
+                              int imageHeight) {
+    if (root) {
+        recordNode(root, 0, imageWidth, imageHeight);
+    }
+}
+
+void SplitProfile::recordNode(const QuadTreeNode* node, int depth,
+                              int imageWidth, int imageHeight) {
+    if (node->getX() >= imageWidth || node->getY() >= imageHeight) {
+        return;
+    }
+    if (!node->isLeaf()) {
+        for (const auto& child : node->getChildren()) {
+            recordNode(child.get(), depth + 1, imageWidth, imageHeight);
+        }
+        return;
+    }
+
+    if (depths_.size() <= static_cast<size_t>(depth)) {
+        depths_.resize(depth + 1);
+    }
+    ++depths_[depth].leaves;
+    if (node->hasUniformColor()) {
+        ++depths_[depth].pure;
+    }
+
+    int width = std::min(node->getWidth(), imageWidth - node->getX());
+    int height = std::min(node->getHeight(), imageHeight - node->getY());
+    int side = std::max(width, height);
+    size_t bucket = 0;
+    while ((1 << bucket) < side) {
+        ++bucket;
+    }
+    if (sizeBuckets_.size() <= bucket) {
+        sizeBuckets_.resize(bucket + 1, 0);
+    }
+    ++sizeBuckets_[bucket];
+}
+
+const char* SplitProfile::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Decode:
+            return "decode";
+        case Phase::TreeBuild:
+            return "tree_build";
+        case Phase::Uniformity:
+            return "uniformity";
+        case Phase::Encode:
+            return "encode";
+        case Phase::Write:
+            return "write";
+    }
+    return "unknown";
+}
+
+std::string SplitProfile::toJson() const {
+    double totalMs =
+        std::chrono::duration<double, std::milli>(Clock::now() - start_)
+            .count();
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"image\": {\"width\": " << imageWidth_
+        << ", \"height\": " << imageHeight_ << "},\n";
+    out << "  \"total_ms\": " << totalMs << ",\n";
+    out << "  \"phases\": {\n";
+    for (int i = 0; i < kPhaseCount; ++i) {
+        const PhaseTotals& totals = phases_[i];
+        out << "    \"" << phaseName(static_cast<Phase>(i)) << "\": {\"ms\": "
+            << totals.nanoseconds.load() / 1e6
+            << ", \"calls\": " << totals.calls.load()
+            << ", \"bytes\": " << totals.bytes.load() << "}"
+            << (i + 1 < kPhaseCount ? ",\n" : "\n");
+    }
+    out << "  },\n";
+    out << "  \"tiles\": " << tileCount_ << ",\n";
+    out << "  \"leaves_by_depth\": [";
+    for (size_t depth = 0; depth < depths_.size(); ++depth) {
+        out << (depth ? ",\n" : "\n") << "    {\"depth\": " << depth
+            << ", \"leaves\": " << depths_[depth].leaves
+            << ", \"pure\": " << depths_[depth].pure << "}";
+    }
+    out << (depths_.empty() ? "],\n" : "\n  ],\n");
+    out << "  \"leaf_size_histogram\": [";
+    bool first = true;
+    for (size_t bucket = 0; bucket < sizeBuckets_.size(); ++bucket) {
+        if (sizeBuckets_[bucket] == 0) continue;
+        out << (first ? "\n" : ",\n") << "    {\"max_side\": " << (1 << bucket)
+            << ", \"leaves\": " << sizeBuckets_[bucket] << "}";
+        first = false;
+    }
+    out << (first ? "]\n" : "\n  ]\n");
+    out << "}\n";
+    return out.str();
+}
+
+bool SplitProfile::writeJson(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    file << toJson();
+    return static_cast<bool>(file);
+}
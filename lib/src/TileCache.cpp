@@ -31,42 +31,74 @@ void TileCache::put(const std::string& tileId, std::vector<unsigned char>&& data
                    int width, int height, int channels) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto existingIt = cache_.find(tileId);
-    if (existingIt != cache_.end()) {
-        removeTile(tileId);
-    }
-    
-    size_t tileSize = data.size() + sizeof(CachedTile) + tileId.size();
-    
-    evictIfNeeded();
+    insertTile(std::make_shared<CachedTile>(tileId, std::move(data), width, height, channels));
+}
+
+void TileCache::putPureColor(const std::string& tileId, uint32_t color, int width, int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    while ((stats_.totalMemoryUsed + tileSize > config_.maxMemoryBytes || 
-            stats_.totalTiles >= config_.maxTileCount) && !cache_.empty()) {
-        evictLRU();
-    }
+    std::vector<unsigned char> emptyData;
+    insertTile(std::make_shared<CachedTile>(tileId, std::move(emptyData), 
+                                            width, height, 4, true, color));
+}
+
+void TileCache::putPalette(const std::string& tileId, std::shared_ptr<const PaletteImage> image) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    auto tile = std::make_shared<CachedTile>(tileId, std::move(data), width, height, channels);
+    std::vector<unsigned char> emptyData;
+    auto tile = std::make_shared<CachedTile>(tileId, std::move(emptyData), 
+                                             image->width, image->height, 4);
+    // Only the palette and the packed indices count against the budget
+    tile->sizeBytes = image->sizeBytes();
+    tile->palette = std::move(image);
+    insertTile(tile);
+}
+
+void TileCache::putBlocks(const std::string& tileId, std::shared_ptr<const BlockImage> image) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    cache_[tileId] = tile;
-    stats_.totalMemoryUsed += tileSize;
-    stats_.totalTiles++;
+    std::vector<unsigned char> emptyData;
+    auto tile = std::make_shared<CachedTile>(tileId, std::move(emptyData), 
+                                             image->width, image->height, 4);
+    // Charged at the compressed size, which is what a GPU upload would take
+    tile->sizeBytes = image->sizeBytes();
+    tile->blocks = std::move(image);
+    insertTile(tile);
+}
+
+void TileCache::putChannels(const std::string& tileId, std::shared_ptr<const ChannelImage> image) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    if (config_.enableLRU) {
-        lruList_.push_front(tileId);
-        lruMap_[tileId] = lruList_.begin();
-    }
+    std::vector<unsigned char> emptyData;
+    auto tile = std::make_shared<CachedTile>(tileId, std::move(emptyData), 
+                                             image->width, image->height,
+                                             image->channels());
+    // 3 or 1 bytes per pixel instead of 4
+    tile->sizeBytes = image->sizeBytes();
+    tile->reduced = std::move(image);
+    insertTile(tile);
 }
 
-void TileCache::putPureColor(const std::string& tileId, uint32_t color, int width, int height) {
+void TileCache::putRle(const std::string& tileId, std::shared_ptr<const RleImage> image) {
     std::lock_guard<std::mutex> lock(mutex_);
     
+    std::vector<unsigned char> emptyData;
+    auto tile = std::make_shared<CachedTile>(tileId, std::move(emptyData), 
+                                             image->width, image->height, 4);
+    // Only the runs and the row index count against the budget
+    tile->sizeBytes = image->sizeBytes();
+    tile->rle = std::move(image);
+    insertTile(tile);
+}
+
+void TileCache::insertTile(const std::shared_ptr<CachedTile>& tile) {
+    const std::string& tileId = tile->tileId;
     auto existingIt = cache_.find(tileId);
     if (existingIt != cache_.end()) {
         removeTile(tileId);
     }
     
-    std::vector<unsigned char> emptyData;
-    size_t tileSize = sizeof(CachedTile) + tileId.size();
+    size_t tileSize = tile->sizeBytes + sizeof(CachedTile) + tileId.size();
     
     evictIfNeeded();
     
@@ -75,9 +107,6 @@ void TileCache::putPureColor(const std::string& tileId, uint32_t color, int widt
         evictLRU();
     }
     
-    auto tile = std::make_shared<CachedTile>(tileId, std::move(emptyData), 
-                                            width, height, 4, true, color);
-    
     cache_[tileId] = tile;
     stats_.totalMemoryUsed += tileSize;
     stats_.totalTiles++;
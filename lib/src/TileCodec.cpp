@@ -0,0 +1,1056 @@
+#include "TileCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+namespace {
+
+// QOI 格式常量，见 https://qoiformat.org/qoi-specification.pdf
+const unsigned char kQoiMagic[4] = {'q', 'o', 'i', 'f'};
+constexpr size_t kQoiHeaderSize = 14;
+constexpr size_t kQoiPaddingSize = 8;
+constexpr unsigned char kQoiOpIndex = 0x00;
+constexpr unsigned char kQoiOpDiff = 0x40;
+constexpr unsigned char kQoiOpLuma = 0x80;
+constexpr unsigned char kQoiOpRun = 0xC0;
+constexpr unsigned char kQoiOpRgb = 0xFE;
+constexpr unsigned char kQoiOpRgba = 0xFF;
+constexpr unsigned char kQoiMask = 0xC0;
+
+// 调色板格式常量
+const unsigned char kPaletteMagic[4] = {'m', 'f', 'p', 'l'};
+constexpr size_t kPaletteHeaderSize = 13;
+
+// 块压缩格式常量
+const unsigned char kBlockMagic[4] = {'m', 'f', 'b', 'c'};
+constexpr size_t kBlockHeaderSize = 13;
+
+// 通道精简格式常量
+const unsigned char kChannelMagic[4] = {'m', 'f', 'c', 'h'};
+constexpr size_t kChannelHeaderSize = 16;
+
+// 行程编码格式常量
+const unsigned char kRleMagic[4] = {'m', 'f', 'r', 'l'};
+constexpr size_t kRleHeaderSize = 16;
+constexpr size_t kRleRunSize = 6;
+constexpr int kMaxRunLength = 0xFFFF;
+
+// 数出行程编码的段数；编码后不小于 RGBA 原始大小时返回 0
+size_t countRuns(const unsigned char* pixels, int width, int height) {
+    const size_t rawBytes = static_cast<size_t>(width) * height * 4;
+    if (rawBytes <= kRleHeaderSize) return 0;
+    const size_t maxRuns = (rawBytes - kRleHeaderSize) / kRleRunSize;
+    size_t runs = 0;
+    for (int y = 0; y < height && runs < maxRuns; ++y) {
+        const unsigned char* row = pixels + static_cast<size_t>(y) * width * 4;
+        int length = 0;
+        for (int x = 0; x < width; ++x) {
+            if (length == kMaxRunLength ||
+                (x > 0 && std::memcmp(row + x * 4, row + x * 4 - 4, 4) != 0)) {
+                ++runs;
+                length = 0;
+            }
+            ++length;
+        }
+        ++runs;
+    }
+    return runs < maxRuns ? runs : 0;
+}
+
+// 4x4 块内的 RGBA 像素，行优先
+using BlockPixels = unsigned char[16][4];
+
+struct Rgba {
+    unsigned char r, g, b, a;
+
+    bool operator==(const Rgba& o) const {
+        return r == o.r && g == o.g && b == o.b && a == o.a;
+    }
+};
+
+inline int qoiHash(const Rgba& p) {
+    return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64;
+}
+
+void putBE32(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back(static_cast<unsigned char>(v >> 24));
+    out.push_back(static_cast<unsigned char>(v >> 16));
+    out.push_back(static_cast<unsigned char>(v >> 8));
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+uint32_t getBE32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+void appendToVector(void* context, void* data, int size) {
+    auto* out = static_cast<std::vector<unsigned char>*>(context);
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    out->insert(out->end(), bytes, bytes + size);
+}
+
+bool encodeQoi(const unsigned char* pixels, int width, int height,
+               std::vector<unsigned char>& out) {
+    const size_t count = static_cast<size_t>(width) * height;
+    // 最坏情况每像素 5 字节
+    out.reserve(out.size() + kQoiHeaderSize + count * 5 + kQoiPaddingSize);
+
+    out.insert(out.end(), kQoiMagic, kQoiMagic + 4);
+    putBE32(out, static_cast<uint32_t>(width));
+    putBE32(out, static_cast<uint32_t>(height));
+    out.push_back(4);  // channels: RGBA
+    out.push_back(0);  // colorspace: sRGB + linear alpha
+
+    Rgba index[64] = {};
+    Rgba prev{0, 0, 0, 255};
+    int run = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* p = pixels + i * 4;
+        Rgba px{p[0], p[1], p[2], p[3]};
+
+        if (px == prev) {
+            ++run;
+            if (run == 62 || i + 1 == count) {
+                out.push_back(kQoiOpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run > 0) {
+            out.push_back(kQoiOpRun | (run - 1));
+            run = 0;
+        }
+
+        int hash = qoiHash(px);
+        if (index[hash] == px) {
+            out.push_back(kQoiOpIndex | hash);
+        } else {
+            index[hash] = px;
+            if (px.a == prev.a) {
+                signed char vr = static_cast<signed char>(px.r - prev.r);
+                signed char vg = static_cast<signed char>(px.g - prev.g);
+                signed char vb = static_cast<signed char>(px.b - prev.b);
+                signed char vgr = static_cast<signed char>(vr - vg);
+                signed char vgb = static_cast<signed char>(vb - vg);
+
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 &&
+                    vb < 2) {
+                    out.push_back(kQoiOpDiff | (vr + 2) << 4 | (vg + 2) << 2 |
+                                  (vb + 2));
+                } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 &&
+                           vgb > -9 && vgb < 8) {
+                    out.push_back(kQoiOpLuma | (vg + 32));
+                    out.push_back((vgr + 8) << 4 | (vgb + 8));
+                } else {
+                    out.push_back(kQoiOpRgb);
+                    out.push_back(px.r);
+                    out.push_back(px.g);
+                    out.push_back(px.b);
+                }
+            } else {
+                out.push_back(kQoiOpRgba);
+                out.push_back(px.r);
+                out.push_back(px.g);
+                out.push_back(px.b);
+                out.push_back(px.a);
+            }
+        }
+        prev = px;
+    }
+
+    out.insert(out.end(), kQoiPaddingSize - 1, 0);
+    out.push_back(1);
+    return true;
+}
+
+bool decodeQoi(const unsigned char* data, size_t size,
+               std::vector<unsigned char>& pixels, int* width, int* height) {
+    if (size < kQoiHeaderSize + kQoiPaddingSize) return false;
+
+    uint32_t w = getBE32(data + 4);
+    uint32_t h = getBE32(data + 8);
+    if (w == 0 || h == 0 || w > 0x7FFFFFFF / h) return false;
+
+    const size_t count = static_cast<size_t>(w) * h;
+    pixels.resize(count * 4);
+
+    Rgba index[64] = {};
+    Rgba px{0, 0, 0, 255};
+    int run = 0;
+    size_t pos = kQoiHeaderSize;
+    const size_t chunksEnd = size - kQoiPaddingSize;
+    unsigned char* dst = pixels.data();
+
+    for (size_t i = 0; i < count; ++i, dst += 4) {
+        if (run > 0) {
+            --run;
+        } else if (pos < chunksEnd) {
+            unsigned char b1 = data[pos++];
+            if (b1 == kQoiOpRgb) {
+                if (pos + 3 > chunksEnd) return false;
+                px.r = data[pos];
+                px.g = data[pos + 1];
+                px.b = data[pos + 2];
+                pos += 3;
+            } else if (b1 == kQoiOpRgba) {
+                if (pos + 4 > chunksEnd) return false;
+                px.r = data[pos];
+                px.g = data[pos + 1];
+                px.b = data[pos + 2];
+                px.a = data[pos + 3];
+                pos += 4;
+            } else if ((b1 & kQoiMask) == kQoiOpIndex) {
+                px = index[b1];
+            } else if ((b1 & kQoiMask) == kQoiOpDiff) {
+                px.r += ((b1 >> 4) & 0x03) - 2;
+                px.g += ((b1 >> 2) & 0x03) - 2;
+                px.b += (b1 & 0x03) - 2;
+            } else if ((b1 & kQoiMask) == kQoiOpLuma) {
+                if (pos >= chunksEnd) return false;
+                unsigned char b2 = data[pos++];
+                int vg = (b1 & 0x3F) - 32;
+                px.r += vg - 8 + ((b2 >> 4) & 0x0F);
+                px.g += vg;
+                px.b += vg - 8 + (b2 & 0x0F);
+            } else {
+                run = b1 & 0x3F;
+            }
+            index[qoiHash(px)] = px;
+        } else {
+            return false;
+        }
+        dst[0] = px.r;
+        dst[1] = px.g;
+        dst[2] = px.b;
+        dst[3] = px.a;
+    }
+
+    *width = static_cast<int>(w);
+    *height = static_cast<int>(h);
+    return true;
+}
+
+// 收集图像中的颜色（按首次出现的顺序），超过 limit 种时返回 false
+bool collectColors(const unsigned char* pixels, size_t count, size_t limit,
+                   std::vector<uint32_t>& colors) {
+    colors.clear();
+    uint32_t last = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t color;
+        std::memcpy(&color, pixels + i * 4, 4);
+        // 相邻像素通常同色，先和上一个比较
+        if (i > 0 && color == last) continue;
+        last = color;
+        if (std::find(colors.begin(), colors.end(), color) == colors.end()) {
+            if (colors.size() == limit) return false;
+            colors.push_back(color);
+        }
+    }
+    return true;
+}
+
+int bitsForColors(size_t colors) {
+    return colors <= 2 ? 1 : colors <= 4 ? 2 : 4;
+}
+
+void putLE16(unsigned char* p, uint16_t v) {
+    p[0] = static_cast<unsigned char>(v);
+    p[1] = static_cast<unsigned char>(v >> 8);
+}
+
+uint16_t getLE16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint16_t packRgb565(const float* rgb) {
+    auto quantize = [](float v, int max) {
+        int q = static_cast<int>(v * max / 255.0f + 0.5f);
+        return std::min(std::max(q, 0), max);
+    };
+    return static_cast<uint16_t>((quantize(rgb[0], 31) << 11) |
+                                 (quantize(rgb[1], 63) << 5) |
+                                 quantize(rgb[2], 31));
+}
+
+void unpackRgb565(uint16_t c, int* rgb) {
+    int r = c >> 11;
+    int g = (c >> 5) & 0x3F;
+    int b = c & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// 颜色块的 4 个颜色；c0 <= c1 且不是 BC3 时为 3 色 + 透明黑
+void colorPalette(uint16_t c0, uint16_t c1, bool bc3, int palette[4][4]) {
+    unpackRgb565(c0, palette[0]);
+    unpackRgb565(c1, palette[1]);
+    const bool fourColors = bc3 || c0 > c1;
+    for (int i = 0; i < 3; ++i) {
+        const int a = palette[0][i];
+        const int b = palette[1][i];
+        palette[2][i] = fourColors ? (2 * a + b) / 3 : (a + b) / 2;
+        palette[3][i] = fourColors ? (a + 2 * b) / 3 : 0;
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+}
+
+// alpha 块的 8 个值
+void alphaPalette(int a0, int a1, int values[8]) {
+    values[0] = a0;
+    values[1] = a1;
+    if (a0 > a1) {
+        for (int k = 2; k < 8; ++k) {
+            values[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+        }
+    } else {
+        for (int k = 2; k < 6; ++k) {
+            values[k] = ((6 - k) * a0 + (k - 1) * a1) / 5;
+        }
+        values[6] = 0;
+        values[7] = 255;
+    }
+}
+
+/**
+ * 以端点 (c0, c1) 编码 8 字节颜色块，返回 used 像素的平方误差。
+ * punchThrough 时（BC1 含透明像素）使用 3 色模式，未使用的像素取透明索引；
+ * 否则尽量使用 4 色模式。indices 可选输出每个像素的索引。
+ */
+int encodeColorEndpoints(const BlockPixels& px, const bool* used, bool bc3,
+                         bool punchThrough, uint16_t c0, uint16_t c1,
+                         unsigned char* out, int* indices) {
+    if (punchThrough ? c0 > c1 : c0 < c1) std::swap(c0, c1);
+    int palette[4][4];
+    colorPalette(c0, c1, bc3, palette);
+    const int colors = punchThrough || (!bc3 && c0 == c1) ? 3 : 4;
+
+    int error = 0;
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = punchThrough ? 3 : 0;
+        if (used[i]) {
+            int bestError = INT32_MAX;
+            for (int k = 0; k < colors; ++k) {
+                int dr = px[i][0] - palette[k][0];
+                int dg = px[i][1] - palette[k][1];
+                int db = px[i][2] - palette[k][2];
+                int e = dr * dr + dg * dg + db * db;
+                if (e < bestError) {
+                    bestError = e;
+                    best = k;
+                }
+            }
+            error += bestError;
+        }
+        bits |= static_cast<uint32_t>(best) << (2 * i);
+        if (indices) indices[i] = best;
+    }
+    putLE16(out, c0);
+    putLE16(out + 2, c1);
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    return error;
+}
+
+/**
+ * 编码 8 字节颜色块。端点取 used 像素主成分方向上投影最远的两个像素，
+ * 再按第一次的索引用最小二乘求端点，误差更小时采用。
+ */
+void encodeColorBlock(const BlockPixels& px, const bool* used, bool bc3,
+                      bool punchThrough, unsigned char* out) {
+    float mean[3] = {0, 0, 0};
+    int count = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (!used[i]) continue;
+        for (int c = 0; c < 3; ++c) mean[c] += px[i][c];
+        ++count;
+    }
+    if (count == 0) {
+        encodeColorEndpoints(px, used, bc3, punchThrough, 0, 0, out, nullptr);
+        return;
+    }
+    for (float& m : mean) m /= count;
+
+    // 协方差矩阵 xx, xy, xz, yy, yz, zz
+    float cov[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        if (!used[i]) continue;
+        float d[3] = {px[i][0] - mean[0], px[i][1] - mean[1],
+                      px[i][2] - mean[2]};
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+
+    // 幂迭代求主轴，从方差最大的通道对应的行开始
+    float axis[3];
+    if (cov[0] >= cov[3] && cov[0] >= cov[5]) {
+        axis[0] = cov[0], axis[1] = cov[1], axis[2] = cov[2];
+    } else if (cov[3] >= cov[5]) {
+        axis[0] = cov[1], axis[1] = cov[3], axis[2] = cov[4];
+    } else {
+        axis[0] = cov[2], axis[1] = cov[4], axis[2] = cov[5];
+    }
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[3] = {
+            cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+        float norm = std::max(std::fabs(next[0]),
+                              std::max(std::fabs(next[1]), std::fabs(next[2])));
+        if (norm < 1e-6f) break;
+        for (int c = 0; c < 3; ++c) axis[c] = next[c] / norm;
+    }
+
+    float end0[3] = {mean[0], mean[1], mean[2]};
+    float end1[3] = {mean[0], mean[1], mean[2]};
+    float minT = 0.0f;
+    float maxT = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        if (!used[i]) continue;
+        float t = (px[i][0] - mean[0]) * axis[0] +
+                  (px[i][1] - mean[1]) * axis[1] +
+                  (px[i][2] - mean[2]) * axis[2];
+        if (t < minT) {
+            minT = t;
+            for (int c = 0; c < 3; ++c) end1[c] = px[i][c];
+        }
+        if (t > maxT) {
+            maxT = t;
+            for (int c = 0; c < 3; ++c) end0[c] = px[i][c];
+        }
+    }
+
+    int indices[16];
+    int error =
+        encodeColorEndpoints(px, used, bc3, punchThrough, packRgb565(end0),
+                             packRgb565(end1), out, indices);
+    if (error == 0) return;
+
+    // 索引对应的 c0 权重（c0 与 c1 可能在编码时交换，按输出的端点顺序）
+    const bool fourColors = bc3 || getLE16(out) > getLE16(out + 2);
+    const float weights[4] = {1.0f, 0.0f, fourColors ? 2.0f / 3 : 0.5f,
+                              1.0f / 3};
+    float aa = 0, ab = 0, bb = 0;
+    float ax[3] = {0, 0, 0};
+    float bx[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        if (!used[i]) continue;
+        float a = weights[indices[i]];
+        float b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; ++c) {
+            ax[c] += a * px[i][c];
+            bx[c] += b * px[i][c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) return;
+    for (int c = 0; c < 3; ++c) {
+        end0[c] = (ax[c] * bb - bx[c] * ab) / det;
+        end1[c] = (bx[c] * aa - ax[c] * ab) / det;
+    }
+    unsigned char refined[8];
+    if (encodeColorEndpoints(px, used, bc3, punchThrough, packRgb565(end0),
+                             packRgb565(end1), refined, nullptr) < error) {
+        std::memcpy(out, refined, sizeof(refined));
+    }
+}
+
+// 编码 8 字节 alpha 块（BC3），端点取块内 alpha 的最大和最小值
+void encodeAlphaBlock(const BlockPixels& px, unsigned char* out) {
+    int minA = 255;
+    int maxA = 0;
+    for (int i = 0; i < 16; ++i) {
+        minA = std::min(minA, static_cast<int>(px[i][3]));
+        maxA = std::max(maxA, static_cast<int>(px[i][3]));
+    }
+    int values[8];
+    alphaPalette(maxA, minA, values);
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 16 && maxA > minA; ++i) {
+        int best = 0;
+        int bestError = 256;
+        for (int k = 0; k < 8; ++k) {
+            int e = std::abs(px[i][3] - values[k]);
+            if (e < bestError) {
+                bestError = e;
+                best = k;
+            }
+        }
+        bits |= static_cast<uint64_t>(best) << (3 * i);
+    }
+    out[0] = static_cast<unsigned char>(maxA);
+    out[1] = static_cast<unsigned char>(minA);
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+}
+
+// 解码一个压缩块为 16 个 RGBA 像素
+void decodeBlock(const unsigned char* block, bool bc3, BlockPixels& px) {
+    const unsigned char* color = bc3 ? block + 8 : block;
+    int palette[4][4];
+    colorPalette(getLE16(color), getLE16(color + 2), bc3, palette);
+    uint32_t bits = color[4] | (color[5] << 8) | (color[6] << 16) |
+                    (static_cast<uint32_t>(color[7]) << 24);
+    for (int i = 0; i < 16; ++i) {
+        const int* c = palette[(bits >> (2 * i)) & 3];
+        for (int k = 0; k < 4; ++k) {
+            px[i][k] = static_cast<unsigned char>(c[k]);
+        }
+    }
+    if (!bc3) return;
+
+    int values[8];
+    alphaPalette(block[0], block[1], values);
+    uint64_t alphaBits = 0;
+    for (int i = 0; i < 6; ++i) {
+        alphaBits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        px[i][3] =
+            static_cast<unsigned char>(values[(alphaBits >> (3 * i)) & 7]);
+    }
+}
+
+}  // namespace
+
+void PaletteImage::expand(std::vector<unsigned char>& pixels) const {
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    unsigned char* dst = pixels.data();
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x, dst += 4) {
+            std::memcpy(dst, color(x, y), 4);
+        }
+    }
+}
+
+void BlockImage::decodeRegion(int x, int y, int w, int h,
+                              unsigned char* out) const {
+    const bool bc3 = format == Format::Bc3;
+    const int perRow = blocksPerRow();
+    BlockPixels px;
+    for (int by = y / 4; by <= (y + h - 1) / 4; ++by) {
+        for (int bx = x / 4; bx <= (x + w - 1) / 4; ++bx) {
+            decodeBlock(&blocks[(static_cast<size_t>(by) * perRow + bx) *
+                                blockBytes()],
+                        bc3, px);
+            // 块与区域相交的部分
+            const int x0 = std::max(x, bx * 4);
+            const int x1 = std::min(x + w, bx * 4 + 4);
+            const int y0 = std::max(y, by * 4);
+            const int y1 = std::min(y + h, by * 4 + 4);
+            for (int py = y0; py < y1; ++py) {
+                std::memcpy(out + (static_cast<size_t>(py - y) * w +
+                                   (x0 - x)) * 4,
+                            px[(py - by * 4) * 4 + (x0 - bx * 4)],
+                            static_cast<size_t>(x1 - x0) * 4);
+            }
+        }
+    }
+}
+
+void BlockImage::expand(std::vector<unsigned char>& pixels) const {
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    decodeRegion(0, 0, width, height, pixels.data());
+}
+
+void ChannelImage::expandRow(int x, int y, int count,
+                             unsigned char* out) const {
+    const unsigned char* src =
+        pixels.data() + (static_cast<size_t>(y) * width + x) * channels();
+    switch (layout) {
+        case Layout::Rgb:
+            for (int i = 0; i < count; ++i, src += 3, out += 4) {
+                out[0] = src[0];
+                out[1] = src[1];
+                out[2] = src[2];
+                out[3] = 255;
+            }
+            break;
+        case Layout::Gray:
+            for (int i = 0; i < count; ++i, out += 4) {
+                out[0] = out[1] = out[2] = src[i];
+                out[3] = 255;
+            }
+            break;
+        case Layout::Alpha:
+            for (int i = 0; i < count; ++i, out += 4) {
+                out[0] = color[0];
+                out[1] = color[1];
+                out[2] = color[2];
+                out[3] = src[i];
+            }
+            break;
+    }
+}
+
+void ChannelImage::expand(std::vector<unsigned char>& pixels) const {
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        expandRow(0, y, width, &pixels[static_cast<size_t>(y) * width * 4]);
+    }
+}
+
+void RleImage::expand(std::vector<unsigned char>& pixels) const {
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    unsigned char* dst = pixels.data();
+    for (const Run& run : runs) {
+        for (int i = 0; i < run.length; ++i, dst += 4) {
+            std::memcpy(dst, run.color, 4);
+        }
+    }
+}
+
+const char* TileCodec::name(Type type) {
+    switch (type) {
+        case Type::Qoi:
+            return "qoi";
+        case Type::Bc1:
+            return "bc1";
+        case Type::Bc3:
+            return "bc3";
+        case Type::Png:
+            break;
+    }
+    return "png";
+}
+
+bool TileCodec::fromName(const std::string& name, Type& type) {
+    for (Type candidate : {Type::Png, Type::Qoi, Type::Bc1, Type::Bc3}) {
+        if (name == TileCodec::name(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* TileCodec::extension(Type type) {
+    switch (type) {
+        case Type::Qoi:
+            return ".qoi";
+        case Type::Bc1:
+            return ".bc1";
+        case Type::Bc3:
+            return ".bc3";
+        case Type::Png:
+            break;
+    }
+    return ".png";
+}
+
+bool TileCodec::encode(Type type, const unsigned char* pixels, int width,
+                       int height, std::vector<unsigned char>& out) {
+    if (width <= 0 || height <= 0) return false;
+    if (type == Type::Qoi) {
+        return encodeQoi(pixels, width, height, out);
+    }
+    if (type == Type::Bc1 || type == Type::Bc3) {
+        return encodeBlocks(type == Type::Bc1 ? BlockImage::Format::Bc1
+                                              : BlockImage::Format::Bc3,
+                            pixels, width, height, out);
+    }
+    return stbi_write_png_to_func(appendToVector, &out, width, height, 4,
+                                  pixels, width * 4) != 0;
+}
+
+bool TileCodec::decode(const unsigned char* data, size_t size,
+                       std::vector<unsigned char>& pixels, int* width,
+                       int* height) {
+    if (isPalette(data, size)) {
+        PaletteImage image;
+        if (!decodePalette(data, size, image)) return false;
+        image.expand(pixels);
+        *width = image.width;
+        *height = image.height;
+        return true;
+    }
+    if (isBlockCompressed(data, size)) {
+        BlockImage image;
+        if (!decodeBlocks(data, size, image)) return false;
+        image.expand(pixels);
+        *width = image.width;
+        *height = image.height;
+        return true;
+    }
+    if (isChannelReduced(data, size)) {
+        ChannelImage image;
+        if (!decodeChannels(data, size, image)) return false;
+        image.expand(pixels);
+        *width = image.width;
+        *height = image.height;
+        return true;
+    }
+    if (isRle(data, size)) {
+        RleImage image;
+        if (!decodeRle(data, size, image)) return false;
+        image.expand(pixels);
+        *width = image.width;
+        *height = image.height;
+        return true;
+    }
+    if (size >= sizeof(kQoiMagic) &&
+        std::memcmp(data, kQoiMagic, sizeof(kQoiMagic)) == 0) {
+        return decodeQoi(data, size, pixels, width, height);
+    }
+
+    // 其余数据交给 stb_image 识别（PNG 等）
+    int channels;
+    unsigned char* decoded = stbi_load_from_memory(
+        data, static_cast<int>(size), width, height, &channels, 4);
+    if (!decoded) return false;
+    pixels.assign(decoded,
+                  decoded + static_cast<size_t>(*width) * *height * 4);
+    stbi_image_free(decoded);
+    return true;
+}
+
+bool TileCodec::fitsPalette(const unsigned char* pixels, int width,
+                            int height) {
+    std::vector<uint32_t> colors;
+    return collectColors(pixels, static_cast<size_t>(width) * height,
+                         kMaxPaletteColors, colors);
+}
+
+bool TileCodec::encodePalette(const unsigned char* pixels, int width,
+                              int height, std::vector<unsigned char>& out) {
+    if (width <= 0 || height <= 0) return false;
+    std::vector<uint32_t> colors;
+    if (!collectColors(pixels, static_cast<size_t>(width) * height,
+                       kMaxPaletteColors, colors)) {
+        return false;
+    }
+
+    const int bits = bitsForColors(colors.size());
+    const size_t stride = (static_cast<size_t>(width) * bits + 7) / 8;
+    out.reserve(out.size() + kPaletteHeaderSize + colors.size() * 4 +
+                stride * height);
+    out.insert(out.end(), kPaletteMagic, kPaletteMagic + 4);
+    putBE32(out, static_cast<uint32_t>(width));
+    putBE32(out, static_cast<uint32_t>(height));
+    out.push_back(static_cast<unsigned char>(colors.size()));
+    for (uint32_t color : colors) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&color);
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    size_t rowStart = out.size();
+    out.resize(rowStart + stride * height, 0);
+    for (int y = 0; y < height; ++y, rowStart += stride) {
+        const unsigned char* row = pixels + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; ++x) {
+            uint32_t color;
+            std::memcpy(&color, row + x * 4, 4);
+            int index = static_cast<int>(
+                std::find(colors.begin(), colors.end(), color) -
+                colors.begin());
+            int bitOffset = x * bits;
+            out[rowStart + (bitOffset >> 3)] |= static_cast<unsigned char>(
+                index << (8 - bits - (bitOffset & 7)));
+        }
+    }
+    return true;
+}
+
+bool TileCodec::isPalette(const unsigned char* data, size_t size) {
+    return size >= sizeof(kPaletteMagic) &&
+           std::memcmp(data, kPaletteMagic, sizeof(kPaletteMagic)) == 0;
+}
+
+bool TileCodec::decodePalette(const unsigned char* data, size_t size,
+                              PaletteImage& image) {
+    if (size < kPaletteHeaderSize || !isPalette(data, size)) return false;
+    uint32_t w = getBE32(data + 4);
+    uint32_t h = getBE32(data + 8);
+    size_t colors = data[12];
+    if (w == 0 || h == 0 || w > 0x7FFFFFFF / h || colors == 0 ||
+        colors > static_cast<size_t>(kMaxPaletteColors)) {
+        return false;
+    }
+
+    image.width = static_cast<int>(w);
+    image.height = static_cast<int>(h);
+    image.bitsPerIndex = bitsForColors(colors);
+    image.stride = (static_cast<size_t>(w) * image.bitsPerIndex + 7) / 8;
+    const size_t paletteBytes = colors * 4;
+    const size_t indexBytes = image.stride * h;
+    if (size < kPaletteHeaderSize + paletteBytes + indexBytes) return false;
+
+    const unsigned char* p = data + kPaletteHeaderSize;
+    // 索引可能超出颜色数（损坏的数据），调色板补足到索引位数能表示的范围
+    image.palette.assign(static_cast<size_t>(4) << image.bitsPerIndex, 0);
+    std::memcpy(image.palette.data(), p, paletteBytes);
+    image.indices.assign(p + paletteBytes, p + paletteBytes + indexBytes);
+    return true;
+}
+
+bool TileCodec::encodeBlocks(BlockImage::Format format,
+                             const unsigned char* pixels, int width,
+                             int height, std::vector<unsigned char>& out) {
+    if (width <= 0 || height <= 0) return false;
+    const bool bc3 = format == BlockImage::Format::Bc3;
+    const size_t blockBytes = bc3 ? 16 : 8;
+    const int blocksWide = (width + 3) / 4;
+    const int blocksHigh = (height + 3) / 4;
+    out.reserve(out.size() + kBlockHeaderSize +
+                static_cast<size_t>(blocksWide) * blocksHigh * blockBytes);
+    out.insert(out.end(), kBlockMagic, kBlockMagic + 4);
+    putBE32(out, static_cast<uint32_t>(width));
+    putBE32(out, static_cast<uint32_t>(height));
+    out.push_back(bc3 ? 3 : 1);
+
+    BlockPixels px;
+    bool used[16];
+    for (int by = 0; by < blocksHigh; ++by) {
+        for (int bx = 0; bx < blocksWide; ++bx) {
+            // 超出图像的块内像素重复边缘像素，不影响端点选择
+            bool punchThrough = false;
+            for (int i = 0; i < 16; ++i) {
+                int x = std::min(bx * 4 + (i & 3), width - 1);
+                int y = std::min(by * 4 + (i >> 2), height - 1);
+                std::memcpy(px[i],
+                            pixels + (static_cast<size_t>(y) * width + x) * 4,
+                            4);
+                // BC1 中 alpha < 128 的像素为透明；BC3 中全透明像素的颜色
+                // 不可见，不参与端点选择
+                used[i] = bc3 ? px[i][3] > 0 : px[i][3] >= 128;
+                punchThrough |= !bc3 && !used[i];
+            }
+            size_t offset = out.size();
+            out.resize(offset + blockBytes);
+            if (bc3) encodeAlphaBlock(px, &out[offset]);
+            encodeColorBlock(px, used, bc3, punchThrough,
+                             &out[offset + (bc3 ? 8 : 0)]);
+        }
+    }
+    return true;
+}
+
+bool TileCodec::isBlockCompressed(const unsigned char* data, size_t size) {
+    return size >= sizeof(kBlockMagic) &&
+           std::memcmp(data, kBlockMagic, sizeof(kBlockMagic)) == 0;
+}
+
+bool TileCodec::decodeBlocks(const unsigned char* data, size_t size,
+                             BlockImage& image) {
+    if (size < kBlockHeaderSize || !isBlockCompressed(data, size)) {
+        return false;
+    }
+    uint32_t w = getBE32(data + 4);
+    uint32_t h = getBE32(data + 8);
+    unsigned char format = data[12];
+    if (w == 0 || h == 0 || w > 0x7FFFFFFF / h ||
+        (format != 1 && format != 3)) {
+        return false;
+    }
+
+    image.width = static_cast<int>(w);
+    image.height = static_cast<int>(h);
+    image.format =
+        format == 3 ? BlockImage::Format::Bc3 : BlockImage::Format::Bc1;
+    const size_t blockBytes = static_cast<size_t>(image.blocksPerRow()) *
+                              ((h + 3) / 4) * image.blockBytes();
+    if (size < kBlockHeaderSize + blockBytes) return false;
+    image.blocks.assign(data + kBlockHeaderSize,
+                        data + kBlockHeaderSize + blockBytes);
+    return true;
+}
+
+bool TileCodec::reducibleChannels(const unsigned char* pixels, int width,
+                                  int height, ChannelImage::Layout& layout,
+                                  unsigned char color[3]) {
+    const size_t count = static_cast<size_t>(width) * height;
+    if (count == 0) return false;
+    // 三种布局同时判断，全部排除后提前返回
+    bool opaque = true;
+    bool gray = true;
+    bool mask = true;
+    for (size_t i = 0; i < count && (opaque || mask); ++i) {
+        const unsigned char* p = pixels + i * 4;
+        opaque = opaque && p[3] == 255;
+        gray = gray && p[0] == p[1] && p[1] == p[2];
+        mask = mask && std::memcmp(p, pixels, 3) == 0;
+    }
+    if (opaque) {
+        layout = gray ? ChannelImage::Layout::Gray : ChannelImage::Layout::Rgb;
+    } else if (mask) {
+        layout = ChannelImage::Layout::Alpha;
+    } else {
+        return false;
+    }
+    std::memcpy(color, pixels, 3);
+    return true;
+}
+
+bool TileCodec::encodeChannels(const unsigned char* pixels, int width,
+                               int height, std::vector<unsigned char>& out) {
+    ChannelImage::Layout layout;
+    unsigned char color[3];
+    if (width <= 0 || height <= 0 ||
+        !reducibleChannels(pixels, width, height, layout, color)) {
+        return false;
+    }
+
+    const size_t count = static_cast<size_t>(width) * height;
+    const int channels = layout == ChannelImage::Layout::Rgb ? 3 : 1;
+    std::vector<unsigned char> plane(count * channels);
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* p = pixels + i * 4;
+        switch (layout) {
+            case ChannelImage::Layout::Rgb:
+                std::memcpy(&plane[i * 3], p, 3);
+                break;
+            case ChannelImage::Layout::Gray:
+                plane[i] = p[0];
+                break;
+            case ChannelImage::Layout::Alpha:
+                plane[i] = p[3];
+                break;
+        }
+    }
+
+    const size_t start = out.size();
+    out.insert(out.end(), kChannelMagic, kChannelMagic + 4);
+    putBE32(out, static_cast<uint32_t>(width));
+    putBE32(out, static_cast<uint32_t>(height));
+    out.push_back(static_cast<unsigned char>(layout));
+    out.insert(out.end(), color, color + 3);
+    if (!stbi_write_png_to_func(appendToVector, &out, width, height,
+                                channels, plane.data(), width * channels)) {
+        out.resize(start);
+        return false;
+    }
+    return true;
+}
+
+bool TileCodec::isChannelReduced(const unsigned char* data, size_t size) {
+    return size >= sizeof(kChannelMagic) &&
+           std::memcmp(data, kChannelMagic, sizeof(kChannelMagic)) == 0;
+}
+
+bool TileCodec::decodeChannels(const unsigned char* data, size_t size,
+                               ChannelImage& image) {
+    if (size < kChannelHeaderSize || !isChannelReduced(data, size)) {
+        return false;
+    }
+    uint32_t w = getBE32(data + 4);
+    uint32_t h = getBE32(data + 8);
+    unsigned char layout = data[12];
+    if (w == 0 || h == 0 || w > 0x7FFFFFFF / h ||
+        layout > static_cast<unsigned char>(ChannelImage::Layout::Alpha)) {
+        return false;
+    }
+
+    image.width = static_cast<int>(w);
+    image.height = static_cast<int>(h);
+    image.layout = static_cast<ChannelImage::Layout>(layout);
+    std::memcpy(image.color, data + 13, 3);
+
+    // 按保存的通道数解码，PNG 的尺寸必须与头部一致
+    int pngWidth, pngHeight, pngChannels;
+    unsigned char* decoded = stbi_load_from_memory(
+        data + kChannelHeaderSize,
+        static_cast<int>(size - kChannelHeaderSize), &pngWidth, &pngHeight,
+        &pngChannels, image.channels());
+    if (!decoded) return false;
+    const bool ok = pngWidth == image.width && pngHeight == image.height;
+    if (ok) {
+        image.pixels.assign(
+            decoded, decoded + static_cast<size_t>(w) * h * image.channels());
+    }
+    stbi_image_free(decoded);
+    return ok;
+}
+
+bool TileCodec::fitsRle(const unsigned char* pixels, int width,
+                        int height) {
+    return width > 0 && height > 0 && countRuns(pixels, width, height) > 0;
+}
+
+bool TileCodec::encodeRle(const unsigned char* pixels, int width, int height,
+                          std::vector<unsigned char>& out) {
+    if (width <= 0 || height <= 0) return false;
+    const size_t runs = countRuns(pixels, width, height);
+    if (runs == 0) return false;
+
+    out.reserve(out.size() + kRleHeaderSize + runs * kRleRunSize);
+    out.insert(out.end(), kRleMagic, kRleMagic + 4);
+    putBE32(out, static_cast<uint32_t>(width));
+    putBE32(out, static_cast<uint32_t>(height));
+    putBE32(out, static_cast<uint32_t>(runs));
+    auto putRun = [&out](const unsigned char* color, int length) {
+        out.insert(out.end(), color, color + 4);
+        out.push_back(static_cast<unsigned char>(length >> 8));
+        out.push_back(static_cast<unsigned char>(length));
+    };
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* row = pixels + static_cast<size_t>(y) * width * 4;
+        int start = 0;
+        for (int x = 1; x <= width; ++x) {
+            if (x == width || x - start == kMaxRunLength ||
+                std::memcmp(row + x * 4, row + start * 4, 4) != 0) {
+                putRun(row + start * 4, x - start);
+                start = x;
+            }
+        }
+    }
+    return true;
+}
+
+bool TileCodec::isRle(const unsigned char* data, size_t size) {
+    return size >= sizeof(kRleMagic) &&
+           std::memcmp(data, kRleMagic, sizeof(kRleMagic)) == 0;
+}
+
+bool TileCodec::decodeRle(const unsigned char* data, size_t size,
+                          RleImage& image) {
+    if (size < kRleHeaderSize || !isRle(data, size)) return false;
+    uint32_t w = getBE32(data + 4);
+    uint32_t h = getBE32(data + 8);
+    uint32_t runs = getBE32(data + 12);
+    if (w == 0 || h == 0 || w > 0x7FFFFFFF / h ||
+        (size - kRleHeaderSize) / kRleRunSize < runs) {
+        return false;
+    }
+
+    image.width = static_cast<int>(w);
+    image.height = static_cast<int>(h);
+    image.runs.resize(runs);
+    image.rowStart.assign(1, 0);
+    image.rowStart.reserve(h + 1);
+    const unsigned char* p = data + kRleHeaderSize;
+    uint32_t filled = 0;
+    for (uint32_t i = 0; i < runs; ++i, p += kRleRunSize) {
+        RleImage::Run& run = image.runs[i];
+        std::memcpy(run.color, p, 4);
+        run.length = static_cast<uint16_t>(p[4] << 8 | p[5]);
+        // 段不能跨行
+        filled += run.length;
+        if (run.length == 0 || filled > w) return false;
+        if (filled == w) {
+            image.rowStart.push_back(i + 1);
+            filled = 0;
+        }
+    }
+    return filled == 0 && image.rowStart.size() == h + 1;
+}
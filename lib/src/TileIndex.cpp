@@ -7,6 +7,24 @@ using namespace std;
 
 bool TileIndex::load(const string& metaFile) {
     tiles_.clear();
+    lodTiles_.clear();
+    binary_.reset();
+    codec_ = TileCodec::Type::Png;
+    declaredWidth_ = 0;
+    declaredHeight_ = 0;
+    if (BinaryMeta::isBinaryMeta(metaFile)) {
+        auto binary = make_shared<BinaryMeta>();
+        if (!binary->open(metaFile)) return false;
+        const BinaryMeta::Info& info = binary->getInfo();
+        codec_ = info.codec;
+        declaredWidth_ = info.declaredWidth;
+        declaredHeight_ = info.declaredHeight;
+        // The extent is precomputed, so nothing has to be scanned
+        mapWidth_ = info.mapWidth;
+        mapHeight_ = info.mapHeight;
+        binary_ = std::move(binary);
+        return true;
+    }
     ifstream fin(metaFile);
     if (!fin) return false;
     string header;
@@ -14,17 +32,18 @@ bool TileIndex::load(const string& metaFile) {
     string line;
     while (getline(fin, line)) {
         if (line.empty()) continue;
+        if (line[0] == '#') {
+            parseDirective(line);
+            continue;
+        }
         stringstream ss(line);
         TileMeta m;
-        ss >> m.x >> m.y >> m.w >> m.h >> m.file;
-        if (ss) tiles_.push_back(m);
-    }
-    mapWidth_ = 0;
-    mapHeight_ = 0;
-    for (auto& m : tiles_) {
-        mapWidth_ = max(mapWidth_, m.x + m.w);
-        mapHeight_ = max(mapHeight_, m.y + m.h);
+        if (!(ss >> m.x >> m.y >> m.w >> m.h >> m.file)) continue;
+        string token;
+        while (ss >> token) parseAttribute(m, token);
+        addTile(std::move(m));
     }
+    updateMapSize();
     return true;
 }
 
@@ -32,24 +51,200 @@ bool TileIndex::save(const string& metaFile) const {
     ofstream fout(metaFile);
     if (!fout) return false;
     fout << "x y w h file" << '\n';
-    for (auto& m : tiles_) {
-        fout << m.x << ' ' << m.y << ' ' << m.w << ' ' << m.h << ' ' << m.file
-             << '\n';
+    // PNG is the default, so PNG tile sets keep the original format
+    if (codec_ != TileCodec::Type::Png) {
+        fout << "# codec " << TileCodec::name(codec_) << '\n';
+    }
+    // Only needed when trimmed tiles stop short of the map edges
+    int tilesWidth = 0;
+    int tilesHeight = 0;
+    forEachTile([&](const TileMeta& m) {
+        if (m.lod != 0) return;
+        tilesWidth = max(tilesWidth, m.x + m.w);
+        tilesHeight = max(tilesHeight, m.y + m.h);
+    });
+    if (mapWidth_ != tilesWidth || mapHeight_ != tilesHeight) {
+        fout << "# size " << mapWidth_ << ' ' << mapHeight_ << '\n';
     }
+    auto write = [&](const TileMeta& m) {
+        fout << m.x << ' ' << m.y << ' ' << m.w << ' ' << m.h << ' ' << m.file;
+        if (m.srcX != 0 || m.srcY != 0) {
+            fout << " sx=" << m.srcX << " sy=" << m.srcY;
+        }
+        if (m.lod != 0) {
+            fout << " lod=" << m.lod;
+        }
+        if (m.err != 0) {
+            fout << " err=" << m.err;
+        }
+        fout << '\n';
+    };
+    forEachTile(write);
     return true;
 }
 
+bool TileIndex::saveBinary(const string& metaFile) const {
+    BinaryMeta::Info info;
+    info.codec = codec_;
+    info.mapWidth = mapWidth_;
+    info.mapHeight = mapHeight_;
+    info.declaredWidth = declaredWidth_;
+    info.declaredHeight = declaredHeight_;
+    vector<TileMeta> tiles;
+    forEachTile([&](const TileMeta& m) { tiles.push_back(m); });
+    return BinaryMeta::write(metaFile, info, tiles);
+}
+
+int TileIndex::getLodLevels() const {
+    if (binary_) return binary_->getInfo().lodLevels;
+    return static_cast<int>(lodTiles_.size());
+}
+
+void TileIndex::forEachTile(
+    const function<void(const TileMeta&)>& fn) const {
+    if (binary_) {
+        for (int level = 0; level <= binary_->getInfo().lodLevels; ++level) {
+            size_t count = 0;
+            const BinaryMeta::Record* records =
+                binary_->records(level, count);
+            for (size_t i = 0; i < count; ++i) {
+                fn(binary_->toTileMeta(records[i]));
+            }
+        }
+        return;
+    }
+    for (auto& m : tiles_) fn(m);
+    for (auto& level : lodTiles_) {
+        for (auto& m : level) fn(m);
+    }
+}
+
+void TileIndex::materialize() {
+    if (!binary_) return;
+    auto binary = std::move(binary_);
+    for (int level = 0; level <= binary->getInfo().lodLevels; ++level) {
+        size_t count = 0;
+        const BinaryMeta::Record* records = binary->records(level, count);
+        for (size_t i = 0; i < count; ++i) {
+            addTile(binary->toTileMeta(records[i]));
+        }
+    }
+    updateMapSize();
+}
+
+void TileIndex::parseDirective(const string& line) {
+    stringstream ss(line.substr(1));
+    string key;
+    ss >> key;
+    if (key == "codec") {
+        string name;
+        TileCodec::Type codec;
+        if (ss >> name && TileCodec::fromName(name, codec)) codec_ = codec;
+    } else if (key == "size") {
+        int width, height;
+        if (ss >> width >> height) {
+            declaredWidth_ = width;
+            declaredHeight_ = height;
+        }
+    }
+    // unknown directives are ignored
+}
+
+void TileIndex::parseAttribute(TileMeta& meta, const string& token) {
+    size_t eq = token.find('=');
+    if (eq == string::npos) return;
+    string key = token.substr(0, eq);
+    int value = 0;
+    try {
+        value = stoi(token.substr(eq + 1));
+    } catch (const exception&) {
+        return;
+    }
+    if (key == "sx") {
+        meta.srcX = value;
+    } else if (key == "sy") {
+        meta.srcY = value;
+    } else if (key == "lod") {
+        meta.lod = value;
+    } else if (key == "err") {
+        meta.err = value;
+    }
+    // unknown attributes are ignored
+}
+
 void TileIndex::setTiles(vector<TileMeta> tiles) {
-    tiles_ = std::move(tiles);
-    mapWidth_ = 0;
-    mapHeight_ = 0;
+    tiles_.clear();
+    lodTiles_.clear();
+    binary_.reset();
+    for (auto& m : tiles) addTile(std::move(m));
+    updateMapSize();
+}
+
+void TileIndex::addTile(TileMeta meta) {
+    if (meta.lod <= 0) {
+        tiles_.push_back(std::move(meta));
+        return;
+    }
+    if (lodTiles_.size() < static_cast<size_t>(meta.lod)) {
+        lodTiles_.resize(meta.lod);
+    }
+    lodTiles_[meta.lod - 1].push_back(std::move(meta));
+}
+
+void TileIndex::setMapSize(int width, int height) {
+    declaredWidth_ = width;
+    declaredHeight_ = height;
+    updateMapSize();
+}
+
+void TileIndex::updateMapSize() {
+    mapWidth_ = declaredWidth_;
+    mapHeight_ = declaredHeight_;
+    if (binary_) {
+        mapWidth_ = max(mapWidth_, binary_->getInfo().mapWidth);
+        mapHeight_ = max(mapHeight_, binary_->getInfo().mapHeight);
+    }
     for (auto& m : tiles_) {
         mapWidth_ = max(mapWidth_, m.x + m.w);
         mapHeight_ = max(mapHeight_, m.y + m.h);
     }
 }
 
+namespace {
+
+// Scans fixed-size records in the mapping and only builds a TileMeta (and
+// its file name string) for the tiles that overlap vp.
+vector<TileMeta> queryRecords(const BinaryMeta& binary, const Viewport& vp,
+                              int level) {
+    vector<TileMeta> out;
+    size_t count = 0;
+    const BinaryMeta::Record* records = binary.records(level, count);
+    for (size_t i = 0; i < count; ++i) {
+        const BinaryMeta::Record& m = records[i];
+        bool overlap = !(m.x + m.w <= vp.x || m.y + m.h <= vp.y ||
+                         m.x >= vp.x + vp.w || m.y >= vp.y + vp.h);
+        if (overlap) out.push_back(binary.toTileMeta(m));
+    }
+    return out;
+}
+
+}  // namespace
+
+vector<TileMeta> TileIndex::queryLod(const Viewport& vp, int level) const {
+    if (level <= 0) return query(vp);
+    vector<TileMeta> out;
+    if (level > getLodLevels()) return out;
+    if (binary_) return queryRecords(*binary_, vp, level);
+    for (auto& m : lodTiles_[level - 1]) {
+        bool overlap = !(m.x + m.w <= vp.x || m.y + m.h <= vp.y ||
+                         m.x >= vp.x + vp.w || m.y >= vp.y + vp.h);
+        if (overlap) out.push_back(m);
+    }
+    return out;
+}
+
 vector<TileMeta> TileIndex::query(const Viewport& vp) const {
+    if (binary_) return queryRecords(*binary_, vp, 0);
     vector<TileMeta> out;
     for (auto& m : tiles_) {
         bool overlap = !(m.x + m.w <= vp.x || m.y + m.h <= vp.y ||
@@ -0,0 +1,358 @@
+#include "TilePack.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+#include "TileCodec.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TILEPACK_HAVE_MMAP 1
+#endif
+
+namespace {
+
+const char kPackMagic[8] = {'M', 'F', 'T', 'P', 'A', 'C', 'K', '1'};
+constexpr size_t kPackHeaderSize = 24;
+
+// 解码瓦片数据；palette / blocks / channels / rle 非空时调色板、块压缩、
+// 通道精简和行程编码瓦片保持原有形式
+bool decodeTile(const unsigned char* data, size_t size,
+                std::vector<unsigned char>& pixels, int* width, int* height,
+                PaletteImage* palette, BlockImage* blocks,
+                ChannelImage* channels, RleImage* rle) {
+    if (palette && TileCodec::isPalette(data, size)) {
+        pixels.clear();
+        if (!TileCodec::decodePalette(data, size, *palette)) return false;
+        *width = palette->width;
+        *height = palette->height;
+        return true;
+    }
+    if (blocks && TileCodec::isBlockCompressed(data, size)) {
+        pixels.clear();
+        if (!TileCodec::decodeBlocks(data, size, *blocks)) return false;
+        *width = blocks->width;
+        *height = blocks->height;
+        return true;
+    }
+    if (channels && TileCodec::isChannelReduced(data, size)) {
+        pixels.clear();
+        if (!TileCodec::decodeChannels(data, size, *channels)) return false;
+        *width = channels->width;
+        *height = channels->height;
+        return true;
+    }
+    if (rle && TileCodec::isRle(data, size)) {
+        pixels.clear();
+        if (!TileCodec::decodeRle(data, size, *rle)) return false;
+        *width = rle->width;
+        *height = rle->height;
+        return true;
+    }
+    return TileCodec::decode(data, size, pixels, width, height);
+}
+
+void putLE(unsigned char* p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+uint64_t getLE(const unsigned char* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+bool seekFile(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+}  // namespace
+
+TilePack::~TilePack() { close(); }
+
+void TilePack::close() {
+#ifdef TILEPACK_HAVE_MMAP
+    if (mapped_) {
+        munmap(const_cast<unsigned char*>(mapped_), mappedSize_);
+    }
+#endif
+    mapped_ = nullptr;
+    mappedSize_ = 0;
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    entries_.clear();
+}
+
+bool TilePack::open(const std::string& path) {
+    close();
+
+    // 读取文件头和偏移表所需的全部字节
+    std::vector<unsigned char> header(kPackHeaderSize);
+    std::vector<unsigned char> table;
+    uint64_t fileSize = 0;
+
+#ifdef TILEPACK_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<uint64_t>(st.st_size) < kPackHeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    fileSize = static_cast<uint64_t>(st.st_size);
+    void* addr = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+    mapped_ = static_cast<const unsigned char*>(addr);
+    mappedSize_ = fileSize;
+    std::memcpy(header.data(), mapped_, kPackHeaderSize);
+#else
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) return false;
+    if (std::fread(header.data(), 1, kPackHeaderSize, file_) !=
+        kPackHeaderSize) {
+        close();
+        return false;
+    }
+    fileSize = std::filesystem::file_size(path);
+#endif
+
+    if (std::memcmp(header.data(), kPackMagic, sizeof(kPackMagic)) != 0) {
+        close();
+        return false;
+    }
+    uint64_t count = getLE(&header[8], 4);
+    uint64_t tableOffset = getLE(&header[16], 8);
+    if (tableOffset < kPackHeaderSize || tableOffset > fileSize) {
+        close();
+        return false;
+    }
+
+    const unsigned char* p;
+    const unsigned char* end;
+    if (mapped_) {
+        p = mapped_ + tableOffset;
+        end = mapped_ + fileSize;
+    } else {
+        table.resize(fileSize - tableOffset);
+        if (!seekFile(file_, tableOffset) ||
+            std::fread(table.data(), 1, table.size(), file_) != table.size()) {
+            close();
+            return false;
+        }
+        p = table.data();
+        end = p + table.size();
+    }
+
+    entries_.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (end - p < 2) break;
+        size_t nameLength = getLE(p, 2);
+        if (static_cast<size_t>(end - p) < 2 + nameLength + 16) break;
+        std::string name(reinterpret_cast<const char*>(p + 2), nameLength);
+        p += 2 + nameLength;
+        Entry entry{getLE(p, 8), getLE(p + 8, 8)};
+        p += 16;
+        if (entry.offset + entry.size > tableOffset) break;
+        entries_.emplace(std::move(name), entry);
+    }
+    if (entries_.size() != count) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TilePack::contains(const std::string& name) const {
+    return entries_.count(name) != 0;
+}
+
+bool TilePack::getPayload(const std::string& name, const unsigned char*& data,
+                          size_t& size,
+                          std::vector<unsigned char>& scratch) const {
+    auto it = entries_.find(name);
+    if (it == entries_.end()) return false;
+
+    size = static_cast<size_t>(it->second.size);
+    if (mapped_) {
+        data = mapped_ + it->second.offset;
+        return true;
+    }
+
+    scratch.resize(size);
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (!seekFile(file_, it->second.offset) ||
+        std::fread(scratch.data(), 1, size, file_) != size) {
+        return false;
+    }
+    data = scratch.data();
+    return true;
+}
+
+namespace {
+
+std::mutex sharedPacksMutex;
+std::unordered_map<std::string, std::shared_ptr<const TilePack>> sharedPacks;
+
+// forDirectory 缓存的键：同一目录的不同写法对应同一个键
+std::string sharedPackKey(const std::string& resourceDir) {
+    auto dir = std::filesystem::path(resourceDir).lexically_normal();
+    if (!dir.has_filename() && dir.has_relative_path()) {
+        dir = dir.parent_path();  // 去掉末尾的 "/"
+    }
+    return dir.string();
+}
+
+}  // namespace
+
+std::shared_ptr<const TilePack> TilePack::forDirectory(
+    const std::string& resourceDir) {
+    const std::string key = sharedPackKey(resourceDir);
+    std::lock_guard<std::mutex> lock(sharedPacksMutex);
+    auto it = sharedPacks.find(key);
+    if (it != sharedPacks.end()) {
+        return it->second;
+    }
+
+    std::string path = resourceDir + "/" + kFileName;
+    if (!std::filesystem::exists(path)) {
+        return nullptr;
+    }
+    auto pack = std::make_shared<TilePack>();
+    if (!pack->open(path)) {
+        return nullptr;
+    }
+    sharedPacks[key] = pack;
+    return pack;
+}
+
+void TilePack::releaseShared() {
+    std::lock_guard<std::mutex> lock(sharedPacksMutex);
+    sharedPacks.clear();
+}
+
+void TilePack::releaseShared(const std::string& resourceDir) {
+    const std::string key = sharedPackKey(resourceDir);
+    std::lock_guard<std::mutex> lock(sharedPacksMutex);
+    sharedPacks.erase(key);
+}
+
+bool TilePack::loadTile(const std::string& filePath,
+                        std::vector<unsigned char>& pixels, int* width,
+                        int* height, PaletteImage* palette,
+                        BlockImage* blocks, ChannelImage* channels,
+                        RleImage* rle) {
+    std::vector<unsigned char> scratch;
+    size_t slash = filePath.find_last_of('/');
+    if (slash != std::string::npos) {
+        auto pack = forDirectory(filePath.substr(0, slash));
+        std::string name = filePath.substr(slash + 1);
+        if (pack && pack->contains(name)) {
+            const unsigned char* data = nullptr;
+            size_t size = 0;
+            return pack->getPayload(name, data, size, scratch) &&
+                   decodeTile(data, size, pixels, width, height, palette,
+                              blocks, channels, rle);
+        }
+    }
+
+    // 没有打包文件：读取单独的瓦片文件
+    FILE* file = std::fopen(filePath.c_str(), "rb");
+    if (!file) return false;
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    bool ok = size > 0;
+    if (ok) {
+        scratch.resize(static_cast<size_t>(size));
+        ok = std::fread(scratch.data(), 1, scratch.size(), file) ==
+             scratch.size();
+    }
+    std::fclose(file);
+    return ok && decodeTile(scratch.data(), scratch.size(), pixels, width,
+                            height, palette, blocks, channels, rle);
+}
+
+TilePackWriter::~TilePackWriter() {
+    if (file_) {
+        std::fclose(file_);
+        std::remove((path_ + ".tmp").c_str());
+    }
+}
+
+bool TilePackWriter::open(const std::string& path) {
+    path_ = path;
+    file_ = std::fopen((path_ + ".tmp").c_str(), "wb");
+    if (!file_) return false;
+
+    // 文件头在 finish() 时回填
+    unsigned char header[kPackHeaderSize] = {};
+    failed_ = std::fwrite(header, 1, kPackHeaderSize, file_) != kPackHeaderSize;
+    offset_ = kPackHeaderSize;
+    entries_.clear();
+    return !failed_;
+}
+
+bool TilePackWriter::add(const std::string& name, const unsigned char* data,
+                         size_t size) {
+    if (!file_ || name.size() > 0xFFFF) return false;
+    if (std::fwrite(data, 1, size, file_) != size) {
+        failed_ = true;
+        return false;
+    }
+    entries_.push_back(Entry{name, offset_, size});
+    offset_ += size;
+    return true;
+}
+
+bool TilePackWriter::finish() {
+    if (!file_) return false;
+
+    uint64_t tableOffset = offset_;
+    std::vector<unsigned char> table;
+    for (const auto& entry : entries_) {
+        size_t pos = table.size();
+        table.resize(pos + 2 + entry.name.size() + 16);
+        putLE(&table[pos], entry.name.size(), 2);
+        std::memcpy(&table[pos + 2], entry.name.data(), entry.name.size());
+        putLE(&table[pos + 2 + entry.name.size()], entry.offset, 8);
+        putLE(&table[pos + 10 + entry.name.size()], entry.size, 8);
+    }
+
+    unsigned char header[kPackHeaderSize] = {};
+    std::memcpy(header, kPackMagic, sizeof(kPackMagic));
+    putLE(header + 8, entries_.size(), 4);
+    putLE(header + 16, tableOffset, 8);
+
+    bool ok = !failed_ &&
+              std::fwrite(table.data(), 1, table.size(), file_) ==
+                  table.size() &&
+              seekFile(file_, 0) &&
+              std::fwrite(header, 1, kPackHeaderSize, file_) ==
+                  kPackHeaderSize;
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+
+    std::string tmpPath = path_ + ".tmp";
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path_, ec);
+    return !ec;
+}
@@ -1,11 +1,11 @@
 #include "TileSplitter.hpp"
 
-#include <cstring>
 #include <iostream>
 #include <vector>
 
+#include "HilbertCurve.hpp"
+#include "RawImage.hpp"
 #include "stb_image.h"
-#include "stb_image_write.h"
 
 using namespace std;
 
@@ -23,28 +23,127 @@ vector<TileMeta> TileSplitter::split(const string& inputPath,
             string("Failed to load PNG: ") + inputPath +
             " reason=" + (stbi_failure_reason() ? stbi_failure_reason() : ""));
     }
+    imageWidth_ = W;
+    imageHeight_ = H;
     vector<TileMeta> metas;
-    int stride = W * 4;
+    vector<TileJob> jobs;
+    const string extension = TileCodec::extension(writerConfig_.codec);
     for (int y = 0; y < H; y += tileH) {
         for (int x = 0; x < W; x += tileW) {
             int cw = std::min(tileW, W - x);
             int ch = std::min(tileH, H - y);
             string tileName =
-                "tile_" + to_string(x) + "_" + to_string(y) + ".png";
-            string outPath = outDir + "/" + tileName;
-            // Copy region into temporary buffer
-            vector<unsigned char> buf(cw * ch * 4);
-            for (int row = 0; row < ch; ++row) {
-                memcpy(&buf[row * cw * 4], data + (y + row) * stride + x * 4,
-                       cw * 4);
-            }
-            if (!stbi_write_png(outPath.c_str(), cw, ch, 4, buf.data(),
-                                cw * 4)) {
-                cerr << "Warn: write tile failed " << outPath << "\n";
-            }
+                "tile_" + to_string(x) + "_" + to_string(y) + extension;
+            jobs.push_back(TileJob{x, y, cw, ch, tileName});
+            jobs.back().trim = trimTransparent_;
             metas.push_back(TileMeta{x, y, cw, ch, tileName});
         }
     }
+    if (hilbertOrder_) {
+        // Jobs follow the metadata so the pack payloads share its order
+        vector<TileMeta> sortedMetas;
+        vector<TileJob> sortedJobs;
+        for (size_t i : HilbertCurve::sortedOrder(metas, W, H)) {
+            sortedMetas.push_back(std::move(metas[i]));
+            sortedJobs.push_back(std::move(jobs[i]));
+        }
+        metas = std::move(sortedMetas);
+        jobs = std::move(sortedJobs);
+    }
+    // Encode and write tiles on the worker pool
+    TileWriter writer(writerConfig_);
+    vector<TileOutput> outputs;
+    vector<bool> written = writer.writeAll(data, W, H, jobs, outDir, &outputs);
+    applyOutputs(metas, 0, written, outputs, outDir);
     stbi_image_free(data);
+    if (!writer.finish()) {
+        throw runtime_error("Failed to write tile pack in " + outDir);
+    }
+    return metas;
+}
+
+vector<TileMeta> TileSplitter::splitStreaming(const string& inputPath,
+                                              const string& outDir, int tileW,
+                                              int tileH, int stripHeight) {
+    if (!std::filesystem::exists(outDir)) {
+        std::filesystem::create_directories(outDir);
+    }
+    RawImageReader reader;
+    if (!reader.open(inputPath)) {
+        throw runtime_error(string("Failed to open raw image: ") + inputPath);
+    }
+    const int W = reader.getWidth();
+    const int H = reader.getHeight();
+    imageWidth_ = W;
+    imageHeight_ = H;
+    // Whole tile rows per strip, so every tile is cropped from one strip
+    int tileRows = std::max(1, (stripHeight + tileH - 1) / tileH);
+    int rowsPerStrip = tileRows * tileH;
+    vector<unsigned char> strip(static_cast<size_t>(W) * rowsPerStrip * 4);
+
+    vector<TileMeta> metas;
+    const string extension = TileCodec::extension(writerConfig_.codec);
+    TileWriter writer(writerConfig_);
+    for (int top = 0; top < H; top += rowsPerStrip) {
+        int rows = std::min(rowsPerStrip, H - top);
+        if (!reader.readRows(top, rows, strip.data())) {
+            throw runtime_error("Failed to read rows " + to_string(top) + "-" +
+                                to_string(top + rows) + " of " + inputPath);
+        }
+        vector<TileJob> jobs;
+        const size_t firstMeta = metas.size();
+        for (int y = top; y < top + rows; y += tileH) {
+            for (int x = 0; x < W; x += tileW) {
+                int cw = std::min(tileW, W - x);
+                int ch = std::min(tileH, H - y);
+                string tileName =
+                    "tile_" + to_string(x) + "_" + to_string(y) + extension;
+                jobs.push_back(TileJob{x, y - top, cw, ch, tileName});
+                jobs.back().trim = trimTransparent_;
+                metas.push_back(TileMeta{x, y, cw, ch, tileName});
+            }
+        }
+        vector<TileOutput> outputs;
+        vector<bool> written =
+            writer.writeAll(strip.data(), W, rows, jobs, outDir, &outputs);
+        applyOutputs(metas, firstMeta, written, outputs, outDir);
+    }
+    if (!writer.finish()) {
+        throw runtime_error("Failed to write tile pack in " + outDir);
+    }
+    if (hilbertOrder_) {
+        // Payloads were written strip by strip; only the metadata is reordered
+        vector<TileMeta> sortedMetas;
+        for (size_t i : HilbertCurve::sortedOrder(metas, W, H)) {
+            sortedMetas.push_back(std::move(metas[i]));
+        }
+        metas = std::move(sortedMetas);
+    }
     return metas;
 }
+
+void TileSplitter::applyOutputs(vector<TileMeta>& metas, size_t firstMeta,
+                                const vector<bool>& written,
+                                const vector<TileOutput>& outputs,
+                                const string& outDir) {
+    size_t kept = firstMeta;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        TileMeta meta = std::move(metas[firstMeta + i]);
+        const TileOutput& output = outputs[i];
+        if (!written[i]) {
+            cerr << "Warn: write tile failed " << outDir << "/"
+                 << output.fileName << "\n";
+        }
+        if (output.empty) continue;
+        // With content dedup, repeated tiles reference one shared file
+        meta.file = output.fileName;
+        if (output.trimmed) {
+            meta.x += output.x;
+            meta.y += output.y;
+            meta.w = output.width;
+            meta.h = output.height;
+        }
+        metas[kept++] = std::move(meta);
+    }
+    metas.resize(kept);
+}
@@ -0,0 +1,532 @@
+#include "TileWriter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+
+#include "ColorChecker.hpp"
+#include "EncodeCache.hpp"
+#include "MemoryBudget.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+
+// 两条独立的 64 位乘法-旋转通道，按 8 字节字累计，得到 128 位内容哈希
+class ContentHasher {
+   public:
+    explicit ContentHasher(uint64_t seed)
+        : a_(seed ^ 0x9E3779B97F4A7C15ull), b_(~seed ^ 0xC2B2AE3D27D4EB4Full) {}
+
+    void update(const unsigned char* data, size_t size) {
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            mix(word);
+        }
+        if (i < size) {
+            uint64_t word = 0;
+            std::memcpy(&word, data + i, size - i);
+            mix(word ^ (static_cast<uint64_t>(size - i) << 56));
+        }
+    }
+
+    std::pair<uint64_t, uint64_t> digest() const {
+        return {finalize(a_), finalize(b_ ^ a_)};
+    }
+
+   private:
+    static uint64_t rotl(uint64_t v, int r) {
+        return (v << r) | (v >> (64 - r));
+    }
+
+    static uint64_t finalize(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDull;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ull;
+        k ^= k >> 33;
+        return k;
+    }
+
+    void mix(uint64_t word) {
+        a_ = rotl(a_ ^ (word * 0x87C37B91114253D5ull), 31) *
+             0x4CF5AD432745937Full;
+        b_ = rotl(b_ ^ (word * 0xFF51AFD7ED558CCDull), 29) *
+             0xC4CEB9FE1A85EC53ull;
+    }
+
+    uint64_t a_;
+    uint64_t b_;
+};
+
+std::string contentFileName(const std::pair<uint64_t, uint64_t>& key,
+                            TileCodec::Type codec) {
+    return "tile_" + TileWriter::hashToHex(key) + TileCodec::extension(codec);
+}
+
+// 把文件名的扩展名换为 extension（行程编码、调色板或通道精简格式）
+std::string replaceExtension(const std::string& fileName,
+                             const char* extension) {
+    return std::filesystem::path(fileName)
+        .replace_extension(extension)
+        .string();
+}
+
+}  // namespace
+
+TileWriter::TileWriter(const Config& config) : config_(config) {}
+
+std::pair<uint64_t, uint64_t> TileWriter::hashPixels(
+    const unsigned char* pixels, int width, int height) {
+    // 尺寸参与哈希，内容相同但尺寸不同的瓦片不会合并
+    ContentHasher hasher(static_cast<uint64_t>(width) << 32 |
+                         static_cast<uint32_t>(height));
+    hasher.update(pixels, static_cast<size_t>(width) * height * 4);
+    return hasher.digest();
+}
+
+std::pair<uint64_t, uint64_t> TileWriter::hashRegion(
+    const unsigned char* imageData, int imageWidth, int x, int y, int width,
+    int height) {
+    ContentHasher hasher(static_cast<uint64_t>(width) << 32 |
+                         static_cast<uint32_t>(height));
+    const size_t stride = static_cast<size_t>(imageWidth) * 4;
+    for (int dy = 0; dy < height; ++dy) {
+        hasher.update(
+            imageData + (y + dy) * stride + static_cast<size_t>(x) * 4,
+            static_cast<size_t>(width) * 4);
+    }
+    return hasher.digest();
+}
+
+std::string TileWriter::hashToHex(const std::pair<uint64_t, uint64_t>& hash) {
+    char hex[33];
+    std::snprintf(hex, sizeof(hex), "%016llx%016llx",
+                  static_cast<unsigned long long>(hash.first),
+                  static_cast<unsigned long long>(hash.second));
+    return hex;
+}
+
+size_t TileWriter::estimateJobBytes(const TileJob& job) {
+    return static_cast<size_t>(job.width) * job.height * 4 * 2;
+}
+
+bool TileWriter::contentRect(const unsigned char* imageData, int imageWidth,
+                             int imageHeight, const TileJob& job,
+                             Rect& rect) {
+    if (!job.trim) {
+        rect = Rect{0, 0, job.width, job.height};
+        return true;
+    }
+    if (!job.pixels.empty()) {
+        return ColorChecker::opaqueBounds(job.pixels.data(), job.width, 0, 0,
+                                          job.width, job.height, rect.x,
+                                          rect.y, rect.width, rect.height);
+    }
+
+    // 超出图像的部分是透明填充，只需检查图像内的区域
+    int actualWidth = std::min(job.width, imageWidth - job.x);
+    int actualHeight = std::min(job.height, imageHeight - job.y);
+    if (actualWidth <= 0 || actualHeight <= 0 ||
+        !ColorChecker::opaqueBounds(imageData, imageWidth, job.x, job.y,
+                                    actualWidth, actualHeight, rect.x, rect.y,
+                                    rect.width, rect.height)) {
+        return false;
+    }
+    rect.x -= job.x;
+    rect.y -= job.y;
+    return true;
+}
+
+void TileWriter::cropJob(const unsigned char* imageData, int imageWidth,
+                         int imageHeight, const TileJob& job, const Rect& rect,
+                         std::vector<unsigned char>& out) {
+    // 超出图像的部分保持为透明像素
+    out.assign(static_cast<size_t>(rect.width) * rect.height * 4, 0);
+    const size_t dstStride = static_cast<size_t>(rect.width) * 4;
+
+    const unsigned char* src;
+    size_t srcStride;
+    int copyWidth;
+    int copyHeight;
+    if (!job.pixels.empty()) {
+        srcStride = static_cast<size_t>(job.width) * 4;
+        src = job.pixels.data() + rect.y * srcStride +
+              static_cast<size_t>(rect.x) * 4;
+        copyWidth = rect.width;
+        copyHeight = rect.height;
+    } else {
+        int left = job.x + rect.x;
+        int top = job.y + rect.y;
+        srcStride = static_cast<size_t>(imageWidth) * 4;
+        src = imageData + top * srcStride + static_cast<size_t>(left) * 4;
+        copyWidth = std::min(rect.width, imageWidth - left);
+        copyHeight = std::min(rect.height, imageHeight - top);
+    }
+
+    if (copyWidth <= 0) {
+        return;
+    }
+    for (int dy = 0; dy < copyHeight; ++dy) {
+        std::memcpy(&out[dy * dstStride], src + dy * srcStride,
+                    static_cast<size_t>(copyWidth) * 4);
+    }
+}
+
+std::vector<bool> TileWriter::writeAll(const unsigned char* imageData,
+                                       int imageWidth, int imageHeight,
+                                       const std::vector<TileJob>& jobs,
+                                       const std::string& outDir,
+                                       std::vector<TileOutput>* outputs) {
+    // vector<bool> 不能被多个线程同时写入，内部使用 char
+    std::vector<char> written(jobs.size(), 0);
+    peakInFlightBytes_ = 0;
+
+    // 确定每个任务写出的矩形和文件名；完全透明的裁剪任务无需写出，
+    // 去重时按任务顺序由每种内容的首个任务编码
+    std::vector<Rect> rects(jobs.size());
+    std::vector<std::string> names(jobs.size());
+    std::vector<DedupEntry*> entries(jobs.size(), nullptr);
+    std::vector<size_t> encodeOrder;
+    encodeOrder.reserve(jobs.size());
+    std::vector<unsigned char> content;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!contentRect(imageData, imageWidth, imageHeight, jobs[i],
+                         rects[i])) {
+            rects[i] = Rect{0, 0, 0, 0};
+            written[i] = 1;
+            continue;
+        }
+        if (!config_.dedupContent) {
+            names[i] = jobs[i].fileName;
+            encodeOrder.push_back(i);
+            continue;
+        }
+        cropJob(imageData, imageWidth, imageHeight, jobs[i], rects[i],
+                content);
+        auto key = hashPixels(content.data(), rects[i].width, rects[i].height);
+        auto it = dedup_.find(key);
+        if (it == dedup_.end()) {
+            DedupEntry entry{contentFileName(key, config_.codec), false};
+            ChannelImage::Layout layout;
+            unsigned char color[3];
+            if (config_.rleTiles &&
+                TileCodec::fitsRle(content.data(), rects[i].width,
+                                   rects[i].height)) {
+                entry.fileName = replaceExtension(entry.fileName,
+                                                  TileCodec::kRleExtension);
+            } else if (config_.paletteTiles &&
+                       TileCodec::fitsPalette(content.data(), rects[i].width,
+                                              rects[i].height)) {
+                entry.fileName = replaceExtension(
+                    entry.fileName, TileCodec::kPaletteExtension);
+            } else if (reducesChannels() &&
+                       TileCodec::reducibleChannels(content.data(),
+                                                    rects[i].width,
+                                                    rects[i].height, layout,
+                                                    color)) {
+                entry.fileName = replaceExtension(
+                    entry.fileName, TileCodec::kChannelExtension);
+            }
+            // 文件名由内容决定，目录中已有的同名文件（如增量分割时上次
+            // 写出的）内容相同，不再重写
+            std::error_code ec;
+            entry.written =
+                !config_.packOutput &&
+                std::filesystem::exists(outDir + "/" + entry.fileName, ec);
+            it = dedup_.emplace(key, std::move(entry)).first;
+            if (!it->second.written) {
+                encodeOrder.push_back(i);
+            }
+        }
+        entries[i] = &it->second;
+        names[i] = it->second.fileName;
+    }
+    // 紧凑格式瓦片的文件名在编码时才确定，编码结束后再填写写出结果
+    auto fillOutputs = [&] {
+        if (!outputs) return;
+        outputs->assign(jobs.size(), TileOutput());
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            TileOutput& output = (*outputs)[i];
+            output.fileName = names[i];
+            output.x = rects[i].x;
+            output.y = rects[i].y;
+            output.width = rects[i].width;
+            output.height = rects[i].height;
+            output.trimmed = jobs[i].trim;
+            output.empty = rects[i].width == 0;
+        }
+    };
+
+    if (config_.packOutput && !pack_) {
+        pack_ = std::make_unique<TilePackWriter>();
+        if (!pack_->open(outDir + "/" + TilePack::kFileName)) {
+            pack_.reset();
+            fillOutputs();
+            return std::vector<bool>(jobs.size(), false);
+        }
+        packDir_ = outDir;
+    }
+    TilePackWriter* pack = pack_.get();
+
+    int numThreads = config_.pool
+                         ? config_.pool->size()
+                         : ThreadPool::resolveThreadCount(config_.numThreads);
+    if (numThreads <= 1 && !config_.pool) {
+        std::vector<unsigned char> encoded;
+        for (size_t i : encodeOrder) {
+            peakInFlightBytes_ =
+                std::max(peakInFlightBytes_, estimateJobBytes(jobs[i]));
+            encoded.clear();
+            written[i] = encodeJob(imageData, imageWidth, imageHeight, jobs[i],
+                                   rects[i], names[i], outDir,
+                                   pack ? &encoded : nullptr);
+            if (pack && written[i]) {
+                SplitProfile::Timer timer(config_.profile,
+                                          SplitProfile::Phase::Write,
+                                          encoded.size());
+                written[i] = pack->add(names[i], encoded.data(),
+                                       encoded.size());
+            }
+        }
+        fillOutputs();
+        return resolveDuplicates(written, encodeOrder, entries);
+    }
+
+    // 同时排队的任务数也加以限制，避免大量小瓦片堆满任务队列
+    const size_t maxInFlightJobs = static_cast<size_t>(numThreads) * 4;
+
+    std::mutex mutex;
+    std::condition_variable released;
+    size_t inFlightBytes = 0;
+    // 原子计数：共享预算在自身的锁内读取它，本写出器没有进行中的任务时
+    // 不再等待其他写出器释放预算
+    std::atomic<size_t> inFlightJobs{0};
+    std::exception_ptr error;
+    MemoryBudget* budget = config_.memoryBudget;
+
+    // 打包模式：编码完成的数据按任务顺序写入打包文件，写入后才释放预算，
+    // 使打包文件内容与线程调度无关
+    std::map<size_t, std::vector<unsigned char>> completed;
+    size_t nextToPack = 0;
+    auto releaseJob = [&](size_t cost) {
+        inFlightBytes -= cost;
+        --inFlightJobs;
+        if (budget) budget->release(cost);
+    };
+
+    {
+        // 使用共享线程池时任务可能在本函数返回后才退出，因此保留 future
+        // 等待全部任务结束，而不是依赖线程池析构
+        std::unique_ptr<ThreadPool> ownPool;
+        ThreadPool* pool = config_.pool;
+        if (!pool) {
+            ownPool = std::make_unique<ThreadPool>(numThreads);
+            pool = ownPool.get();
+        }
+        std::vector<std::future<void>> futures;
+        futures.reserve(encodeOrder.size());
+
+        for (size_t k = 0; k < encodeOrder.size(); ++k) {
+            const size_t i = encodeOrder[k];
+            size_t cost = estimateJobBytes(jobs[i]);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                released.wait(lock, [&] {
+                    return inFlightJobs == 0 ||
+                           (inFlightJobs < maxInFlightJobs &&
+                            (budget || inFlightBytes + cost <=
+                                           config_.maxInFlightBytes));
+                });
+                if (error) {
+                    break;
+                }
+            }
+            // 只有本函数提交任务，等待共享预算期间 inFlightJobs 只会减少
+            if (budget) {
+                budget->acquire(cost, &inFlightJobs);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                inFlightBytes += cost;
+                ++inFlightJobs;
+                peakInFlightBytes_ =
+                    std::max(peakInFlightBytes_, inFlightBytes);
+            }
+
+            futures.push_back(pool->submit([&, k, i, cost] {
+                std::vector<unsigned char> encoded;
+                try {
+                    written[i] = encodeJob(imageData, imageWidth, imageHeight,
+                                           jobs[i], rects[i], names[i], outDir,
+                                           pack ? &encoded : nullptr);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!pack) {
+                        releaseJob(cost);
+                    } else {
+                        completed.emplace(k, std::move(encoded));
+                        while (!completed.empty() &&
+                               completed.begin()->first == nextToPack) {
+                            auto& front = completed.begin()->second;
+                            size_t packed = encodeOrder[nextToPack];
+                            if (written[packed]) {
+                                SplitProfile::Timer timer(
+                                    config_.profile, SplitProfile::Phase::Write,
+                                    front.size());
+                                written[packed] =
+                                    pack->add(names[packed], front.data(),
+                                              front.size());
+                            }
+                            releaseJob(estimateJobBytes(jobs[packed]));
+                            completed.erase(completed.begin());
+                            ++nextToPack;
+                        }
+                    }
+                }
+                released.notify_all();
+            }));
+        }
+
+        // 等待所有已提交任务完成
+        for (auto& future : futures) {
+            future.wait();
+        }
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    fillOutputs();
+    return resolveDuplicates(written, encodeOrder, entries);
+}
+
+std::vector<bool> TileWriter::resolveDuplicates(
+    const std::vector<char>& written, const std::vector<size_t>& encodeOrder,
+    const std::vector<DedupEntry*>& entries) {
+    if (!config_.dedupContent) {
+        return std::vector<bool>(written.begin(), written.end());
+    }
+    // 重复的瓦片与其内容首次出现的任务（可能在之前的 writeAll 中）结果一致
+    for (size_t i : encodeOrder) {
+        entries[i]->written = written[i] != 0;
+    }
+    std::vector<bool> result(written.size());
+    for (size_t i = 0; i < written.size(); ++i) {
+        result[i] = entries[i] ? entries[i]->written : written[i] != 0;
+    }
+    return result;
+}
+
+bool TileWriter::finish() {
+    dedup_.clear();
+    if (!pack_) {
+        return true;
+    }
+    bool ok = pack_->finish();
+    pack_.reset();
+    TilePack::releaseShared(packDir_);
+    return ok;
+}
+
+bool TileWriter::encodeJob(const unsigned char* imageData, int imageWidth,
+                           int imageHeight, const TileJob& job,
+                           const Rect& rect, std::string& fileName,
+                           const std::string& outDir,
+                           std::vector<unsigned char>* encoded) const {
+    std::vector<unsigned char> buffer;
+    std::vector<unsigned char>& out = encoded ? *encoded : buffer;
+
+    if (job.pixels.empty() &&
+        (job.x + rect.x >= imageWidth || job.y + rect.y >= imageHeight)) {
+        return false;
+    }
+    {
+        SplitProfile::Timer timer(
+            config_.profile, SplitProfile::Phase::Encode,
+            static_cast<uint64_t>(rect.width) * rect.height * 4);
+        std::vector<unsigned char> tileData;
+        cropJob(imageData, imageWidth, imageHeight, job, rect, tileData);
+
+        if (config_.rleTiles &&
+            TileCodec::encodeRle(tileData.data(), rect.width, rect.height,
+                                 out)) {
+            fileName = replaceExtension(fileName, TileCodec::kRleExtension);
+        } else if (config_.paletteTiles &&
+                   TileCodec::encodePalette(tileData.data(), rect.width,
+                                            rect.height, out)) {
+            fileName =
+                replaceExtension(fileName, TileCodec::kPaletteExtension);
+        } else if (reducesChannels() &&
+                   TileCodec::encodeChannels(tileData.data(), rect.width,
+                                             rect.height, out)) {
+            fileName =
+                replaceExtension(fileName, TileCodec::kChannelExtension);
+        } else if (!encodeCached(tileData, rect, out)) {
+            return false;
+        }
+    }
+
+    if (encoded) {
+        return true;
+    }
+
+    SplitProfile::Timer timer(config_.profile, SplitProfile::Phase::Write,
+                              out.size());
+    std::string outputPath = outDir + "/" + fileName;
+    // 去重文件存在即被信任（见 writeAll），先写临时文件再改名，中断的
+    // 写出不会留下同名的残缺文件
+    std::string writePath =
+        config_.dedupContent ? outputPath + ".tmp" : outputPath;
+    FILE* file = std::fopen(writePath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (config_.dedupContent) {
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(writePath, outputPath, ec);
+            ok = !ec;
+        }
+        if (!ok) {
+            std::filesystem::remove(writePath, ec);
+        }
+    }
+    return ok;
+}
+
+bool TileWriter::encodeCached(const std::vector<unsigned char>& tileData,
+                              const Rect& rect,
+                              std::vector<unsigned char>& out) const {
+    // 像素未变的瓦片直接复用缓存中的编码结果
+    EncodeCache* cache = config_.encodeCache;
+    std::pair<uint64_t, uint64_t> key;
+    if (cache) {
+        key = hashPixels(tileData.data(), rect.width, rect.height);
+        if (cache->load(key, config_.codec, out)) {
+            return true;
+        }
+    }
+    if (!TileCodec::encode(config_.codec, tileData.data(), rect.width,
+                           rect.height, out)) {
+        return false;
+    }
+    if (cache) {
+        cache->store(key, config_.codec, out);
+    }
+    return true;
+}
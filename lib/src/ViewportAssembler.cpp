@@ -5,10 +5,11 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <sstream>
 #include <vector>
 
-#include "stb_image.h"
+#include "TilePack.hpp"
 #include "stb_image_write.h"
 
 using namespace std;
@@ -36,52 +37,54 @@ void ViewportAssembler::blit(std::vector<unsigned char>& canvas, int canvas_w,
     }
 }
 
+namespace {
+
+// Reduced pixels of an LOD level belong to the map area containing the top-left
+// corner of their block, so [x, x + w) maps to [ceil(x / s), ceil((x + w) / s))
+void toLevelSpace(int level, int& x, int& y, int& w, int& h) {
+    const int scale = 1 << level;
+    int right = (x + w + scale - 1) >> level;
+    int bottom = (y + h + scale - 1) >> level;
+    x = (x + scale - 1) >> level;
+    y = (y + scale - 1) >> level;
+    w = right - x;
+    h = bottom - y;
+}
+
+}  // namespace
+
 bool ViewportAssembler::assemble(const TileIndex& index, const Viewport& vp,
                                  const string& resourceDir,
-                                 const string& outFile) const {
+                                 const string& outFile, int level) const {
     using clock = std::chrono::high_resolution_clock;
     auto t0 = clock::now();
-    auto tiles = index.query(vp);
+    auto tiles = index.queryLod(vp, level);
     if (tiles.empty()) {
         cerr << "No tiles overlap viewport\n";
         return false;
     }
+    // LOD tiles are drawn like full-resolution tiles in the reduced space
+    Viewport out = vp;
+    if (level > 0) {
+        toLevelSpace(level, out.x, out.y, out.w, out.h);
+        for (auto& t : tiles) toLevelSpace(level, t.x, t.y, t.w, t.h);
+    }
     // RGBA buffer for viewport
-    vector<unsigned char> canvas(vp.w * vp.h * 4, 0);
+    vector<unsigned char> canvas(out.w * out.h * 4, 0);
     // load each tile (assume current working dir contains tile files or provide
     // relative path externally)
-    for (auto& t : tiles) {
-        int localX = t.x - vp.x;
-        int localY = t.y - vp.y;
-        
-        if (isPureColorTile(t.file)) {
-            // 处理纯色瓦片
-            uint32_t color = parseColorFromFileName(t.file);
-            blitSolidColor(canvas, vp.w, vp.h, color, t.w, t.h, localX, localY);
-        } else {
-            // 处理普通瓦片
-            int w, h, c;
-            unsigned char* data =
-                stbi_load((resourceDir + "/" + t.file).c_str(), &w, &h, &c, 4);
-            if (!data) {
-                cerr << "Failed load tile " << t.file << "\n";
-                continue;
-            }
-            blit(canvas, vp.w, vp.h, data, w, h, w * 4, localX, localY);
-            stbi_image_free(data);
-        }
-    }
+    renderTiles(canvas, out, tiles, resourceDir);
 
     // write viewport png
-    if (!stbi_write_png(outFile.c_str(), vp.w, vp.h, 4, canvas.data(),
-                        vp.w * 4)) {
+    if (!stbi_write_png(outFile.c_str(), out.w, out.h, 4, canvas.data(),
+                        out.w * 4)) {
         cerr << "Failed write viewport png\n";
         return false;
     }
     auto t1 = clock::now();
     double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
-    cerr << "Assemble time: " << ms << " ms (viewport " << vp.w << "x" << vp.h
-         << ", tiles=";
+    cerr << "Assemble time: " << ms << " ms (viewport " << out.w << "x"
+         << out.h << ", tiles=";
     cerr << tiles.size() << ")\n";
     return true;
 }
@@ -95,27 +98,7 @@ std::string ViewportAssembler::assembleToHex(
         return "";
     }
     std::vector<unsigned char> canvas(vp.w * vp.h * 4, 0);
-    for (auto& t : tiles) {
-        int lx = t.x - vp.x;
-        int ly = t.y - vp.y;
-        
-        if (isPureColorTile(t.file)) {
-            // 处理纯色瓦片
-            uint32_t color = parseColorFromFileName(t.file);
-            blitSolidColor(canvas, vp.w, vp.h, color, t.w, t.h, lx, ly);
-        } else {
-            // 处理普通瓦片
-            int w, h, c;
-            std::string tilePath = resourceDir + "/" + t.file;
-            unsigned char* data = stbi_load(tilePath.c_str(), &w, &h, &c, 4);
-            if (!data) {
-                std::cerr << "Fail tile " << t.file << "\n";
-                continue;
-            }
-            blit(canvas, vp.w, vp.h, data, w, h, w * 4, lx, ly);
-            stbi_image_free(data);
-        }
-    }
+    renderTiles(canvas, vp, tiles, resourceDir);
     // output hex values
     std::stringstream ss;
     ss << std::hex << std::uppercase << std::setfill('0');
@@ -132,6 +115,53 @@ std::string ViewportAssembler::assembleToHex(
     return ss.str();
 }
 
+void ViewportAssembler::renderTiles(std::vector<unsigned char>& canvas,
+                                    const Viewport& vp,
+                                    const std::vector<TileMeta>& tiles,
+                                    const std::string& resourceDir) const {
+    // Draw tiles grouped by file so an atlas page (or a deduplicated tile) is
+    // decoded once per viewport. Split tiles never overlap, so the drawing
+    // order does not change the result.
+    vector<size_t> order(tiles.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return tiles[a].file < tiles[b].file;
+    });
+
+    vector<unsigned char> pixels;  // decoded payload, reused across tiles
+    string decodedFile;
+    int w = 0, h = 0;
+    for (size_t i : order) {
+        const TileMeta& t = tiles[i];
+        int localX = t.x - vp.x;
+        int localY = t.y - vp.y;
+
+        if (isPureColorTile(t.file)) {
+            // 处理纯色瓦片
+            uint32_t color = parseColorFromFileName(t.file);
+            blitSolidColor(canvas, vp.w, vp.h, color, t.w, t.h, localX, localY);
+            continue;
+        }
+
+        // 处理普通瓦片
+        if (t.file != decodedFile) {
+            decodedFile.clear();
+            if (!TilePack::loadTile(resourceDir + "/" + t.file, pixels, &w,
+                                    &h)) {
+                cerr << "Failed load tile " << t.file << "\n";
+                continue;
+            }
+            decodedFile = t.file;
+        }
+        if (t.srcX >= w || t.srcY >= h) continue;
+        // the tile's rectangle inside the payload (a sub-rectangle for atlases)
+        const unsigned char* src =
+            pixels.data() + (static_cast<size_t>(t.srcY) * w + t.srcX) * 4;
+        blit(canvas, vp.w, vp.h, src, min(t.w, w - t.srcX),
+             min(t.h, h - t.srcY), w * 4, localX, localY);
+    }
+}
+
 bool ViewportAssembler::isPureColorTile(const std::string& fileName) {
     // 纯色瓦片文件名格式：8位十六进制RGBA值（如 "FF0000FF"）
     if (fileName.length() == 8) {
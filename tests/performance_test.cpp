@@ -1,11 +1,32 @@
 #include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
 #include <string>
+#include <tuple>
 
 #include <iostream>
+#include <vector>
 
+#include "BinaryMeta.hpp"
+#include "ColorChecker.hpp"
+#include "Downsampler.hpp"
 #include "QuadTreeIndex.hpp"
+#include "QuadTreeSplitter.hpp"
+#include "RawImage.hpp"
+#include "TileCodec.hpp"
 #include "TileIndex.hpp"
+#include "TilePack.hpp"
+#include "TileWriter.hpp"
 #include "ViewportAssembler.hpp"
 
 // Fixture for benchmark tests
@@ -63,8 +84,1408 @@ BENCHMARK_F(ViewportBenchmark, QuadTreeIndexQuery)(benchmark::State& state) {
     }
 }
 
-// Main function to run benchmarks
-BENCHMARK_MAIN();
+// Benchmark for ColorChecker::isUniformColor on a fully uniform square region.
+// A uniform region is the worst case: every pixel has to be compared.
+// Args: {side, simd (0 = scalar path), colorTolerance}
+static void ColorCheckerUniform(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    const bool simd = state.range(1) != 0;
+    std::vector<unsigned char> image(static_cast<size_t>(side) * side * 4,
+                                     0x7F);
+    ColorChecker checker;
+    checker.setSimdEnabled(simd);
+    checker.setColorTolerance(static_cast<int>(state.range(2)));
+    for (auto _ : state) {
+        bool uniform =
+            checker.isUniformColor(image.data(), side, 0, 0, side, side);
+        benchmark::DoNotOptimize(uniform);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * side *
+                            side * 4);
+    state.SetLabel(simd ? ColorChecker::simdKernelName() : "scalar");
+}
+
+static void ColorCheckerArgs(benchmark::internal::Benchmark* b) {
+    for (int side = 4; side <= 4096; side *= 4) {
+        for (int simd = 0; simd <= 1; ++simd) {
+            for (int tolerance : {0, 2}) {
+                b->Args({side, simd, tolerance});
+            }
+        }
+    }
+}
+BENCHMARK(ColorCheckerUniform)->Apply(ColorCheckerArgs);
+
+// Benchmark for Downsampler::halve (alpha-weighted 2x2 filter used for LOD
+// tiles) on a square image of noise.
+// Args: {side, simd (0 = scalar path)}
+static void DownsamplerHalve(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    const bool simd = state.range(1) != 0;
+    std::vector<unsigned char> image(static_cast<size_t>(side) * side * 4);
+    unsigned int seed = 1;
+    for (auto& byte : image) {
+        seed = seed * 1103515245u + 12345u;
+        byte = static_cast<unsigned char>(seed >> 24);
+    }
+    std::vector<unsigned char> half;
+    Downsampler::setSimdEnabled(simd);
+    for (auto _ : state) {
+        Downsampler::halve(image.data(), side, side, half);
+        benchmark::DoNotOptimize(half.data());
+    }
+    Downsampler::setSimdEnabled(true);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            image.size());
+    state.SetLabel(simd ? "simd" : "scalar");
+}
+BENCHMARK(DownsamplerHalve)
+    ->ArgsProduct({{64, 256, 1024, 4096}, {0, 1}});
+
+// Noise image whose alpha is 0 or 255 for about a third of the pixels each,
+// so blocks mix transparent, opaque and translucent pixels
+static std::vector<unsigned char> noiseImage(int width, int height,
+                                             unsigned int seed) {
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < image.size(); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        image[i] = static_cast<unsigned char>(seed >> 24);
+        if (i % 4 == 3 && image[i] < 170) {
+            image[i] = image[i] < 85 ? 0 : 255;
+        }
+    }
+    return image;
+}
+
+static std::vector<unsigned char> halveWith(bool simd,
+                                            const std::vector<unsigned char>&
+                                                image,
+                                            int width, int height) {
+    std::vector<unsigned char> half;
+    Downsampler::setSimdEnabled(simd);
+    Downsampler::halve(image.data(), width, height, half);
+    Downsampler::setSimdEnabled(true);
+    return half;
+}
+
+TEST(Downsampler, SimdMatchesScalar) {
+    const int sizes[][2] = {{1, 1}, {7, 5}, {8, 2}, {17, 9}, {64, 33},
+                            {255, 3}};
+    for (const auto& size : sizes) {
+        auto image = noiseImage(size[0], size[1], size[0] * 31 + size[1]);
+        EXPECT_EQ(halveWith(true, image, size[0], size[1]),
+                  halveWith(false, image, size[0], size[1]))
+            << size[0] << "x" << size[1];
+    }
+}
+
+TEST(Downsampler, WeightsColorByAlpha) {
+    // 2x2 blocks of 16x2 images so that both kernels see them
+    for (bool simd : {false, true}) {
+        std::vector<unsigned char> image(16 * 2 * 4, 0);
+        auto set = [&](int x, int y, std::initializer_list<int> rgba) {
+            std::copy(rgba.begin(), rgba.end(), &image[(y * 16 + x) * 4]);
+        };
+        // Opaque edge next to transparent pixels with stray RGB
+        set(0, 0, {100, 25, 25, 255});
+        set(0, 1, {100, 25, 25, 255});
+        set(1, 0, {200, 100, 50, 0});
+        // Fully transparent block (2-3) stays (0, 0, 0, 0)
+        set(2, 0, {90, 80, 70, 0});
+        // Translucent pixels are weighted by their alpha
+        set(4, 0, {200, 0, 0, 200});
+        set(5, 0, {0, 0, 200, 50});
+        auto half = halveWith(simd, image, 16, 2);
+        const std::vector<unsigned char> expected = {
+            100, 25, 25, 128, 0, 0, 0, 0, 160, 0, 40, 63};
+        EXPECT_EQ(std::vector<unsigned char>(half.begin(), half.begin() + 12),
+                  expected)
+            << (simd ? "simd" : "scalar");
+    }
+}
+
+// Decoded RGBA tiles of the sample map, shared by the codec benchmarks.
+struct CodecSample {
+    std::vector<unsigned char> pixels;
+    int width;
+    int height;
+};
+
+static const std::vector<CodecSample>& codecSamples() {
+    static std::vector<CodecSample> samples = [] {
+        std::vector<CodecSample> out;
+        const std::string dir = "data/quad_tiles";
+        TileIndex index;
+        if (!index.load(dir + "/meta.txt")) return out;
+        Viewport all = {0, 0, index.getMapWidth(), index.getMapHeight()};
+        for (const auto& tile : index.query(all)) {
+            if (tile.file.length() == 8) continue;  // pure color, no payload
+            CodecSample sample;
+            if (TilePack::loadTile(dir + "/" + tile.file, sample.pixels,
+                                   &sample.width, &sample.height)) {
+                out.push_back(std::move(sample));
+            }
+            if (out.size() == 2000) break;
+        }
+        return out;
+    }();
+    return samples;
+}
+
+// Decode throughput and compression ratio of a tile codec on the sample map's
+// quad-tree tiles. Bytes/s counts decoded RGBA bytes.
+// Args: {codec (0 = png, 1 = qoi)}
+static void TileCodecDecode(benchmark::State& state) {
+    const auto type = state.range(0) == 0 ? TileCodec::Type::Png
+                                          : TileCodec::Type::Qoi;
+    const auto& samples = codecSamples();
+    if (samples.empty()) {
+        state.SkipWithError("No tiles found in data/quad_tiles");
+        return;
+    }
+
+    std::vector<std::vector<unsigned char>> encoded(samples.size());
+    size_t rawBytes = 0;
+    size_t encodedBytes = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        TileCodec::encode(type, samples[i].pixels.data(), samples[i].width,
+                          samples[i].height, encoded[i]);
+        rawBytes += samples[i].pixels.size();
+        encodedBytes += encoded[i].size();
+    }
+
+    std::vector<unsigned char> pixels;
+    int width, height;
+    for (auto _ : state) {
+        for (const auto& data : encoded) {
+            TileCodec::decode(data.data(), data.size(), pixels, &width,
+                              &height);
+            benchmark::DoNotOptimize(pixels.data());
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                            rawBytes);
+    state.counters["ratio"] = static_cast<double>(rawBytes) / encodedBytes;
+    state.SetLabel(TileCodec::name(type));
+}
+BENCHMARK(TileCodecDecode)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Smooth RGB gradient over the image, opaque unless alpha is given
+static std::vector<unsigned char> gradientImage(int width, int height,
+                                                int alpha = 255) {
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char* p = &image[(static_cast<size_t>(y) * width + x) * 4];
+            p[0] = static_cast<unsigned char>(x * 255 / (width - 1));
+            p[1] = static_cast<unsigned char>(y * 255 / (height - 1));
+            p[2] = static_cast<unsigned char>((x + y) * 255 /
+                                              (width + height - 2));
+            p[3] = static_cast<unsigned char>(alpha);
+        }
+    }
+    return image;
+}
+
+// Largest per-channel difference between two RGBA images of the same size
+static int maxChannelError(const std::vector<unsigned char>& a,
+                           const std::vector<unsigned char>& b) {
+    int error = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        error = std::max(error, std::abs(a[i] - b[i]));
+    }
+    return error;
+}
+
+TEST(TileCodec, PngAndQoiRoundTripExactly) {
+    const auto image = noiseImage(37, 29, 7);
+    for (auto type : {TileCodec::Type::Png, TileCodec::Type::Qoi}) {
+        std::vector<unsigned char> encoded;
+        ASSERT_TRUE(TileCodec::encode(type, image.data(), 37, 29, encoded));
+        std::vector<unsigned char> pixels;
+        int width = 0, height = 0;
+        ASSERT_TRUE(TileCodec::decode(encoded.data(), encoded.size(), pixels,
+                                      &width, &height))
+            << TileCodec::name(type);
+        EXPECT_EQ(width, 37);
+        EXPECT_EQ(height, 29);
+        EXPECT_EQ(pixels, image) << TileCodec::name(type);
+    }
+}
+
+TEST(TileCodec, PaletteRoundTripsExactly) {
+    // 5 colours, one of them transparent; 3 bit indices round up to 4
+    const unsigned char colors[5][4] = {{255, 0, 0, 255},
+                                        {0, 128, 0, 255},
+                                        {0, 0, 0, 0},
+                                        {10, 20, 30, 40},
+                                        {255, 255, 255, 255}};
+    std::vector<unsigned char> image;
+    for (int y = 0; y < 13; ++y) {
+        for (int x = 0; x < 21; ++x) {
+            const unsigned char* c = colors[(x * y + x) % 5];
+            image.insert(image.end(), c, c + 4);
+        }
+    }
+    ASSERT_TRUE(TileCodec::fitsPalette(image.data(), 21, 13));
+    std::vector<unsigned char> encoded;
+    ASSERT_TRUE(TileCodec::encodePalette(image.data(), 21, 13, encoded));
+    ASSERT_TRUE(TileCodec::isPalette(encoded.data(), encoded.size()));
+    PaletteImage palette;
+    ASSERT_TRUE(
+        TileCodec::decodePalette(encoded.data(), encoded.size(), palette));
+    EXPECT_EQ(palette.bitsPerIndex, 4);
+    std::vector<unsigned char> pixels;
+    palette.expand(pixels);
+    EXPECT_EQ(pixels, image);
+
+    // 12 more colours make 17
+    for (int i = 0; i < 12; ++i) {
+        image[(5 * 21 + i) * 4 + 1] = static_cast<unsigned char>(i + 1);
+    }
+    encoded.clear();
+    EXPECT_FALSE(TileCodec::fitsPalette(image.data(), 21, 13));
+    EXPECT_FALSE(TileCodec::encodePalette(image.data(), 21, 13, encoded));
+}
+
+TEST(TileCodec, ChannelsRoundTripExactly) {
+    auto opaque = noiseImage(23, 11, 3);
+    auto gray = opaque;
+    auto mask = opaque;
+    for (size_t i = 0; i < opaque.size(); i += 4) {
+        opaque[i + 3] = 255;
+        gray[i + 1] = gray[i + 2] = gray[i];
+        gray[i + 3] = 255;
+        mask[i] = 12;
+        mask[i + 1] = 34;
+        mask[i + 2] = 56;
+    }
+    const std::pair<const std::vector<unsigned char>*, ChannelImage::Layout>
+        cases[] = {{&opaque, ChannelImage::Layout::Rgb},
+                   {&gray, ChannelImage::Layout::Gray},
+                   {&mask, ChannelImage::Layout::Alpha}};
+    for (const auto& [image, layout] : cases) {
+        ChannelImage::Layout reduced;
+        unsigned char color[3];
+        ASSERT_TRUE(TileCodec::reducibleChannels(image->data(), 23, 11,
+                                                 reduced, color));
+        EXPECT_EQ(reduced, layout);
+        std::vector<unsigned char> encoded;
+        ASSERT_TRUE(
+            TileCodec::encodeChannels(image->data(), 23, 11, encoded));
+        ChannelImage channels;
+        ASSERT_TRUE(TileCodec::decodeChannels(encoded.data(), encoded.size(),
+                                              channels));
+        EXPECT_EQ(channels.layout, layout);
+        std::vector<unsigned char> pixels;
+        channels.expand(pixels);
+        EXPECT_EQ(pixels, *image) << static_cast<int>(layout);
+    }
+
+    // Translucent colour needs all four channels
+    std::vector<unsigned char> encoded;
+    const auto full = noiseImage(23, 11, 3);
+    EXPECT_FALSE(TileCodec::encodeChannels(full.data(), 23, 11, encoded));
+}
+
+TEST(TileCodec, RleRoundTripsExactly) {
+    // Runs of 9 pixels that do not line up with rows, plus one odd pixel
+    std::vector<unsigned char> image;
+    for (int i = 0; i < 40 * 6; ++i) {
+        const int run = i / 9;
+        const unsigned char pixel[4] = {
+            static_cast<unsigned char>(run),
+            static_cast<unsigned char>(run * 7), 0,
+            static_cast<unsigned char>(run % 3 ? 255 : 0)};
+        image.insert(image.end(), pixel, pixel + 4);
+    }
+    image[(2 * 40 + 17) * 4] = 200;
+    ASSERT_TRUE(TileCodec::fitsRle(image.data(), 40, 6));
+    std::vector<unsigned char> encoded;
+    ASSERT_TRUE(TileCodec::encodeRle(image.data(), 40, 6, encoded));
+    EXPECT_LT(encoded.size(), image.size());
+    RleImage rle;
+    ASSERT_TRUE(TileCodec::decodeRle(encoded.data(), encoded.size(), rle));
+    std::vector<unsigned char> pixels;
+    rle.expand(pixels);
+    EXPECT_EQ(pixels, image);
+
+    // Noise never gets smaller
+    const auto noise = noiseImage(40, 6, 5);
+    encoded.clear();
+    EXPECT_FALSE(TileCodec::fitsRle(noise.data(), 40, 6));
+    EXPECT_FALSE(TileCodec::encodeRle(noise.data(), 40, 6, encoded));
+}
+
+TEST(TileCodec, BlocksStayWithinErrorBound) {
+    // Sizes that are not multiples of 4 exercise the partial edge blocks
+    const auto image = gradientImage(37, 29);
+    for (auto format : {BlockImage::Format::Bc1, BlockImage::Format::Bc3}) {
+        std::vector<unsigned char> encoded;
+        ASSERT_TRUE(
+            TileCodec::encodeBlocks(format, image.data(), 37, 29, encoded));
+        BlockImage blocks;
+        ASSERT_TRUE(
+            TileCodec::decodeBlocks(encoded.data(), encoded.size(), blocks));
+        EXPECT_EQ(blocks.sizeBytes(),
+                  static_cast<size_t>(10 * 8) * blocks.blockBytes());
+        std::vector<unsigned char> pixels;
+        blocks.expand(pixels);
+        ASSERT_EQ(pixels.size(), image.size());
+        // Four colours on one line per block cannot follow a gradient that
+        // changes along x and y; 565 endpoints add up to 4 more
+        EXPECT_LE(maxChannelError(pixels, image), 20);
+
+        // The generic decoder gives the same pixels
+        std::vector<unsigned char> decoded;
+        int width = 0, height = 0;
+        ASSERT_TRUE(TileCodec::decode(encoded.data(), encoded.size(), decoded,
+                                      &width, &height));
+        EXPECT_EQ(decoded, pixels);
+    }
+}
+
+TEST(TileCodec, BlocksKeepAlpha) {
+    // Alternate fully transparent and opaque columns, then a ramp
+    auto image = gradientImage(16, 8);
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            image[(y * 16 + x) * 4 + 3] = static_cast<unsigned char>(
+                y < 4 ? (x % 2 ? 255 : 0) : x * 17);
+        }
+    }
+    for (auto format : {BlockImage::Format::Bc1, BlockImage::Format::Bc3}) {
+        std::vector<unsigned char> encoded;
+        ASSERT_TRUE(
+            TileCodec::encodeBlocks(format, image.data(), 16, 8, encoded));
+        BlockImage blocks;
+        ASSERT_TRUE(
+            TileCodec::decodeBlocks(encoded.data(), encoded.size(), blocks));
+        std::vector<unsigned char> pixels;
+        blocks.expand(pixels);
+        for (size_t i = 3; i < image.size(); i += 4) {
+            if (format == BlockImage::Format::Bc1) {
+                // Punch-through alpha: below 128 is transparent
+                EXPECT_EQ(pixels[i], image[i] < 128 ? 0 : 255) << i / 4;
+            } else if (image[i] == 0 || image[i] == 255) {
+                EXPECT_EQ(pixels[i], image[i]) << i / 4;
+            } else {
+                // 8 interpolated levels over the block's alpha range
+                EXPECT_LE(std::abs(pixels[i] - image[i]), 4)
+                    << i / 4;
+            }
+        }
+    }
+}
+
+// Lossy merging replaces a region by its average colour only while every
+// pixel stays within lossyMaxError of it; other tiles are stored exactly.
+TEST(QuadTreeSplitter, LossyTilesStayWithinBudget) {
+    const int side = 64;
+    std::vector<unsigned char> image(side * side * 4);
+    unsigned int seed = 11;
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            seed = seed * 1103515245u + 12345u;
+            // Quadrants: +-2 noise, +-6 noise, a gradient, a flat colour
+            const int quadrant = (y / 32) * 2 + x / 32;
+            const int noise = static_cast<int>(seed >> 24) % 13 - 6;
+            unsigned char* p = &image[(y * side + x) * 4];
+            p[0] = static_cast<unsigned char>(
+                quadrant == 0 ? 100 + noise / 3 : quadrant == 1 ? 100 + noise
+                : quadrant == 2 ? x * 4 : 50);
+            p[1] = static_cast<unsigned char>(120 + (quadrant < 2 ? noise / 3
+                                                                   : 0));
+            p[2] = static_cast<unsigned char>(quadrant == 2 ? y * 4 : 80);
+            p[3] = 255;
+        }
+    }
+    const auto dir =
+        std::filesystem::temp_directory_path() / "performance_test_lossy";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::vector<unsigned char> png;
+    ASSERT_TRUE(TileCodec::encode(TileCodec::Type::Png, image.data(), side,
+                                  side, png));
+    const std::string input = (dir / "input.png").string();
+    std::ofstream(input, std::ios::binary)
+        .write(reinterpret_cast<const char*>(png.data()),
+               static_cast<std::streamsize>(png.size()));
+
+    QuadTreeSplitter::Config config(8, 4);
+    config.lossyMaxError = 3;
+    config.verbosity = 0;
+    QuadTreeSplitter splitter;
+    const auto tiles =
+        splitter.splitQuadTree(input, (dir / "out").string(), config);
+    ASSERT_FALSE(tiles.empty());
+    int lossy = 0;
+    for (const auto& tile : tiles) {
+        std::vector<unsigned char> pixels;
+        int width = tile.w, height = tile.h;
+        if (tile.file.length() == 8) {
+            const uint32_t color = std::stoul(tile.file, nullptr, 16);
+            for (int i = 0; i < tile.w * tile.h; ++i) {
+                for (int c = 0; c < 4; ++c) {
+                    pixels.push_back(color >> (24 - 8 * c));
+                }
+            }
+        } else {
+            ASSERT_TRUE(TilePack::loadTile((dir / "out" / tile.file).string(),
+                                           pixels, &width, &height));
+            EXPECT_EQ(tile.err, 0);
+        }
+        std::vector<unsigned char> source;
+        for (int y = 0; y < tile.h; ++y) {
+            const auto row = image.begin() + ((tile.y + y) * side + tile.x) * 4;
+            source.insert(source.end(), row, row + tile.w * 4);
+        }
+        EXPECT_LE(tile.err, config.lossyMaxError);
+        EXPECT_EQ(maxChannelError(pixels, source), tile.err)
+            << tile.x << "," << tile.y << " " << tile.file;
+        lossy += tile.err > 0;
+    }
+    EXPECT_GT(lossy, 0);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(BinaryMeta, RoundTripsTiles) {
+    std::vector<TileMeta> tiles = {{0, 0, 256, 128, "tile_0_0_256_128.png"},
+                                   {256, 0, 64, 64, "ff0000ff"},
+                                   {256, 64, 64, 64, "ff0000ff"},
+                                   {0, 128, 30, 20, "atlas_0.qoi", 33, 17},
+                                   {0, 0, 320, 148, "lod_1_0_0.png"},
+                                   {0, 0, 320, 148, "lod_2_0_0.png"}};
+    tiles[2].err = 3;
+    tiles[4].lod = 1;
+    tiles[5].lod = 2;
+    BinaryMeta::Info info;
+    info.codec = TileCodec::Type::Qoi;
+    info.mapWidth = 320;
+    info.mapHeight = 148;
+    info.declaredWidth = 300;
+    info.declaredHeight = 148;
+    info.lodLevels = 2;
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "performance_test_rt.bin")
+            .string();
+    ASSERT_TRUE(BinaryMeta::write(path, info, tiles));
+    ASSERT_TRUE(BinaryMeta::isBinaryMeta(path));
+
+    {
+        BinaryMeta meta;
+        ASSERT_TRUE(meta.open(path));
+        const auto& read = meta.getInfo();
+        EXPECT_EQ(read.codec, info.codec);
+        EXPECT_EQ(read.mapWidth, info.mapWidth);
+        EXPECT_EQ(read.mapHeight, info.mapHeight);
+        EXPECT_EQ(read.declaredWidth, info.declaredWidth);
+        EXPECT_EQ(read.declaredHeight, info.declaredHeight);
+        EXPECT_EQ(read.lodLevels, info.lodLevels);
+        size_t next = 0;
+        for (int level = 0; level <= read.lodLevels; ++level) {
+            size_t count = 0;
+            const BinaryMeta::Record* records = meta.records(level, count);
+            for (size_t i = 0; i < count; ++i, ++next) {
+                ASSERT_LT(next, tiles.size());
+                const TileMeta tile = meta.toTileMeta(records[i]);
+                const TileMeta& expected = tiles[next];
+                EXPECT_EQ(tile.lod, level);
+                EXPECT_EQ(std::tie(tile.x, tile.y, tile.w, tile.h, tile.file,
+                                   tile.srcX, tile.srcY, tile.lod, tile.err),
+                          std::tie(expected.x, expected.y, expected.w,
+                                   expected.h, expected.file, expected.srcX,
+                                   expected.srcY, expected.lod, expected.err));
+            }
+        }
+        EXPECT_EQ(next, tiles.size());
+    }
+
+    // Levels must be in ascending order
+    std::swap(tiles[0], tiles[5]);
+    EXPECT_FALSE(BinaryMeta::write(path, info, tiles));
+    std::filesystem::remove(path);
+}
+
+TEST(TilePack, RoundTripsPayloads) {
+    const auto dir =
+        std::filesystem::temp_directory_path() / "performance_test_pack";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const auto image = noiseImage(19, 7, 9);
+    std::vector<unsigned char> png, qoi;
+    ASSERT_TRUE(TileCodec::encode(TileCodec::Type::Png, image.data(), 19, 7,
+                                  png));
+    ASSERT_TRUE(TileCodec::encode(TileCodec::Type::Qoi, image.data(), 19, 7,
+                                  qoi));
+    {
+        TilePackWriter writer;
+        ASSERT_TRUE(writer.open((dir / TilePack::kFileName).string()));
+        ASSERT_TRUE(writer.add("a.png", png.data(), png.size()));
+        ASSERT_TRUE(writer.add("b.qoi", qoi.data(), qoi.size()));
+        ASSERT_TRUE(writer.finish());
+    }
+
+    TilePack pack;
+    ASSERT_TRUE(pack.open((dir / TilePack::kFileName).string()));
+    EXPECT_EQ(pack.size(), 2u);
+    EXPECT_FALSE(pack.contains("c.png"));
+    const std::pair<const char*, const std::vector<unsigned char>*> entries[] =
+        {{"a.png", &png}, {"b.qoi", &qoi}};
+    for (const auto& [name, payload] : entries) {
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        std::vector<unsigned char> scratch;
+        ASSERT_TRUE(pack.getPayload(name, data, size, scratch)) << name;
+        EXPECT_EQ(std::vector<unsigned char>(data, data + size), *payload)
+            << name;
+
+        // Tiles are looked up in the directory's pack before loose files
+        std::vector<unsigned char> pixels;
+        int width = 0, height = 0;
+        ASSERT_TRUE(TilePack::loadTile((dir / name).string(), pixels, &width,
+                                       &height))
+            << name;
+        EXPECT_EQ(pixels, image) << name;
+    }
+    TilePack::releaseShared();
+    std::filesystem::remove_all(dir);
+}
+
+// The shared pack of a directory must follow the pack on disk: a lookup
+// before the pack exists is not cached, and rewriting the pack through
+// TileWriter drops the old mapping.
+TEST(TilePack, SharedPackFollowsRewrites) {
+    const auto dir =
+        std::filesystem::temp_directory_path() / "performance_test_reload";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const auto image = noiseImage(16, 16, 4);
+    auto load = [&](const std::string& name) {
+        std::vector<unsigned char> pixels;
+        int width = 0, height = 0;
+        return TilePack::loadTile((dir / name).string(), pixels, &width,
+                                  &height) &&
+               pixels == image;
+    };
+    auto split = [&](const std::string& name) {
+        TileWriter::Config config;
+        config.packOutput = true;
+        TileWriter writer(config);
+        TileJob job{0, 0, 16, 16, name};
+        // "dir/" names the same directory as "dir"
+        auto written = writer.writeAll(image.data(), 16, 16, {job},
+                                       dir.string() + "/");
+        return written[0] && writer.finish();
+    };
+
+    EXPECT_FALSE(load("first.png"));
+    ASSERT_TRUE(split("first.png"));
+    EXPECT_TRUE(load("first.png"));
+    ASSERT_TRUE(split("second.png"));
+    EXPECT_TRUE(load("second.png"));
+    EXPECT_FALSE(load("first.png"));
+    TilePack::releaseShared();
+    std::filesystem::remove_all(dir);
+}
+
+// Empty directory under the system temp directory
+static std::filesystem::path freshDir(const std::string& name) {
+    const auto dir = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+// Map-like image for the split tests: water and land split by a diagonal
+// edge, a noisy patch and a patch of small (+-3) noise that colour
+// tolerance can absorb, so leaves appear at every depth.
+static std::vector<unsigned char> mapImage(int width, int height) {
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height * 4);
+    unsigned int seed = 5;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char* p = &image[(static_cast<size_t>(y) * width + x) * 4];
+            seed = seed * 1103515245u + 12345u;
+            const int noise = static_cast<int>(seed >> 16);
+            int rgb[3] = {90, 160, 60};
+            if (x >= width / 2 && x < width * 3 / 4 && y >= height / 3 &&
+                y < height * 2 / 3) {
+                rgb[0] = noise & 0xFF;
+                rgb[1] = (noise >> 8) & 0xFF;
+                rgb[2] = (noise >> 4) & 0xFF;
+            } else if (x + 2 * y < width) {
+                rgb[0] = 40;
+                rgb[1] = 90;
+                rgb[2] = 200;
+            } else if (x >= width / 8 && x < width / 3 && y >= height / 2 &&
+                       y < height * 7 / 8) {
+                for (int c = 0; c < 3; ++c) {
+                    rgb[c] += (noise >> (3 * c)) % 7 - 3;
+                }
+            }
+            for (int c = 0; c < 3; ++c) {
+                p[c] = static_cast<unsigned char>(rgb[c]);
+            }
+            p[3] = 255;
+        }
+    }
+    return image;
+}
+
+// Saves an RGBA image as the PNG input of a split
+static std::string writeTestPng(const std::filesystem::path& path,
+                                const std::vector<unsigned char>& image,
+                                int width, int height) {
+    std::vector<unsigned char> png;
+    TileCodec::encode(TileCodec::Type::Png, image.data(), width, height, png);
+    std::ofstream(path, std::ios::binary)
+        .write(reinterpret_cast<const char*>(png.data()),
+               static_cast<std::streamsize>(png.size()));
+    return path.string();
+}
+
+// One line per tile with every meta.txt field, for readable comparisons
+static std::vector<std::string> describeTiles(
+    const std::vector<TileMeta>& tiles) {
+    std::vector<std::string> lines;
+    for (const auto& tile : tiles) {
+        std::ostringstream line;
+        line << tile.x << ' ' << tile.y << ' ' << tile.w << ' ' << tile.h
+             << ' ' << tile.file << " sx=" << tile.srcX << " sy=" << tile.srcY
+             << " lod=" << tile.lod << " err=" << tile.err;
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+// Name -> content hash of the files a split wrote into dir
+static std::map<std::string, size_t> fileDigests(
+    const std::filesystem::path& dir) {
+    std::map<std::string, size_t> digests;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        std::ifstream file(entry.path(), std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+        digests[entry.path().filename().string()] =
+            std::hash<std::string>()(content);
+    }
+    return digests;
+}
+
+TEST(QuadTreeSplitter, ParallelBuildMatchesSerial) {
+    const auto dir = freshDir("performance_test_parallel");
+    const int width = 301, height = 203;
+    const std::string input = writeTestPng(
+        dir / "input.png", mapImage(width, height), width, height);
+    QuadTreeSplitter::Config config(8, 4);
+    config.verbosity = 0;
+    // Fan out to subtrees far smaller than the image
+    config.serialSubtreePixels = 16 * 16;
+    const auto serial = QuadTreeSplitter().splitQuadTree(
+        input, (dir / "serial").string(), config);
+    ASSERT_GT(serial.size(), 100u);
+
+    config.numThreads = 4;
+    const auto parallel = QuadTreeSplitter().splitQuadTree(
+        input, (dir / "parallel").string(), config);
+    EXPECT_EQ(describeTiles(parallel), describeTiles(serial));
+    EXPECT_EQ(fileDigests(dir / "parallel"), fileDigests(dir / "serial"));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(QuadTreeSplitter, PyramidBuildMatchesTopDown) {
+    const auto dir = freshDir("performance_test_pyramid");
+    const int width = 301, height = 203;
+    const std::string input = writeTestPng(
+        dir / "input.png", mapImage(width, height), width, height);
+    size_t tilesAtZero = 0;
+    for (int tolerance : {0, 6}) {
+        QuadTreeSplitter::Config config(8, 4, tolerance);
+        config.verbosity = 0;
+        const auto topDown = QuadTreeSplitter().splitQuadTree(
+            input, (dir / "topdown").string(), config);
+        ASSERT_FALSE(topDown.empty());
+        config.buildMode = QuadTreeSplitter::BuildMode::Pyramid;
+        for (int threads : {1, 4}) {
+            config.numThreads = threads;
+            config.serialSubtreePixels = 16 * 16;
+            const auto pyramid = QuadTreeSplitter().splitQuadTree(
+                input, (dir / "pyramid").string(), config);
+            EXPECT_EQ(describeTiles(pyramid), describeTiles(topDown))
+                << "tolerance " << tolerance << ", " << threads << " threads";
+            EXPECT_EQ(fileDigests(dir / "pyramid"),
+                      fileDigests(dir / "topdown"))
+                << "tolerance " << tolerance << ", " << threads << " threads";
+            std::filesystem::remove_all(dir / "pyramid");
+        }
+        std::filesystem::remove_all(dir / "topdown");
+        // The noise patch of small variation merges under tolerance
+        if (tolerance == 0) {
+            tilesAtZero = topDown.size();
+        } else {
+            EXPECT_LT(topDown.size(), tilesAtZero);
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// Streaming splits read the raw image a strip at a time; tiles that cross
+// strip boundaries are the fragile part, so strips of one row, an odd
+// height and the whole image must all give the in-memory result.
+TEST(QuadTreeSplitter, StreamingMatchesInMemory) {
+    const auto dir = freshDir("performance_test_streaming");
+    const int width = 301, height = 203;
+    const auto image = mapImage(width, height);
+    const std::string png =
+        writeTestPng(dir / "input.png", image, width, height);
+    const std::string raw = (dir / "input.rgba").string();
+    ASSERT_TRUE(RawImageReader::write(raw, image.data(), width, height));
+
+    QuadTreeSplitter::Config config(8, 4);
+    config.verbosity = 0;
+    const auto expected = QuadTreeSplitter().splitQuadTree(
+        png, (dir / "memory").string(), config);
+    ASSERT_FALSE(expected.empty());
+    for (int strip : {1, 7, height}) {
+        config.stripHeight = strip;
+        const auto tiles = QuadTreeSplitter().splitQuadTreeStreaming(
+            raw, (dir / "stream").string(), config);
+        EXPECT_EQ(describeTiles(tiles), describeTiles(expected))
+            << "strip " << strip;
+        EXPECT_EQ(fileDigests(dir / "stream"), fileDigests(dir / "memory"))
+            << "strip " << strip;
+        std::filesystem::remove_all(dir / "stream");
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(TileSplitter, StreamingMatchesInMemory) {
+    const auto dir = freshDir("performance_test_fixed_streaming");
+    const int width = 301, height = 203;
+    const auto image = mapImage(width, height);
+    const std::string png =
+        writeTestPng(dir / "input.png", image, width, height);
+    const std::string raw = (dir / "input.rgba").string();
+    ASSERT_TRUE(RawImageReader::write(raw, image.data(), width, height));
+
+    // 3-row tiles: strips of 1, 7 and 203 rows round up to 3, 9 and 204
+    const auto expected =
+        TileSplitter().split(png, (dir / "memory").string(), 64, 3);
+    ASSERT_FALSE(expected.empty());
+    for (int strip : {1, 7, height}) {
+        const auto tiles = TileSplitter().splitStreaming(
+            raw, (dir / "stream").string(), 64, 3, strip);
+        EXPECT_EQ(describeTiles(tiles), describeTiles(expected))
+            << "strip " << strip;
+        EXPECT_EQ(fileDigests(dir / "stream"), fileDigests(dir / "memory"))
+            << "strip " << strip;
+        std::filesystem::remove_all(dir / "stream");
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// Pixels of the x/y/w/h area of an RGBA image, row by row
+static std::vector<unsigned char> cropImage(
+    const std::vector<unsigned char>& image, int imageWidth, int x, int y,
+    int width, int height) {
+    std::vector<unsigned char> crop;
+    for (int row = 0; row < height; ++row) {
+        const auto begin =
+            image.begin() +
+            ((static_cast<size_t>(y) + row) * imageWidth + x) * 4;
+        crop.insert(crop.end(), begin, begin + static_cast<size_t>(width) * 4);
+    }
+    return crop;
+}
+
+// Dedup names files by content hash and picks the extension before the tile
+// is encoded; the file the encoder writes must be the one the metadata
+// names, and repeated leaves must share it.
+TEST(TileWriter, DedupSharesFilesWithPredictedExtensions) {
+    const auto dir = freshDir("performance_test_dedup");
+    // 32x32 blocks of five patterns: two noise blocks (PNG), horizontal
+    // bands (RLE), 1-pixel stripes of 3 colours (palette) and a flat colour
+    const int layout[4][4] = {
+        {0, 1, 2, 0}, {3, 4, 1, 2}, {0, 2, 3, 1}, {4, 0, 1, 3}};
+    const int side = 128;
+    std::vector<unsigned char> image(side * side * 4);
+    for (int by = 0; by < 4; ++by) {
+        for (int bx = 0; bx < 4; ++bx) {
+            const int pattern = layout[by][bx];
+            unsigned int seed = pattern;
+            for (int y = 0; y < 32; ++y) {
+                for (int x = 0; x < 32; ++x) {
+                    unsigned char* p =
+                        &image[((by * 32 + y) * side + bx * 32 + x) * 4];
+                    seed = seed * 1103515245u + 12345u;
+                    const unsigned char noise =
+                        static_cast<unsigned char>(seed >> 24);
+                    const unsigned char value =
+                        pattern == 0 || pattern == 3 ? noise
+                        : pattern == 1               ? (y / 3 % 2) * 200
+                        : pattern == 2               ? x % 3 * 100
+                                                     : 77;
+                    p[0] = value;
+                    p[1] = static_cast<unsigned char>(value / 2);
+                    p[2] = static_cast<unsigned char>(pattern * 50);
+                    p[3] = 255;
+                }
+            }
+        }
+    }
+    const std::string input = writeTestPng(dir / "input.png", image, side,
+                                           side);
+
+    QuadTreeSplitter::Config config(8, 32);
+    config.verbosity = 0;
+    config.dedupContent = true;
+    config.rleTiles = true;
+    config.paletteTiles = true;
+    const auto out = dir / "out";
+    const auto tiles =
+        QuadTreeSplitter().splitQuadTree(input, out.string(), config);
+    ASSERT_FALSE(tiles.empty());
+
+    std::map<std::vector<unsigned char>, std::string> fileOfContent;
+    std::map<std::string, int> extensions;
+    for (const auto& tile : tiles) {
+        if (tile.file.length() == 8) continue;  // pure colour, no file
+        const auto source =
+            cropImage(image, side, tile.x, tile.y, tile.w, tile.h);
+        auto inserted = fileOfContent.emplace(source, tile.file);
+        EXPECT_EQ(inserted.first->second, tile.file)
+            << "repeated leaf at " << tile.x << "," << tile.y;
+
+        // The extension matches the format the file was written in
+        std::ifstream file(out / tile.file, std::ios::binary);
+        ASSERT_TRUE(file) << tile.file << " is missing";
+        std::vector<unsigned char> data(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+        const std::string extension =
+            std::filesystem::path(tile.file).extension().string();
+        const char* expected = TileCodec::extension(TileCodec::Type::Png);
+        if (TileCodec::isRle(data.data(), data.size())) {
+            expected = TileCodec::kRleExtension;
+        } else if (TileCodec::isPalette(data.data(), data.size())) {
+            expected = TileCodec::kPaletteExtension;
+        }
+        EXPECT_EQ(extension, expected) << tile.file;
+        ++extensions[extension];
+
+        std::vector<unsigned char> pixels;
+        int width = 0, height = 0;
+        ASSERT_TRUE(TilePack::loadTile((out / tile.file).string(), pixels,
+                                       &width, &height));
+        EXPECT_EQ(pixels, source) << tile.file;
+    }
+    // One file per distinct content, covering every tile format
+    std::set<std::string> names;
+    for (const auto& entry : fileOfContent) names.insert(entry.second);
+    EXPECT_EQ(names.size(), fileOfContent.size());
+    EXPECT_EQ(fileDigests(out).size(), names.size());
+    EXPECT_EQ(fileOfContent.size(), 4u);
+    EXPECT_EQ(extensions.size(), 3u);
+    std::filesystem::remove_all(dir);
+}
+
+// Splits the map incrementally, paints the left half of one noise block with
+// a flat colour and splits again. The second run must match a full split of
+// the edited image without rewriting tiles outside the edit. With dedup a
+// copy of the edited area's top quarter stays elsewhere in the map, so the
+// files of those edited leaves are still shared and must survive.
+static void checkIncrementalSplit(bool dedup) {
+    const auto dir = freshDir("performance_test_incremental");
+    const int side = 256;
+    const int editX = 128, editY = 96, editSize = 32;
+    auto image = mapImage(side, side);
+    if (dedup) {
+        // Copy the top quarter of the area to be edited to (32, 160)
+        for (int y = 0; y < editSize / 2; ++y) {
+            std::copy_n(&image[((editY + y) * side + editX) * 4],
+                        editSize / 2 * 4,
+                        &image[((160 + y) * side + 32) * 4]);
+        }
+    }
+    QuadTreeSplitter::Config config(8, 4);
+    config.verbosity = 0;
+    config.dedupContent = dedup;
+    const auto out = dir / "out";
+    const std::string meta = (dir / "meta.txt").string();
+    const auto before = QuadTreeSplitter().splitQuadTreeIncremental(
+        writeTestPng(dir / "before.png", image, side, side), out.string(),
+        meta, config);
+    ASSERT_FALSE(before.empty());
+    TileIndex index;
+    index.setCodec(config.codec);
+    index.setTiles(before);
+    index.setMapSize(side, side);
+    ASSERT_TRUE(index.save(meta));
+
+    // Backdate every file so rewrites show up in the modification time
+    std::map<std::string, std::filesystem::file_time_type> times;
+    for (const auto& entry : std::filesystem::directory_iterator(out)) {
+        const auto time = entry.last_write_time() - std::chrono::hours(1);
+        std::filesystem::last_write_time(entry.path(), time);
+        times[entry.path().filename().string()] = time;
+    }
+
+    for (int y = editY; y < editY + editSize; ++y) {
+        for (int x = editX; x < editX + editSize / 2; ++x) {
+            unsigned char* p = &image[(y * side + x) * 4];
+            p[0] = 10;
+            p[1] = 20;
+            p[2] = 30;
+        }
+    }
+    const std::string after = writeTestPng(dir / "after.png", image, side,
+                                           side);
+    const auto tiles = QuadTreeSplitter().splitQuadTreeIncremental(
+        after, out.string(), meta, config);
+    const auto full = QuadTreeSplitter().splitQuadTree(
+        after, (dir / "full").string(), config);
+    auto described = describeTiles(tiles);
+    auto expected = describeTiles(full);
+    std::sort(described.begin(), described.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(described, expected);
+
+    // Same files as the full split: stale tiles are gone, shared ones remain
+    auto digests = fileDigests(out);
+    EXPECT_EQ(digests.erase(QuadTreeSplitter::kLeafHashFileName), 1u);
+    EXPECT_EQ(digests, fileDigests(dir / "full"));
+    std::set<std::string> referenced;
+    for (const auto& tile : tiles) referenced.insert(tile.file);
+    size_t stale = 0, shared = 0;
+    for (const auto& tile : before) {
+        const bool inEdit = tile.x < editX + editSize / 2 &&
+                            tile.x + tile.w > editX &&
+                            tile.y < editY + editSize &&
+                            tile.y + tile.h > editY;
+        if (tile.file.length() == 8) continue;  // pure colour, no file
+        if (!referenced.count(tile.file)) {
+            EXPECT_FALSE(std::filesystem::exists(out / tile.file))
+                << tile.file;
+            ++stale;
+        } else if (inEdit) {
+            EXPECT_TRUE(std::filesystem::exists(out / tile.file))
+                << tile.file;
+            ++shared;
+        } else {
+            EXPECT_EQ(std::filesystem::last_write_time(out / tile.file),
+                      times[tile.file])
+                << tile.file << " was rewritten";
+        }
+    }
+    EXPECT_GT(stale, 0u);
+    EXPECT_EQ(shared > 0, dedup);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(QuadTreeSplitter, IncrementalMatchesFullSplit) {
+    checkIncrementalSplit(false);
+}
+
+TEST(QuadTreeSplitter, IncrementalKeepsSharedDedupFiles) {
+    checkIncrementalSplit(true);
+}
+
+// Draws split tiles back into one RGBA image and counts how many tiles cover
+// each pixel
+static std::vector<unsigned char> renderTiles(
+    const std::filesystem::path& dir, const std::vector<TileMeta>& tiles,
+    int width, int height, std::vector<int>& coverage) {
+    std::vector<unsigned char> image(static_cast<size_t>(width) * height * 4);
+    coverage.assign(static_cast<size_t>(width) * height, 0);
+    for (const auto& tile : tiles) {
+        std::vector<unsigned char> pixels;
+        if (tile.file.length() == 8) {
+            const unsigned long color = std::stoul(tile.file, nullptr, 16);
+            for (int i = 0; i < tile.w * tile.h; ++i) {
+                for (int c = 0; c < 4; ++c) {
+                    pixels.push_back(
+                        static_cast<unsigned char>(color >> (24 - 8 * c)));
+                }
+            }
+        } else {
+            int w = 0, h = 0;
+            EXPECT_TRUE(TilePack::loadTile((dir / tile.file).string(), pixels,
+                                           &w, &h));
+            EXPECT_EQ(w, tile.w);
+            EXPECT_EQ(h, tile.h);
+            if (w != tile.w || h != tile.h) continue;
+        }
+        for (int y = 0; y < tile.h; ++y) {
+            for (int x = 0; x < tile.w; ++x) {
+                const size_t at =
+                    static_cast<size_t>(tile.y + y) * width + tile.x + x;
+                ++coverage[at];
+                std::copy_n(&pixels[(static_cast<size_t>(y) * tile.w + x) * 4],
+                            4, &image[at * 4]);
+            }
+        }
+    }
+    return image;
+}
+
+// A single-colour band that does not line up with the quad tree is covered
+// by many small uniform leaves; merging them must keep the same pixels with
+// each pixel covered exactly once.
+TEST(QuadTreeSplitter, MergeUniformKeepsCoverage) {
+    const auto dir = freshDir("performance_test_merge_uniform");
+    const int width = 200, height = 150;
+    auto image = noiseImage(width, height, 13);
+    for (int y = 37; y < 93; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char* p = &image[(static_cast<size_t>(y) * width + x) * 4];
+            p[0] = 200;
+            p[1] = 180;
+            p[2] = 40;
+            p[3] = 255;
+        }
+    }
+    const std::string input =
+        writeTestPng(dir / "input.png", image, width, height);
+
+    QuadTreeSplitter::Config config(8, 4);
+    config.verbosity = 0;
+    std::vector<size_t> counts;
+    for (bool merge : {false, true}) {
+        config.mergeUniform = merge;
+        const auto out = dir / (merge ? "merged" : "plain");
+        const auto tiles =
+            QuadTreeSplitter().splitQuadTree(input, out.string(), config);
+        std::vector<int> coverage;
+        EXPECT_EQ(renderTiles(out, tiles, width, height, coverage), image)
+            << "merge " << merge;
+        EXPECT_EQ(std::count(coverage.begin(), coverage.end(), 1),
+                  static_cast<long>(coverage.size()))
+            << "merge " << merge;
+        counts.push_back(tiles.size());
+    }
+    EXPECT_LT(counts[1], counts[0]);
+    std::filesystem::remove_all(dir);
+}
+
+// RGB noise whose left half has alpha 0..kTransparentAlpha and whose right
+// half has alpha kTransparentAlpha + 1
+static const int kTransparentAlpha = 8;
+static std::vector<unsigned char> halfTransparentImage(int width, int height) {
+    auto image = noiseImage(width, height, 21);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            unsigned char& alpha =
+                image[(static_cast<size_t>(y) * width + x) * 4 + 3];
+            alpha = static_cast<unsigned char>(
+                x < width / 2 ? alpha % (kTransparentAlpha + 1)
+                              : kTransparentAlpha + 1);
+        }
+    }
+    return image;
+}
+
+TEST(QuadTreeSplitter, TransparentAlphaDropsTransparentLeaves) {
+    const auto dir = freshDir("performance_test_transparent");
+    const int width = 128, height = 128;
+    QuadTreeSplitter::Config config(8, 4);
+    config.verbosity = 0;
+    config.transparentAlpha = kTransparentAlpha;
+    const auto tiles = QuadTreeSplitter().splitQuadTree(
+        writeTestPng(dir / "input.png", halfTransparentImage(width, height),
+                     width, height),
+        (dir / "out").string(), config);
+    ASSERT_FALSE(tiles.empty());
+    // The noisy left half counts as one transparent colour: no tile is kept
+    for (const auto& tile : tiles) {
+        EXPECT_GE(tile.x, width / 2) << describeTiles({tile})[0];
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(QuadTreeSplitter, TransparentAlphaSplitsVisiblePixels) {
+    const auto dir = freshDir("performance_test_transparent");
+    const int width = 128, height = 128;
+    const auto image = halfTransparentImage(width, height);
+    QuadTreeSplitter::Config config(8, 4);
+    config.verbosity = 0;
+    config.transparentAlpha = kTransparentAlpha;
+    const auto out = dir / "out";
+    const auto tiles = QuadTreeSplitter().splitQuadTree(
+        writeTestPng(dir / "input.png", image, width, height), out.string(),
+        config);
+    // Alpha just above the threshold is visible: the noise splits down to
+    // the minimum tile size and renders unchanged
+    EXPECT_EQ(tiles.size(), static_cast<size_t>(width / 2 / 4 * height / 4));
+    std::vector<int> coverage;
+    const auto rendered = renderTiles(out, tiles, width, height, coverage);
+    for (int y = 0; y < height; ++y) {
+        for (int x = width / 2; x < width; ++x) {
+            const size_t at = static_cast<size_t>(y) * width + x;
+            ASSERT_EQ(coverage[at], 1) << x << "," << y;
+            ASSERT_TRUE(std::equal(&image[at * 4], &image[at * 4 + 4],
+                                   &rendered[at * 4]))
+                << x << "," << y;
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// The sample map as one RGBA image, rebuilt from its fixed-size tiles.
+struct SampleMap {
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+};
+
+static const SampleMap& sampleMap() {
+    static SampleMap map = [] {
+        SampleMap out;
+        const std::string dir = "data/tiles";
+        TileIndex index;
+        if (!index.load(dir + "/meta.txt")) return out;
+        out.width = index.getMapWidth();
+        out.height = index.getMapHeight();
+        out.pixels.assign(static_cast<size_t>(out.width) * out.height * 4, 0);
+        Viewport all = {0, 0, out.width, out.height};
+        for (const auto& tile : index.query(all)) {
+            std::vector<unsigned char> pixels;
+            int width = tile.w;
+            int height = tile.h;
+            if (tile.file.length() == 8) {
+                uint32_t color = std::stoul(tile.file, nullptr, 16);
+                for (size_t i = 0; i < static_cast<size_t>(width) * height;
+                     ++i) {
+                    for (int c = 0; c < 4; ++c) {
+                        pixels.push_back(color >> (24 - 8 * c));
+                    }
+                }
+            } else if (!TilePack::loadTile(dir + "/" + tile.file, pixels,
+                                           &width, &height)) {
+                continue;
+            }
+            for (int y = 0; y < std::min(tile.h, height); ++y) {
+                std::copy_n(&pixels[static_cast<size_t>(y) * width * 4],
+                            std::min(tile.w, width) * 4,
+                            &out.pixels[((static_cast<size_t>(tile.y) + y) *
+                                             out.width +
+                                         tile.x) *
+                                        4]);
+            }
+        }
+        return out;
+    }();
+    return map;
+}
+
+// Fit of y = a + b * x minimising the relative error, returned as {a, b}:
+// a least-squares line through (1 / x, y / x), so the fixed cost is not
+// swamped by the largest samples.
+static std::pair<double, double> fitLine(const std::vector<double>& x,
+                                         const std::vector<double>& y) {
+    double n = static_cast<double>(x.size());
+    double su = 0, sv = 0, suu = 0, suv = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        double u = 1.0 / x[i];
+        double v = y[i] / x[i];
+        su += u;
+        sv += v;
+        suu += u * u;
+        suv += u * v;
+    }
+    double a = (n * suv - su * sv) / (n * suu - su * su);
+    return {a, (sv - a * su) / n};
+}
+
+// Calibrates QuadTreeSplitter::CostModel for a codec. Non-uniform squares of
+// 4 to 256 px are cut from the sample map, encoded and written one file
+// each (or into one tiles.pack), then read back and decoded one at a time
+// (block-compressed tiles are only unpacked, as the loaders keep them
+// compressed). Straight-line fits of the per-tile times give the fixed cost
+// per file (the intercepts) and the cost per byte read and per pixel decoded
+// (the slopes); a fit of the sizes gives bytes per pixel. tile_us is the
+// meta.txt parse time per tile.
+// Args: {codec (0 = png, 1 = qoi, 2 = bc1, 3 = bc3), pack (0 = files)}
+static void SplitCostCalibration(benchmark::State& state) {
+    const auto type = static_cast<TileCodec::Type>(state.range(0));
+    const bool packed = state.range(1) != 0;
+    const SampleMap& map = sampleMap();
+    if (map.pixels.empty()) {
+        state.SkipWithError("No tiles found in data/tiles");
+        return;
+    }
+
+    const auto dir = std::filesystem::temp_directory_path() /
+                     "performance_test_cost";
+    std::filesystem::create_directories(dir);
+    TilePackWriter writer;
+    if (packed) writer.open((dir / TilePack::kFileName).string());
+    ColorChecker checker;
+    std::vector<std::string> paths;
+    std::vector<double> pixelCounts;
+    std::vector<double> byteCounts;
+    for (int side = 4; side <= 256; side *= 2) {
+        int kept = 0;
+        for (int y = 0; y + side <= map.height && kept < 64; y += side) {
+            for (int x = 0; x + side <= map.width && kept < 64; x += side) {
+                if (checker.isUniformColor(map.pixels.data(), map.width, x,
+                                           y, side, side)) {
+                    continue;
+                }
+                std::vector<unsigned char> crop;
+                for (int row = 0; row < side; ++row) {
+                    const unsigned char* src =
+                        &map.pixels[((static_cast<size_t>(y) + row) *
+                                         map.width +
+                                     x) *
+                                    4];
+                    crop.insert(crop.end(), src, src + side * 4);
+                }
+                std::vector<unsigned char> encoded;
+                TileCodec::encode(type, crop.data(), side, side, encoded);
+                std::string name = std::to_string(paths.size()) + ".tile";
+                if (packed) {
+                    writer.add(name, encoded.data(), encoded.size());
+                    paths.push_back(name);
+                } else {
+                    std::string path = (dir / name).string();
+                    std::ofstream(path, std::ios::binary)
+                        .write(reinterpret_cast<const char*>(encoded.data()),
+                               encoded.size());
+                    paths.push_back(path);
+                }
+                pixelCounts.push_back(side * side);
+                byteCounts.push_back(encoded.size());
+                ++kept;
+            }
+        }
+    }
+
+    TilePack pack;
+    if (packed && !(writer.finish() &&
+                    pack.open((dir / TilePack::kFileName).string()))) {
+        std::filesystem::remove_all(dir);
+        state.SkipWithError("Failed to write tiles.pack");
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> readUs(paths.size(), 0.0);
+    std::vector<double> decodeUs(paths.size(), 0.0);
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> pixels;
+    BlockImage blocks;
+    for (auto _ : state) {
+        for (size_t i = 0; i < paths.size(); ++i) {
+            auto start = Clock::now();
+            const unsigned char* payload = nullptr;
+            size_t read = 0;
+            if (packed) {
+                pack.getPayload(paths[i], payload, read, data);
+            } else {
+                std::FILE* file = std::fopen(paths[i].c_str(), "rb");
+                data.resize(static_cast<size_t>(byteCounts[i]));
+                read = std::fread(data.data(), 1, data.size(), file);
+                std::fclose(file);
+                payload = data.data();
+            }
+            auto loaded = Clock::now();
+            int width, height;
+            if (type == TileCodec::Type::Bc1 || type == TileCodec::Type::Bc3) {
+                TileCodec::decodeBlocks(payload, read, blocks);
+            } else {
+                TileCodec::decode(payload, read, pixels, &width, &height);
+            }
+            auto decoded = Clock::now();
+            readUs[i] +=
+                std::chrono::duration<double, std::micro>(loaded - start)
+                    .count();
+            decodeUs[i] +=
+                std::chrono::duration<double, std::micro>(decoded - loaded)
+                    .count();
+        }
+    }
+    for (size_t i = 0; i < paths.size(); ++i) {
+        readUs[i] /= static_cast<double>(state.iterations());
+        decodeUs[i] /= static_cast<double>(state.iterations());
+    }
+    std::filesystem::remove_all(dir);
+
+    auto readFit = fitLine(byteCounts, readUs);
+    auto decodeFit = fitLine(pixelCounts, decodeUs);
+    auto sizeFit = fitLine(pixelCounts, byteCounts);
+    std::vector<unsigned char> solid(64 * 64 * 4, 0x7F);
+    std::vector<unsigned char> solidEncoded;
+    TileCodec::encode(type, solid.data(), 64, 64, solidEncoded);
+
+    TileIndex index;
+    auto start = Clock::now();
+    index.load("data/quad_tiles/meta.txt");
+    double indexUs =
+        std::chrono::duration<double, std::micro>(Clock::now() - start)
+            .count();
+    size_t indexTiles =
+        index.query({0, 0, index.getMapWidth(), index.getMapHeight()}).size();
+
+    state.counters["tile_us"] = indexTiles ? indexUs / indexTiles : 0.0;
+    state.counters["file_us"] = readFit.first + decodeFit.first;
+    state.counters["byte_ns"] = std::max(0.0, readFit.second * 1000.0);
+    state.counters["pixel_ns"] = std::max(0.0, decodeFit.second * 1000.0);
+    state.counters["busy_bpp"] = sizeFit.second;
+    state.counters["uniform_bpp"] =
+        std::max(0.0, solidEncoded.size() - sizeFit.first) / (64.0 * 64.0);
+    state.counters["tiles"] = static_cast<double>(paths.size());
+    state.SetLabel(std::string(TileCodec::name(type)) +
+                   (packed ? " pack" : ""));
+}
+BENCHMARK(SplitCostCalibration)
+    ->ArgsProduct({{0, 1, 2, 3}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// Startup cost of TileIndex: load the sample map's quad-tree metadata and
+// answer one viewport query, either parsing meta.txt or mapping the same
+// tiles saved as meta.bin.
+// Args: {format (0 = text, 1 = binary)}
+static void TileIndexLoad(benchmark::State& state) {
+    const std::string textPath = "data/quad_tiles/meta.txt";
+    const std::string binaryPath =
+        (std::filesystem::temp_directory_path() / "performance_test_meta.bin")
+            .string();
+    TileIndex source;
+    if (!source.load(textPath) || !source.saveBinary(binaryPath)) {
+        state.SkipWithError("No metadata found in data/quad_tiles");
+        return;
+    }
+    const std::string& path = state.range(0) == 0 ? textPath : binaryPath;
+
+    size_t visible = 0;
+    for (auto _ : state) {
+        TileIndex index;
+        index.load(path);
+        auto tiles = index.query({0, 0, 256, 256});
+        visible = tiles.size();
+        benchmark::DoNotOptimize(tiles);
+    }
+    state.counters["visible"] = static_cast<double>(visible);
+    state.SetLabel(state.range(0) == 0 ? "text" : "binary");
+}
+BENCHMARK(TileIndexLoad)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Main function: correctness checks run first, benchmarks only when they
+// pass
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    if (RUN_ALL_TESTS() != 0) {
+        return 1;
+    }
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+    return 0;
+}
 
 /*
 Real Performance Benchmark Results:
@@ -78,4 +1499,81 @@ Performance Analysis:
 - QuadTree optimization provides ~2.8x speedup (55.8ms → 20.0ms)
 - QuadTree reduces query time by 64.1% compared to linear tile index
 - Higher iteration count for QuadTree (35 vs 14) indicates more stable performance
-*/
\ No newline at end of file
+*/
+/*
+ColorChecker::isUniformColor, fully uniform square region (time per call):
+-------------------------------------------------------------------------------
+side      tol=0 scalar   tol=0 simd    tol=2 scalar   tol=2 simd
+4              23 ns        25 ns          68 ns         32 ns
+16            220 ns       108 ns         739 ns        182 ns
+64           2.4 us       0.6 us         16.6 us        1.0 us
+256         51.4 us       8.4 us        259.5 us       13.7 us
+1024       776.8 us     208.3 us         4.15 ms       0.25 ms
+4096        16.4 ms       8.7 ms         65.7 ms        9.9 ms
+
+- Regions at least 64 px wide use the AVX2 kernel, narrower ones use SSE2.
+- With a colour tolerance the SIMD path is 2x (4x4) to 17x (1024x1024) faster.
+- 4096x4096 (64 MiB) is bound by memory bandwidth rather than compares.
+*/
+/*
+TileCodecDecode, 1000x700 sample map (decoded RGBA MB/s, ratio = raw/encoded):
+-------------------------------------------------------------------------------
+tile set                              png MB/s  png ratio   qoi MB/s  qoi ratio
+quad-tree, min-size 4 (tiny leaves)        9.8      0.43       503      0.75
+fixed 32x32                              194        3.49       688      2.64
+quad-tree, min-size 64, tolerance 4      241        3.66       860      2.65
+
+- QOI decodes 3.5x faster than PNG on 32x32+ tiles for ~30% larger payloads.
+- On tiny leaves PNG's per-file zlib setup dominates (50x slower) and its
+  headers make payloads larger than raw RGBA; QOI's 22-byte overhead does not.
+*/
+/*
+Downsampler::halve, square RGBA noise image (time per call, source GB/s):
+-------------------------------------------------------------------------------
+side        scalar              sse2
+64         12.1 us  1.3 GB/s    6.8 us   2.2 GB/s
+256         208 us  1.2 GB/s    113 us   2.2 GB/s
+1024        3.0 ms  1.3 GB/s    1.6 ms   2.4 GB/s
+4096       50.3 ms  1.2 GB/s   27.3 ms   2.3 GB/s
+
+- Alpha weighting costs one division per colour channel: an integer divide
+  in the scalar path, a packed float divide (4 channels at once) in SSE2.
+- The SSE2 kernel stays 1.8x-1.9x faster and bit-identical to the scalar one.
+*/
+/*
+TileIndexLoad, 1000x700 sample map, quad-tree min-size 4 (54001 tiles),
+load + one 256x256 query (5298 tiles):
+-------------------------------------------------------------------------------
+format       file size      time
+meta.txt       1.70 MB    53.2 ms
+meta.bin       2.68 MB    0.71 ms
+
+- The binary file is mapped, not parsed: load only checks the header and
+  name ranges, and strings are built just for the tiles a query returns.
+- Fixed 32-byte records make meta.bin larger than meta.txt for maps with
+  short file names; pure-colour and deduplicated names are stored once.
+*/
+/*
+SplitCostCalibration, 1000x700 sample map, 361 non-uniform squares of 4-256 px
+(relative-error fits over per-tile read and decode times, page cache warm):
+-------------------------------------------------------------------------------
+codec   tile_us  file_us  byte_ns  pixel_ns  busy_bpp  uniform_bpp
+png        0.6      5.9      0.2      8.9      1.27       0.04
+qoi        0.6      2.7     ~0        4.5      1.75       0.013
+bc1        0.8      2.3     ~0        0.01     0.5        0.5
+bc3        0.8      2.4     ~0        0.05     1.0        1.0
+
+Same squares read from one tiles.pack (file_us only; other columns match):
+png 3.3, qoi 0.2, bc1 0.15, bc3 0.15. Mapped payloads skip the open/read,
+so only the decoder set-up is left (most of it for PNG's zlib state).
+
+- These are the weights of QuadTreeSplitter::CostModel::forCodec. Reads hit
+  the page cache, so byte_ns is near zero; the models keep 0.1-0.2 ns/byte.
+- With --cost-split (800x600 viewport) the default quad-tree split of the
+  1000x700 map (54001 tiles, 4.28 MB of PNG) becomes 112 tiles of at most
+  128x128 (0.75 MB), 292 tiles of at most 64x64 with --pack. Before the
+  merges were weighted by viewport it collapsed to 16 tiles at the 256x256
+  cap. check_main -q per view, whole map / 400x300 / 128x128:
+  uncosted 390 / 124 / 50 ms, 256 cap 75 / 17 / 6 ms, viewport-weighted
+  70 / 16 / 4 ms (94 / 16 / 3 ms packed).
+*/
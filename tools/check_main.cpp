@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "BinaryMeta.hpp"
 #include "QuadTreeIndex.hpp"
 #include "TileIndex.hpp"
 #include "ViewportAssembler.hpp"
@@ -22,6 +23,7 @@ int main(int argc, char** argv) {
     bool enableCache = true;
     bool enableAsync = true;
     bool showStats = false;
+    int lodLevel = 0;
     
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
@@ -60,19 +62,26 @@ int main(int argc, char** argv) {
             enableAsync = false;
         } else if (a == "--stats") {
             showStats = true;
+        } else if (a == "--lod" && i + 1 < argc) {
+            lodLevel = std::stoi(argv[++i]);
         } else if (a == "-h") {
             std::cout
                 << "Usage: check_tool -i <resource_dir> -p posx,posy -s w,h "
-                   "[-q|--quadtree] [-e|--enhanced] [--no-cache] [--no-async] [--stats] [-o <output.png>]\n"
+                   "[-q|--quadtree] [-e|--enhanced] [--no-cache] [--no-async] [--stats] [--lod <level>] [-o <output.png>]\n"
                 << "Options:\n"
                 << "  -e, --enhanced    Use enhanced viewport assembler with caching and async loading\n"
                 << "  --no-cache        Disable tile caching (only with --enhanced)\n"
                 << "  --no-async        Disable async loading (only with --enhanced)\n"
-                << "  --stats           Show cache and loader statistics\n";
+                << "  --stats           Show cache and loader statistics\n"
+                << "  --lod <level>     Render LOD level (1 = half resolution), needs -o\n";
             return 0;
         }
     }
-    std::string meta = resourceDir + "/meta.txt";
+    // Prefer the binary metadata, which is mapped instead of parsed
+    std::string meta = resourceDir + "/" + BinaryMeta::kFileName;
+    if (!std::filesystem::exists(meta)) {
+        meta = resourceDir + "/meta.txt";
+    }
     std::unique_ptr<TileIndex> index;
     if (useQuadTree) {
         index = std::make_unique<QuadTreeIndex>();
@@ -88,6 +97,16 @@ int main(int argc, char** argv) {
     if (internalY < 0) internalY = 0;
     
     Viewport vp{px, internalY, sw, sh};
+
+    if (lodLevel < 0 || lodLevel > index->getLodLevels()) {
+        std::cerr << "LOD level " << lodLevel << " not available (tile set has "
+                  << index->getLodLevels() << " levels)\n";
+        return 1;
+    }
+    if (lodLevel > 0 && (useEnhanced || !outputPNG)) {
+        std::cerr << "--lod is only supported with the basic assembler and -o\n";
+        return 1;
+    }
     
     if (useEnhanced) {
         std::shared_ptr<TileCache> cache = nullptr;
@@ -165,7 +184,7 @@ int main(int argc, char** argv) {
     ViewportAssembler assembler;
     if (outputPNG) {
         std::string png = outFile.empty() ? (resourceDir + "/viewport.png") : outFile;
-        if (!assembler.assemble(*index, vp, resourceDir, png)) {
+        if (!assembler.assemble(*index, vp, resourceDir, png, lodLevel)) {
             std::cerr << "Assemble failed\n";
             return 2;
         }
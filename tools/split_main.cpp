@@ -1,13 +1,29 @@
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "BinaryMeta.hpp"
+#include "EncodeCache.hpp"
+#include "MemoryBudget.hpp"
 #include "QuadTreeSplitter.hpp"
+#include "RawImage.hpp"
+#include "SplitProfile.hpp"
+#include "ThreadPool.hpp"
 #include "TileIndex.hpp"
 #include "TileSplitter.hpp"
+#include "stb_image.h"
 
-// 清空目标文件夹的函数
-bool clearOutputDirectory(const std::string& dirPath) {
+// 清空目标文件夹的函数；quiet 为真时只输出错误
+bool clearOutputDirectory(const std::string& dirPath, bool quiet = false) {
     try {
         if (std::filesystem::exists(dirPath)) {
             if (!std::filesystem::is_directory(dirPath)) {
@@ -17,19 +33,26 @@ bool clearOutputDirectory(const std::string& dirPath) {
             
             // 检查文件夹是否为空
             if (!std::filesystem::is_empty(dirPath)) {
-                std::cout << "Target directory " << dirPath << " is not empty, clearing...\n";
+                if (!quiet) {
+                    std::cout << "Target directory " << dirPath
+                              << " is not empty, clearing...\n";
+                }
                 
                 // 删除文件夹中的所有内容
                 for (const auto& entry : std::filesystem::directory_iterator(dirPath)) {
                     std::filesystem::remove_all(entry.path());
                 }
                 
-                std::cout << "Directory cleared successfully.\n";
+                if (!quiet) {
+                    std::cout << "Directory cleared successfully.\n";
+                }
             }
         } else {
             // 如果目录不存在，创建它
             std::filesystem::create_directories(dirPath);
-            std::cout << "Created output directory: " << dirPath << "\n";
+            if (!quiet) {
+                std::cout << "Created output directory: " << dirPath << "\n";
+            }
         }
         return true;
     } catch (const std::filesystem::filesystem_error& e) {
@@ -41,17 +64,266 @@ bool clearOutputDirectory(const std::string& dirPath) {
     }
 }
 
+// 元数据格式：文本 meta.txt、可映射的二进制 meta.bin，或两者都写
+enum class MetaFormat { Text, Binary, Both };
+
+// 输出目录中默认的元数据路径
+std::string defaultMetaPath(const std::string& dir, MetaFormat format) {
+    return dir + "/" +
+           (format == MetaFormat::Binary ? BinaryMeta::kFileName
+                                         : "meta.txt");
+}
+
+// 按格式写出元数据；两者都写时二进制文件与 meta 同名、扩展名为 .bin
+bool saveMeta(const TileIndex& index, const std::string& meta,
+              MetaFormat format) {
+    if (format == MetaFormat::Binary) {
+        return index.saveBinary(meta);
+    }
+    if (!index.save(meta)) {
+        return false;
+    }
+    std::string binaryMeta =
+        std::filesystem::path(meta).replace_extension(".bin").string();
+    if (format == MetaFormat::Text) {
+        // 加载方优先读取 meta.bin，不能留下上次拆分的旧文件
+        std::error_code ec;
+        std::filesystem::remove(binaryMeta, ec);
+        return true;
+    }
+    return index.saveBinary(binaryMeta);
+}
+
+// 输出编码缓存的命中统计
+void printCacheStats(const EncodeCache* cache) {
+    if (cache) {
+        std::cout << "Encode cache " << cache->getDirectory() << ": "
+                  << cache->getHits() << " hits, " << cache->getMisses()
+                  << " misses\n";
+    }
+}
+
+// 解析 "tile,file,byte,pixel,busy_bpp,uniform_bpp" 形式的代价模型权重
+bool parseCostWeights(const std::string& text,
+                      QuadTreeSplitter::CostModel& model) {
+    double* weights[] = {&model.tileCost,          &model.fileCost,
+                         &model.byteCost,          &model.pixelCost,
+                         &model.busyBytesPerPixel, &model.uniformBytesPerPixel};
+    std::istringstream fields(text);
+    std::string field;
+    for (double* weight : weights) {
+        if (!std::getline(fields, field, ',')) {
+            return false;
+        }
+        try {
+            *weight = std::stod(field);
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return !std::getline(fields, field, ',');
+}
+
+// 批量清单中的一张地图
+struct BatchEntry {
+    std::string input;   // 输入图像
+    std::string outDir;  // 输出目录，元数据写入其中
+    uintmax_t inputBytes = 0;
+};
+
+// 读取批量清单：每行 "<input> <output_dir>"，空行和 # 开头的行忽略
+bool readBatchManifest(const std::string& path,
+                       std::vector<BatchEntry>& entries) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open batch manifest " << path << "\n";
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        BatchEntry entry;
+        if (!(fields >> entry.input) || entry.input[0] == '#') {
+            continue;
+        }
+        std::string extra;
+        if (!(fields >> entry.outDir) || (fields >> extra)) {
+            std::cerr << path << ":" << lineNumber
+                      << ": expected \"<input> <output_dir>\"\n";
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+// 拆分批量清单中的一张地图并写出其元数据，返回瓦片数
+size_t splitBatchEntry(const BatchEntry& entry, bool useQuadTree,
+                       bool incremental, MetaFormat metaFormat,
+                       const QuadTreeSplitter::Config& quadTreeConfig,
+                       const TileWriter::Config& writerConfig, int tileW,
+                       int tileH) {
+    std::string meta = defaultMetaPath(entry.outDir, metaFormat);
+    if (!incremental && !clearOutputDirectory(entry.outDir, true)) {
+        throw std::runtime_error("failed to clear " + entry.outDir);
+    }
+
+    std::vector<TileMeta> tiles;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    if (useQuadTree) {
+        QuadTreeSplitter splitter;
+        tiles = incremental
+                    ? splitter.splitQuadTreeIncremental(
+                          entry.input, entry.outDir, meta, quadTreeConfig)
+                    : splitter.splitQuadTree(entry.input, entry.outDir,
+                                             quadTreeConfig);
+        mapWidth = splitter.getImageWidth();
+        mapHeight = splitter.getImageHeight();
+    } else {
+        TileSplitter splitter;
+        splitter.setWriterConfig(writerConfig);
+        splitter.setTrimTransparent(quadTreeConfig.trimTransparent);
+        splitter.setHilbertOrder(quadTreeConfig.hilbertOrder);
+        tiles = splitter.split(entry.input, entry.outDir, tileW, tileH);
+        mapWidth = splitter.getImageWidth();
+        mapHeight = splitter.getImageHeight();
+    }
+    if (mapWidth == 0 || mapHeight == 0) {
+        throw std::runtime_error("split failed");
+    }
+
+    TileIndex index;
+    index.setCodec(quadTreeConfig.codec);
+    index.setTiles(tiles);
+    index.setMapSize(mapWidth, mapHeight);
+    if (!saveMeta(index, meta, metaFormat)) {
+        throw std::runtime_error("failed to save " + meta);
+    }
+    return tiles.size();
+}
+
+// 在一个进程内拆分清单中的全部地图。所有地图共用一个线程池和一份内存
+// 预算：每张地图解码前先从预算中占用整幅 RGBA 图像的大小，编码中的瓦片
+// 缓冲也从同一预算中占用。地图按输入文件从大到小开始处理，大图的串行
+// 阶段留下的空闲由其后的小图填补。
+int runBatch(std::vector<BatchEntry> entries, bool useQuadTree,
+             bool incremental, MetaFormat metaFormat,
+             QuadTreeSplitter::Config quadTreeConfig, int tileW, int tileH) {
+    for (auto& entry : entries) {
+        std::error_code ec;
+        entry.inputBytes = std::filesystem::file_size(entry.input, ec);
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const BatchEntry& a, const BatchEntry& b) {
+                         return a.inputBytes > b.inputBytes;
+                     });
+
+    ThreadPool pool(ThreadPool::resolveThreadCount(quadTreeConfig.numThreads));
+    MemoryBudget budget(quadTreeConfig.maxInFlightBytes);
+    quadTreeConfig.pool = &pool;
+    quadTreeConfig.memoryBudget = &budget;
+    quadTreeConfig.verbosity = 0;
+
+    TileWriter::Config writerConfig;
+    writerConfig.packOutput = quadTreeConfig.packOutput;
+    writerConfig.codec = quadTreeConfig.codec;
+    writerConfig.dedupContent = quadTreeConfig.dedupContent;
+    writerConfig.pool = &pool;
+    writerConfig.memoryBudget = &budget;
+    writerConfig.encodeCache = quadTreeConfig.encodeCache;
+    writerConfig.paletteTiles = quadTreeConfig.paletteTiles;
+    writerConfig.reduceChannels = quadTreeConfig.reduceChannels;
+    writerConfig.rleTiles = quadTreeConfig.rleTiles;
+
+    std::cout << "Batch split: " << entries.size() << " maps, "
+              << pool.size() << " threads, "
+              << budget.getLimit() / (1024 * 1024) << " MB budget\n";
+
+    // 每张地图由一个驱动线程串起解码、建树和写出；驱动线程只等待线程池中
+    // 的任务，不占用线程池的工作线程，因此不会相互等待而死锁
+    std::atomic<size_t> next{0};
+    std::mutex outputMutex;
+    size_t done = 0;
+    size_t failed = 0;
+    size_t totalTiles = 0;
+    auto drive = [&] {
+        for (size_t k = next++; k < entries.size(); k = next++) {
+            const BatchEntry& entry = entries[k];
+            std::string error;
+            size_t tileCount = 0;
+            int width = 0;
+            int height = 0;
+            int channels = 0;
+            if (!stbi_info(entry.input.c_str(), &width, &height, &channels)) {
+                error = std::string("cannot read image: ") +
+                        (stbi_failure_reason() ? stbi_failure_reason() : "");
+            } else {
+                size_t imageBytes = static_cast<size_t>(width) * height * 4;
+                budget.acquire(imageBytes);
+                try {
+                    tileCount = splitBatchEntry(
+                        entry, useQuadTree, incremental, metaFormat,
+                        quadTreeConfig, writerConfig, tileW, tileH);
+                } catch (const std::exception& e) {
+                    error = e.what();
+                }
+                budget.release(imageBytes);
+            }
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            ++done;
+            std::cout << "[" << done << "/" << entries.size() << "] "
+                      << entry.input << " -> " << entry.outDir << ": ";
+            if (error.empty()) {
+                totalTiles += tileCount;
+                std::cout << tileCount << " tiles\n";
+            } else {
+                ++failed;
+                std::cout << "FAILED (" << error << ")\n";
+            }
+        }
+    };
+
+    size_t numDrivers =
+        std::min(entries.size(), static_cast<size_t>(pool.size()));
+    std::vector<std::thread> drivers;
+    for (size_t i = 0; i < numDrivers; ++i) {
+        drivers.emplace_back(drive);
+    }
+    for (auto& driver : drivers) {
+        driver.join();
+    }
+
+    std::cout << "Batch completed: " << entries.size() - failed << "/"
+              << entries.size() << " maps, " << totalTiles
+              << " tiles. Peak budget use: "
+              << budget.getPeak() / (1024 * 1024) << " MB\n";
+    printCacheStats(quadTreeConfig.encodeCache);
+    return failed == 0 ? 0 : 2;
+}
+
 int main(int argc, char** argv) {
     std::string input;
     std::string outDir = "data/tiles";  // default output dir
     int tileW = 32,
         tileH = 32;    // default tile size (kept for backward compatibility)
     std::string meta;  // will derive: <outDir>/meta.txt
+    MetaFormat metaFormat = MetaFormat::Text;
 
     // 四叉树分割参数
     bool useQuadTree = false;
     QuadTreeSplitter::Config quadTreeConfig;
     bool compareMode = false;  // 对比模式
+    bool streamMode = false;   // 流式拆分（输入为原始 RGBA 图像）
+    bool incremental = false;  // 只重新编码与上次分割相比变化的区域
+    std::string exportRaw;     // 将输入转换为原始 RGBA 图像后退出
+    std::string profilePath;   // 分阶段性能统计的 JSON 输出文件
+    std::string batchPath;     // 批量拆分清单
+    std::string cacheDir;      // 编码结果的磁盘缓存目录
+    bool costWeights = false;  // 代价模型权重由命令行给出
 
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
@@ -68,6 +340,19 @@ int main(int argc, char** argv) {
             }
         } else if (a == "--meta" && i + 1 < argc) {
             meta = argv[++i];
+        } else if (a == "--meta-format" && i + 1 < argc) {
+            std::string v = argv[++i];
+            if (v == "text") {
+                metaFormat = MetaFormat::Text;
+            } else if (v == "binary") {
+                metaFormat = MetaFormat::Binary;
+            } else if (v == "both") {
+                metaFormat = MetaFormat::Both;
+            } else {
+                std::cerr << "Unknown meta format: " << v
+                          << " (expected text, binary or both)\n";
+                return 1;
+            }
         } else if (a == "--quadtree") {
             useQuadTree = true;
         } else if (a == "--max-depth" && i + 1 < argc) {
@@ -76,8 +361,93 @@ int main(int argc, char** argv) {
             quadTreeConfig.minTileSize = std::stoi(argv[++i]);
         } else if (a == "--color-tolerance" && i + 1 < argc) {
             quadTreeConfig.colorTolerance = std::stoi(argv[++i]);
+        } else if (a == "--lossy-max-error" && i + 1 < argc) {
+            quadTreeConfig.lossyMaxError = std::stoi(argv[++i]);
+        } else if (a == "--lossy-psnr" && i + 1 < argc) {
+            quadTreeConfig.lossyMinPsnr = std::stod(argv[++i]);
+        } else if (a == "--max-inflight-mb" && i + 1 < argc) {
+            quadTreeConfig.maxInFlightBytes =
+                static_cast<size_t>(std::stoul(argv[++i])) * 1024 * 1024;
+        } else if (a == "--pyramid") {
+            quadTreeConfig.buildMode = QuadTreeSplitter::BuildMode::Pyramid;
+        } else if (a == "--threads" && i + 1 < argc) {
+            quadTreeConfig.numThreads = std::stoi(argv[++i]);
+        } else if (a == "--codec" && i + 1 < argc) {
+            if (!TileCodec::fromName(argv[++i], quadTreeConfig.codec)) {
+                std::cerr << "Unknown codec: " << argv[i]
+                          << " (expected png, qoi, bc1 or bc3)\n";
+                return 1;
+            }
+        } else if (a == "--pack") {
+            quadTreeConfig.packOutput = true;
+        } else if (a == "--dedup") {
+            quadTreeConfig.dedupContent = true;
+        } else if (a == "--transparent-alpha" && i + 1 < argc) {
+            quadTreeConfig.transparentAlpha = std::stoi(argv[++i]);
+        } else if (a == "--hilbert") {
+            quadTreeConfig.hilbertOrder = true;
+        } else if (a == "--palette") {
+            quadTreeConfig.paletteTiles = true;
+        } else if (a == "--reduce-channels") {
+            quadTreeConfig.reduceChannels = true;
+        } else if (a == "--rle") {
+            quadTreeConfig.rleTiles = true;
+        } else if (a == "--cost-split") {
+            quadTreeConfig.costSplit = true;
+        } else if (a == "--cost-weights" && i + 1 < argc) {
+            if (!parseCostWeights(argv[++i], quadTreeConfig.costModel)) {
+                std::cerr << "Invalid cost weights: " << argv[i]
+                          << " (expected six comma-separated numbers)\n";
+                return 1;
+            }
+            costWeights = true;
+        } else if (a == "--cost-max-tile" && i + 1 < argc) {
+            quadTreeConfig.costModel.maxTileSize = std::stoi(argv[++i]);
+        } else if (a == "--cost-viewport" && i + 1 < argc) {
+            std::string v = argv[++i];
+            auto pos = v.find('x');
+            int width = 0, height = 0;
+            if (pos != std::string::npos) {
+                width = std::stoi(v.substr(0, pos));
+                height = std::stoi(v.substr(pos + 1));
+            }
+            if (width <= 0 || height <= 0) {
+                std::cerr << "Invalid cost viewport: " << v
+                          << " (expected WxH)\n";
+                return 1;
+            }
+            quadTreeConfig.costModel.viewportWidth = width;
+            quadTreeConfig.costModel.viewportHeight = height;
+        } else if (a == "--trim") {
+            quadTreeConfig.trimTransparent = true;
+        } else if (a == "--merge-uniform") {
+            quadTreeConfig.mergeUniform = true;
+        } else if (a == "--atlas" && i + 1 < argc) {
+            quadTreeConfig.atlasMaxTileSize = std::stoi(argv[++i]);
+        } else if (a == "--atlas-page" && i + 1 < argc) {
+            quadTreeConfig.atlasPageSize = std::stoi(argv[++i]);
+        } else if (a == "--lod" && i + 1 < argc) {
+            quadTreeConfig.lodLevels = std::stoi(argv[++i]);
+        } else if (a == "--lod-tile" && i + 1 < argc) {
+            quadTreeConfig.lodTileSize = std::stoi(argv[++i]);
+        } else if (a == "--incremental") {
+            incremental = true;
+        } else if (a == "--stream") {
+            streamMode = true;
+        } else if (a == "--strip-height" && i + 1 < argc) {
+            quadTreeConfig.stripHeight = std::stoi(argv[++i]);
+        } else if (a == "--export-raw" && i + 1 < argc) {
+            exportRaw = argv[++i];
         } else if (a == "--compare") {
             compareMode = true;
+        } else if (a == "--profile" && i + 1 < argc) {
+            profilePath = argv[++i];
+        } else if (a == "--verbosity" && i + 1 < argc) {
+            quadTreeConfig.verbosity = std::stoi(argv[++i]);
+        } else if (a == "--batch" && i + 1 < argc) {
+            batchPath = argv[++i];
+        } else if (a == "--cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
         } else if (a == "-h") {
             std::cout << "Usage: split_tool -i <input_map.png> -o <output_dir> "
                          "[options]\n";
@@ -91,24 +461,217 @@ int main(int argc, char** argv) {
                 << "  --min-size <size>       Minimum tile size (default: 4)\n";
             std::cout << "  --color-tolerance <tol> Color comparison tolerance "
                          "(default: 0)\n";
+            std::cout << "  --transparent-alpha <a> Treat pixels with alpha "
+                         "<= a as equal and drop fully\n"
+                         "                          transparent leaves "
+                         "(default: off)\n";
+            std::cout << "  --lossy-max-error <e>   Use a node's mean color "
+                         "if no channel is off by more than e\n";
+            std::cout << "  --lossy-psnr <db>       Use a node's mean color "
+                         "if its PSNR is at least db\n";
+            std::cout << "  --threads <n>           Build/encode threads, "
+                         "0 = all cores (default: 1)\n";
+            std::cout << "  --max-inflight-mb <mb>  Memory budget for tiles "
+                         "being encoded (default: 256)\n";
+            std::cout << "  --pyramid               Build the quad-tree "
+                         "bottom-up from a min/max pyramid\n";
+            std::cout << "  --codec <name>          Tile codec: png, qoi "
+                         "(decodes faster), or bc1/bc3\n"
+                         "                          (GPU block compression, "
+                         "kept compressed when loaded)\n"
+                         "                          (default: png)\n";
+            std::cout << "  --pack                  Write tiles into a single "
+                         "tiles.pack instead of PNG files\n";
+            std::cout << "  --dedup                 Write identical tiles "
+                         "once, shared by all their entries\n";
+            std::cout << "  --hilbert               Order metadata and "
+                         "payloads along a Hilbert curve\n";
+            std::cout << "  --palette               Store tiles with at most "
+                         "16 colors as palette + indices (.pal)\n";
+            std::cout << "  --reduce-channels       Store opaque, gray and "
+                         "alpha-mask tiles with only\n"
+                         "                          the channels they use "
+                         "(.chn, png codec only)\n";
+            std::cout << "  --rle                   Store tiles with few "
+                         "same-color runs per row as runs (.rle)\n";
+            std::cout << "  --cost-split            Keep a node as one tile "
+                         "when that is estimated to load\n"
+                         "                          faster than its "
+                         "children (weights calibrated per codec)\n";
+            std::cout << "  --cost-weights <w>      Cost model weights "
+                         "tile,file,byte,pixel,busy_bpp,\n"
+                         "                          uniform_bpp (us per "
+                         "tile/file/byte/pixel, bytes per pixel)\n";
+            std::cout << "  --cost-max-tile <size>  Largest node "
+                         "--cost-split keeps whole (default: 256)\n";
+            std::cout << "  --cost-viewport <WxH>   Viewport size "
+                         "--cost-split optimises loading for\n"
+                         "                          (default: 800x600)\n";
+            std::cout << "  --trim                  Crop tiles to their "
+                         "non-transparent pixels\n";
+            std::cout << "  --merge-uniform         Merge adjacent same-color "
+                         "leaves into larger rectangles\n";
+            std::cout << "  --atlas <size>          Pack quad-tree leaves up "
+                         "to size x size into atlas pages\n";
+            std::cout << "  --atlas-page <size>     Atlas page width and "
+                         "height (default: 1024)\n";
+            std::cout << "  --lod <levels>          Also write 1/2, 1/4, ... "
+                         "resolution tiles for zoomed-out views\n";
+            std::cout << "  --lod-tile <size>       Target LOD tile size in "
+                         "reduced pixels (default: 256)\n";
+            std::cout << "  --incremental           Re-split only regions "
+                         "changed since the last --incremental\n"
+                         "                          split into <output_dir>\n";
+            std::cout << "  --stream                Stream a raw RGBA input "
+                         "in strips (bounded memory)\n";
+            std::cout << "  --strip-height <rows>   Rows read per strip in "
+                         "stream mode (default: 256)\n";
+            std::cout << "  --export-raw <file>     Convert the input to raw "
+                         "RGBA for --stream and exit\n";
             std::cout
                 << "  --compare               Generate both fixed-size and "
                    "quad-tree results\n";
+            std::cout << "  --profile <file.json>   Write per-phase timings, "
+                         "bytes and leaf statistics as JSON\n";
+            std::cout << "  --verbosity <0-2>       0 errors only, 1 "
+                         "summaries, 2 every pure color tile (default: 1)\n";
+            std::cout << "  --batch <manifest>      Split every \"<input> "
+                         "<output_dir>\" line of manifest in\n"
+                         "                          one process; "
+                         "--threads and --max-inflight-mb\n"
+                         "                          are shared by all maps "
+                         "and their decoded images\n";
+            std::cout << "  --cache <dir>           Reuse encoded tiles whose "
+                         "pixels and codec match a previous run\n";
             std::cout << "  --tile <WxH>            Fixed tile size (default: "
                          "32x32)\n";
             std::cout << "  --meta <file>           Meta file path (default: "
                          "<output_dir>/meta.txt)\n";
+            std::cout << "  --meta-format <fmt>     text, binary (meta.bin, "
+                         "mapped by loaders) or both\n"
+                         "                          (default: text)\n";
             return 0;
         }
     }
+    if (!costWeights) {
+        // 默认权重按所选编码和输出方式标定，保留命令行给出的尺寸上限和视口
+        QuadTreeSplitter::CostModel model =
+            QuadTreeSplitter::CostModel::forCodec(quadTreeConfig.codec,
+                                                  quadTreeConfig.packOutput);
+        model.maxTileSize = quadTreeConfig.costModel.maxTileSize;
+        model.viewportWidth = quadTreeConfig.costModel.viewportWidth;
+        model.viewportHeight = quadTreeConfig.costModel.viewportHeight;
+        quadTreeConfig.costModel = model;
+    }
+    if (quadTreeConfig.reduceChannels &&
+        quadTreeConfig.codec != TileCodec::Type::Png) {
+        std::cerr << "--reduce-channels stores PNG planes and needs "
+                     "--codec png.\n";
+        return 1;
+    }
+    std::unique_ptr<EncodeCache> encodeCache;
+    if (!cacheDir.empty()) {
+        encodeCache = std::make_unique<EncodeCache>(cacheDir);
+        quadTreeConfig.encodeCache = encodeCache.get();
+    }
+    if (!batchPath.empty()) {
+        if (!input.empty() || compareMode || streamMode ||
+            !exportRaw.empty() || !profilePath.empty()) {
+            std::cerr << "--batch reads inputs from the manifest and cannot "
+                         "be combined with -i, --compare, --stream, "
+                         "--export-raw or --profile.\n";
+            return 1;
+        }
+        if (incremental && (!useQuadTree || quadTreeConfig.packOutput ||
+                            quadTreeConfig.atlasMaxTileSize > 0 ||
+                            quadTreeConfig.lodLevels > 0 ||
+                            quadTreeConfig.mergeUniform ||
+                            quadTreeConfig.costSplit)) {
+            std::cerr << "--incremental needs --quadtree and cannot be "
+                         "combined with --pack, --atlas, --lod,\n"
+                         "--merge-uniform or --cost-split.\n";
+            return 1;
+        }
+        std::vector<BatchEntry> entries;
+        if (!readBatchManifest(batchPath, entries)) {
+            return 1;
+        }
+        return runBatch(entries, useQuadTree, incremental, metaFormat,
+                        quadTreeConfig, tileW, tileH);
+    }
     if (input.empty()) {
         std::cerr << "Input PNG map required (-i).\n";
         return 1;
     }
-    if (meta.empty()) meta = outDir + "/meta.txt";
+    if (!exportRaw.empty()) {
+        if (!RawImageReader::convert(input, exportRaw)) {
+            std::cerr << "Failed to convert " << input << " to raw RGBA\n";
+            return 2;
+        }
+        std::cout << "Raw RGBA image written: " << exportRaw << "\n";
+        return 0;
+    }
+    if (streamMode && !RawImageReader::isRawImage(input)) {
+        std::cerr << "Stream mode requires raw RGBA input; convert it first "
+                     "with --export-raw.\n";
+        return 1;
+    }
+    if (streamMode && quadTreeConfig.atlasMaxTileSize > 0) {
+        std::cerr << "--atlas needs the whole image and cannot be combined "
+                     "with --stream.\n";
+        return 1;
+    }
+    if (streamMode && quadTreeConfig.lodLevels > 0) {
+        std::cerr << "--lod needs the whole image and cannot be combined "
+                     "with --stream.\n";
+        return 1;
+    }
+    if (streamMode && (quadTreeConfig.lossyMaxError > 0 ||
+                       quadTreeConfig.lossyMinPsnr > 0.0)) {
+        std::cerr << "Lossy coarsening needs the whole image and cannot be "
+                     "combined with --stream.\n";
+        return 1;
+    }
+    if (incremental && (!useQuadTree || compareMode || streamMode ||
+                        quadTreeConfig.packOutput ||
+                        quadTreeConfig.atlasMaxTileSize > 0 ||
+                        quadTreeConfig.lodLevels > 0 ||
+                        quadTreeConfig.mergeUniform ||
+                        quadTreeConfig.costSplit)) {
+        std::cerr << "--incremental needs --quadtree and cannot be combined "
+                     "with --compare, --stream, --pack, --atlas, --lod,\n"
+                     "--merge-uniform or --cost-split.\n";
+        return 1;
+    }
+    if (compareMode && !profilePath.empty()) {
+        std::cerr << "--profile reports a single split and cannot be "
+                     "combined with --compare.\n";
+        return 1;
+    }
+    if (meta.empty()) meta = defaultMetaPath(outDir, metaFormat);
+
+    SplitProfile profile;
+    if (!profilePath.empty()) {
+        quadTreeConfig.profile = &profile;
+    }
+
+    // 固定尺寸分割与四叉树分割共用编码线程数和内存预算
+    TileWriter::Config writerConfig;
+    writerConfig.numThreads = quadTreeConfig.numThreads;
+    writerConfig.maxInFlightBytes = quadTreeConfig.maxInFlightBytes;
+    writerConfig.packOutput = quadTreeConfig.packOutput;
+    writerConfig.codec = quadTreeConfig.codec;
+    writerConfig.dedupContent = quadTreeConfig.dedupContent;
+    writerConfig.profile = quadTreeConfig.profile;
+    writerConfig.encodeCache = quadTreeConfig.encodeCache;
+    writerConfig.paletteTiles = quadTreeConfig.paletteTiles;
+    writerConfig.reduceChannels = quadTreeConfig.reduceChannels;
+    writerConfig.rleTiles = quadTreeConfig.rleTiles;
 
     try {
         std::vector<TileMeta> tiles;
+        int mapWidth = 0;
+        int mapHeight = 0;
 
         if (compareMode) {
             // 对比模式：生成两种分割结果
@@ -118,7 +681,7 @@ int main(int argc, char** argv) {
 
             // 固定尺寸分割
             std::string fixedOutDir = outDir + "_fixed";
-            std::string fixedMeta = fixedOutDir + "/meta.txt";
+            std::string fixedMeta = defaultMetaPath(fixedOutDir, metaFormat);
             
             // 清空固定尺寸输出目录
             if (!clearOutputDirectory(fixedOutDir)) {
@@ -127,11 +690,21 @@ int main(int argc, char** argv) {
             }
             
             TileSplitter fixedSplitter;
+            fixedSplitter.setWriterConfig(writerConfig);
+            fixedSplitter.setTrimTransparent(quadTreeConfig.trimTransparent);
+            fixedSplitter.setHilbertOrder(quadTreeConfig.hilbertOrder);
             auto fixedTiles =
-                fixedSplitter.split(input, fixedOutDir, tileW, tileH);
+                streamMode ? fixedSplitter.splitStreaming(
+                                 input, fixedOutDir, tileW, tileH,
+                                 quadTreeConfig.stripHeight)
+                           : fixedSplitter.split(input, fixedOutDir, tileW,
+                                                 tileH);
             TileIndex fixedIndex;
+            fixedIndex.setCodec(quadTreeConfig.codec);
             fixedIndex.setTiles(fixedTiles);
-            if (!fixedIndex.save(fixedMeta)) {
+            fixedIndex.setMapSize(fixedSplitter.getImageWidth(),
+                                  fixedSplitter.getImageHeight());
+            if (!saveMeta(fixedIndex, fixedMeta, metaFormat)) {
                 std::cerr << "Failed to save fixed meta\n";
                 return 2;
             }
@@ -140,7 +713,7 @@ int main(int argc, char** argv) {
 
             // 四叉树分割
             std::string quadOutDir = outDir + "_quadtree";
-            std::string quadMeta = quadOutDir + "/meta.txt";
+            std::string quadMeta = defaultMetaPath(quadOutDir, metaFormat);
             
             // 清空四叉树输出目录
             if (!clearOutputDirectory(quadOutDir)) {
@@ -150,10 +723,16 @@ int main(int argc, char** argv) {
             
             QuadTreeSplitter quadSplitter;
             auto quadTiles =
-                quadSplitter.splitQuadTree(input, quadOutDir, quadTreeConfig);
+                streamMode ? quadSplitter.splitQuadTreeStreaming(
+                                 input, quadOutDir, quadTreeConfig)
+                           : quadSplitter.splitQuadTree(input, quadOutDir,
+                                                        quadTreeConfig);
             TileIndex quadIndex;
+            quadIndex.setCodec(quadTreeConfig.codec);
             quadIndex.setTiles(quadTiles);
-            if (!quadIndex.save(quadMeta)) {
+            quadIndex.setMapSize(quadSplitter.getImageWidth(),
+                                 quadSplitter.getImageHeight());
+            if (!saveMeta(quadIndex, quadMeta, metaFormat)) {
                 std::cerr << "Failed to save quad-tree meta\n";
                 return 2;
             }
@@ -176,15 +755,44 @@ int main(int argc, char** argv) {
                       << "\n";
             std::cout << "  Color tolerance: " << quadTreeConfig.colorTolerance
                       << "\n";
+            if (quadTreeConfig.lossyMaxError > 0) {
+                std::cout << "  Lossy max error: "
+                          << quadTreeConfig.lossyMaxError << "\n";
+            }
+            if (quadTreeConfig.lossyMinPsnr > 0.0) {
+                std::cout << "  Lossy min PSNR: "
+                          << quadTreeConfig.lossyMinPsnr << " dB\n";
+            }
+            std::cout << "  Threads: " << quadTreeConfig.numThreads << "\n";
+            std::cout << "  Build mode: "
+                      << (quadTreeConfig.buildMode ==
+                                  QuadTreeSplitter::BuildMode::Pyramid
+                              ? "pyramid"
+                              : "top-down")
+                      << "\n";
+            if (streamMode) {
+                std::cout << "  Strip height: " << quadTreeConfig.stripHeight
+                          << "\n";
+            }
 
-            // 清空输出目录
-            if (!clearOutputDirectory(outDir)) {
+            // 清空输出目录；增量模式沿用其中上次的结果
+            if (!incremental && !clearOutputDirectory(outDir)) {
                 std::cerr << "Failed to clear output directory\n";
                 return 2;
             }
 
             QuadTreeSplitter splitter;
-            tiles = splitter.splitQuadTree(input, outDir, quadTreeConfig);
+            if (incremental) {
+                tiles = splitter.splitQuadTreeIncremental(input, outDir, meta,
+                                                          quadTreeConfig);
+            } else {
+                tiles = streamMode ? splitter.splitQuadTreeStreaming(
+                                         input, outDir, quadTreeConfig)
+                                   : splitter.splitQuadTree(input, outDir,
+                                                            quadTreeConfig);
+            }
+            mapWidth = splitter.getImageWidth();
+            mapHeight = splitter.getImageHeight();
         } else {
             // 传统固定尺寸分割模式
             std::cout << "Using fixed-size splitting: " << tileW << "x" << tileH
@@ -197,19 +805,47 @@ int main(int argc, char** argv) {
             }
             
             TileSplitter splitter;
-            tiles = splitter.split(input, outDir, tileW, tileH);
+            splitter.setWriterConfig(writerConfig);
+            splitter.setTrimTransparent(quadTreeConfig.trimTransparent);
+            splitter.setHilbertOrder(quadTreeConfig.hilbertOrder);
+            tiles = streamMode
+                        ? splitter.splitStreaming(input, outDir, tileW, tileH,
+                                                  quadTreeConfig.stripHeight)
+                        : splitter.split(input, outDir, tileW, tileH);
+            mapWidth = splitter.getImageWidth();
+            mapHeight = splitter.getImageHeight();
         }
 
         if (!compareMode) {
             TileIndex index;
+            index.setCodec(quadTreeConfig.codec);
             index.setTiles(tiles);
-            if (!index.save(meta)) {
-                std::cerr << "Failed to save meta\n";
-                return 2;
+            index.setMapSize(mapWidth, mapHeight);
+            {
+                SplitProfile::Timer timer(quadTreeConfig.profile,
+                                          SplitProfile::Phase::Write);
+                if (!saveMeta(index, meta, metaFormat)) {
+                    std::cerr << "Failed to save meta\n";
+                    return 2;
+                }
+                std::error_code ec;
+                auto metaBytes = std::filesystem::file_size(meta, ec);
+                timer.setBytes(ec ? 0 : metaBytes);
             }
             std::cout << "Split completed: " << tiles.size()
                       << " tiles. Meta: " << meta << "\n";
         }
+        printCacheStats(quadTreeConfig.encodeCache);
+
+        if (!profilePath.empty()) {
+            profile.setTileCount(tiles.size());
+            if (!profile.writeJson(profilePath)) {
+                std::cerr << "Failed to write profile " << profilePath
+                          << "\n";
+                return 2;
+            }
+            std::cout << "Profile written: " << profilePath << "\n";
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";